@@ -382,7 +382,10 @@ void Client::updateInputWindow()
     }
 
     if (region.isEmpty()) {
-        m_decoInputExtent.reset();
+        if (m_decoInputExtent.isValid()) {
+            workspace()->removeWindowId(m_decoInputExtent, this);
+            m_decoInputExtent.reset();
+        }
         return;
     }
 
@@ -405,6 +408,9 @@ void Client::updateInputWindow()
             XCB_EVENT_MASK_POINTER_MOTION
         };
         m_decoInputExtent.create(bounds, XCB_WINDOW_CLASS_INPUT_ONLY, mask, values);
+        // a client which is still being managed gets its windows registered by Workspace::addClient()
+        if (workspace()->findClientByWindowId(window()) == this)
+            workspace()->addWindowId(m_decoInputExtent, this, Workspace::InputWindowId);
         if (mapping_state == Mapped)
             m_decoInputExtent.map();
     } else {
@@ -499,7 +505,10 @@ void Client::destroyDecoration()
             emit geometryShapeChanged(this, oldgeom);
         }
     }
-    m_decoInputExtent.reset();
+    if (m_decoInputExtent.isValid()) {
+        workspace()->removeWindowId(m_decoInputExtent, this);
+        m_decoInputExtent.reset();
+    }
 }
 
 bool Client::checkBorderSizes(bool also_resize)
@@ -1974,17 +1983,26 @@ void Client::setClientShown(bool shown)
 
 void Client::getWMHints()
 {
-    XWMHints* hints = XGetWMHints(display(), window());
+    Xcb::Property hints(window(), XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 0, 9);
+    getWMHints(hints);
+}
+
+void Client::getWMHints(Xcb::Property &property)
+{
+    // WM_HINTS are the 32 bit values flags, input, initial state, icon pixmap, icon window,
+    // icon x, icon y, icon mask and window group. Pre ICCCM clients don't set the window group.
+    uint32_t count = 0;
+    const uint32_t *hints = static_cast<const uint32_t*>(property.value(XCB_ATOM_WM_HINTS, 32, &count));
     input = true;
     m_windowGroup = XCB_WINDOW_NONE;
     urgency = false;
-    if (hints) {
-        if (hints->flags & InputHint)
-            input = hints->input;
-        if (hints->flags & WindowGroupHint)
-            m_windowGroup = hints->window_group;
-        urgency = !!(hints->flags & UrgencyHint);   // Need boolean, it's a uint bitfield
-        XFree((char*)hints);
+    if (hints && count >= 8) {
+        const uint32_t flags = hints[0];
+        if (flags & InputHint)
+            input = hints[1];
+        if ((flags & WindowGroupHint) && count >= 9)
+            m_windowGroup = hints[8];
+        urgency = !!(flags & UrgencyHint);   // Need boolean, it's a uint bitfield
     }
     checkGroup();
     updateUrgency();
@@ -1992,9 +2010,15 @@ void Client::getWMHints()
 }
 
 void Client::getMotifHints()
+{
+    Xcb::Property hints(m_client, atoms->motif_wm_hints, atoms->motif_wm_hints, 0, 5);
+    getMotifHints(hints);
+}
+
+void Client::getMotifHints(Xcb::Property &hints)
 {
     bool mgot_noborder, mnoborder, mresize, mmove, mminimize, mmaximize, mclose;
-    Motif::readFlags(m_client, mgot_noborder, mnoborder, mresize, mmove, mminimize, mmaximize, mclose);
+    Motif::readFlags(hints, mgot_noborder, mnoborder, mresize, mmove, mminimize, mmaximize, mclose);
     if (mgot_noborder && motif_noborder != mnoborder) {
         motif_noborder = mnoborder;
         // If we just got a hint telling us to hide decorations, we do so.
@@ -2049,6 +2073,15 @@ void Client::readIcons(xcb_window_t win, QPixmap* icon, QPixmap* miniicon, QPixm
 
 void Client::getIcons()
 {
+    // The _NET_WM_ICON data got already read by NETWinInfo, it is only decoded when an icon
+    // is requested in a specific size, see cachedIcon()
+    const NETIcon netIcon = info->icon();
+    m_iconKey = IconKey(resourceClass(), QSize(netIcon.size.width, netIcon.size.height), netIcon.data);
+    if (m_iconKey.isValid()) {
+        icon_pix = miniicon_pix = bigicon_pix = hugeicon_pix = QPixmap();
+        emit iconChanged();
+        return;
+    }
     // First read icons from the window itself
     readIcons(window(), &icon_pix, &miniicon_pix, &bigicon_pix, &hugeicon_pix);
     if (icon_pix.isNull()) {
@@ -2080,6 +2113,29 @@ void Client::getIcons()
     emit iconChanged();
 }
 
+QPixmap Client::cachedIcon(int size, bool scale, const QPixmap &fallback) const
+{
+    if (!m_iconKey.isValid() || !IconCache::self()) {
+        return fallback;
+    }
+    QPixmap pixmap = IconCache::self()->icon(m_iconKey, size);
+    if (!pixmap.isNull()) {
+        return pixmap;
+    }
+    // Same as KWindowSystem::icon(): use the best matching size and scale it if requested
+    const NETIcon netIcon = info->icon(size, size);
+    if (!netIcon.data) {
+        return fallback;
+    }
+    QImage image(netIcon.data, netIcon.size.width, netIcon.size.height, QImage::Format_ARGB32);
+    if (scale && image.size() != QSize(size, size)) {
+        image = image.scaled(size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+    pixmap = QPixmap::fromImage(image);
+    IconCache::self()->insert(m_iconKey, size, pixmap);
+    return pixmap;
+}
+
 QPixmap Client::icon(const QSize& size) const
 {
     const int iconSize = qMin(size.width(), size.height());
@@ -2095,30 +2151,31 @@ QPixmap Client::icon(const QSize& size) const
 
 void Client::getWindowProtocols()
 {
-    Atom* p;
-    int i, n;
+    Xcb::Property protocols(window(), atoms->wm_protocols, XCB_ATOM_ATOM, 0, 2048);
+    getWindowProtocols(protocols);
+}
 
+void Client::getWindowProtocols(Xcb::Property &protocols)
+{
     Pdeletewindow = 0;
     Ptakefocus = 0;
     Ptakeactivity = 0;
     Pcontexthelp = 0;
     Pping = 0;
 
-    if (XGetWMProtocols(display(), window(), &p, &n)) {
-        for (i = 0; i < n; ++i) {
-            if (p[i] == atoms->wm_delete_window)
-                Pdeletewindow = 1;
-            else if (p[i] == atoms->wm_take_focus)
-                Ptakefocus = 1;
-            else if (p[i] == atoms->net_wm_take_activity)
-                Ptakeactivity = 1;
-            else if (p[i] == atoms->net_wm_context_help)
-                Pcontexthelp = 1;
-            else if (p[i] == atoms->net_wm_ping)
-                Pping = 1;
-        }
-        if (n > 0)
-            XFree(p);
+    uint32_t n = 0;
+    const xcb_atom_t *p = static_cast<const xcb_atom_t*>(protocols.value(XCB_ATOM_ATOM, 32, &n));
+    for (uint32_t i = 0; i < n; ++i) {
+        if (p[i] == atoms->wm_delete_window)
+            Pdeletewindow = 1;
+        else if (p[i] == atoms->wm_take_focus)
+            Ptakefocus = 1;
+        else if (p[i] == atoms->net_wm_take_activity)
+            Ptakeactivity = 1;
+        else if (p[i] == atoms->net_wm_context_help)
+            Pcontexthelp = 1;
+        else if (p[i] == atoms->net_wm_ping)
+            Pping = 1;
     }
 }
 
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define KWIN_CLIENT_H
 
 // kwin
+#include "iconcache.h"
 #include "options.h"
 #include "rules.h"
 #include "tabgroup.h"
@@ -772,7 +773,9 @@ private:
     int checkFullScreenHack(const QRect& geom) const;   // 0 - None, 1 - One xinerama screen, 2 - Full area
     void updateFullScreenHack(const QRect& geom);
     void getWmNormalHints();
+    void getWmNormalHints(Xcb::Property &hints);
     void getMotifHints();
+    void getMotifHints(Xcb::Property &hints);
     void getIcons();
     void fetchName();
     void fetchIconicName();
@@ -869,6 +872,7 @@ private:
     int quick_tile_mode;
 
     void readTransient();
+    void readTransient(Xcb::TransientFor &transientFor);
     xcb_window_t verifyTransientFor(xcb_window_t transient_for, bool set);
     void addTransient(Client* cl);
     void removeTransient(Client* cl);
@@ -911,8 +915,17 @@ private:
     bool blocks_compositing;
     WindowRules client_rules;
     void getWMHints();
+    void getWMHints(Xcb::Property &hints);
+    /**
+     * Returns the icon of the given @p size decoded from the _NET_WM_ICON data, going through
+     * the shared IconCache. If the window has no _NET_WM_ICON, @p fallback is returned, which
+     * got read by getIcons().
+     **/
+    QPixmap cachedIcon(int size, bool scale, const QPixmap &fallback) const;
     void readIcons();
     void getWindowProtocols();
+    void getWindowProtocols(Xcb::Property &protocols);
+    IconKey m_iconKey;
     QPixmap icon_pix;
     QPixmap miniicon_pix;
     QPixmap bigicon_pix;
@@ -1104,22 +1117,22 @@ inline ShadeMode Client::shadeMode() const
 
 inline QPixmap Client::icon() const
 {
-    return icon_pix;
+    return cachedIcon(32, true, icon_pix);
 }
 
 inline QPixmap Client::miniIcon() const
 {
-    return miniicon_pix;
+    return cachedIcon(16, true, miniicon_pix);
 }
 
 inline QPixmap Client::bigIcon() const
 {
-    return bigicon_pix;
+    return cachedIcon(64, false, bigicon_pix);
 }
 
 inline QPixmap Client::hugeIcon() const
 {
-    return hugeicon_pix;
+    return cachedIcon(128, false, hugeicon_pix);
 }
 
 inline QRect Client::geometryRestore() const
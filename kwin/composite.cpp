@@ -29,6 +29,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "unmanaged.h"
 #include "deleted.h"
 #include "effects.h"
+#include "lanczosfilter.h"
 #include "overlaywindow.h"
 #include "scene.h"
 #include "scene_xrender.h"
@@ -43,6 +44,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QtConcurrentRun>
 #include <QFutureWatcher>
 #include <QMenu>
+#include <QThread>
 #include <QTimerEvent>
 #include <QDateTime>
 #include <QDBusConnection>
@@ -89,6 +91,8 @@ Compositor::Compositor(QObject* workspace)
     , m_finishing(false)
     , m_timeSinceLastVBlank(0)
     , m_scene(NULL)
+    , m_recordStatistics(false)
+    , m_statisticsRoundTrips(0)
 {
     qRegisterMetaType<Compositor::SuspendReason>("Compositor::SuspendReason");
     new CompositingAdaptor(this);
@@ -309,6 +313,7 @@ void Compositor::finish()
     m_scene = NULL;
     compositeTimer.stop();
     repaints_region = QRegion();
+    m_repaintQueue.clear();
     for (ClientList::ConstIterator it = Workspace::self()->clientList().constBegin();
             it != Workspace::self()->clientList().constEnd();
             ++it) {
@@ -505,6 +510,26 @@ void Compositor::setCompositing(bool active)
     }
 }
 
+void Compositor::resetStatistics()
+{
+    m_recordStatistics = true;
+    m_frameTimes.clear();
+    m_statisticsRoundTrips = Xcb::roundTrips();
+}
+
+QVariantMap Compositor::statistics() const
+{
+    QVariantList frameTimes;
+    foreach (qint64 time, m_frameTimes) {
+        frameTimes << time;
+    }
+    QVariantMap statistics;
+    statistics.insert("frames", m_frameTimes.count());
+    statistics.insert("frameTimes", frameTimes);
+    statistics.insert("roundTrips", Xcb::roundTrips() - m_statisticsRoundTrips);
+    return statistics;
+}
+
 void Compositor::restart()
 {
     if (hasScene()) {
@@ -517,24 +542,37 @@ void Compositor::addRepaint(int x, int y, int w, int h)
 {
     if (!hasScene())
         return;
-    repaints_region += QRegion(x, y, w, h);
-    scheduleRepaint();
+    postRepaint(QRect(x, y, w, h));
 }
 
 void Compositor::addRepaint(const QRect& r)
 {
     if (!hasScene())
         return;
-    repaints_region += r;
-    scheduleRepaint();
+    postRepaint(r);
 }
 
 void Compositor::addRepaint(const QRegion& r)
 {
     if (!hasScene())
         return;
-    repaints_region += r;
-    scheduleRepaint();
+    foreach (const QRect &rect, r.rects()) {
+        postRepaint(rect);
+    }
+}
+
+void Compositor::postRepaint(const QRect &rect)
+{
+    if (rect.isEmpty() || !m_repaintQueue.post(rect)) {
+        // the frame has already been scheduled by the first posted rect. If none could be
+        // scheduled, setCompositeTimer() emptied the queue and this post would have woken us.
+        return;
+    }
+    if (QThread::currentThread() == thread()) {
+        scheduleRepaint();
+    } else {
+        QMetaObject::invokeMethod(this, "scheduleRepaint", Qt::QueuedConnection);
+    }
 }
 
 void Compositor::addRepaintFull()
@@ -556,9 +594,18 @@ void Compositor::timerEvent(QTimerEvent *te)
 
 void Compositor::performCompositing()
 {
+    foreach (const QRect &rect, m_repaintQueue.take()) {
+        repaints_region += rect;
+    }
+
     if (!isOverlayWindowVisible())
         return; // nothing is visible anyway
 
+    QElapsedTimer frameTimer;
+    if (m_recordStatistics) {
+        frameTimer.start();
+    }
+
     // Create a list of all windows in the stacking order
     ToplevelList windows = Workspace::self()->xStackingOrder();
     ToplevelList damaged;
@@ -582,16 +629,12 @@ void Compositor::performCompositing()
 
     // Get the replies
     foreach (Toplevel *win, damaged) {
-        // Discard the cached lanczos texture
+        win->getDamageRegionReply();
+
+        // Mark the damaged area as stale in the cached lanczos texture
         if (win->effectWindow()) {
-            const QVariant texture = win->effectWindow()->data(LanczosCacheRole);
-            if (texture.isValid()) {
-                delete static_cast<GLTexture *>(texture.value<void*>());
-                win->effectWindow()->setData(LanczosCacheRole, QVariant());
-            }
+            LanczosCacheEntry::addDamage(win->effectWindow(), win->damage());
         }
-
-        win->getDamageRegionReply();
     }
 
     if (repaints_region.isEmpty() && !windowRepaintsPending()) {
@@ -617,6 +660,11 @@ void Compositor::performCompositing()
 
     m_timeSinceLastVBlank = m_scene->paint(repaints, windows);
 
+    // a benchmark reads the statistics regularly, the limit only protects against a forgotten one
+    if (m_recordStatistics && m_frameTimes.count() < 100000) {
+        m_frameTimes << frameTimer.nsecsElapsed() / 1000;
+    }
+
     // Trigger at least one more pass even if there would be nothing to paint, so that scene->idle()
     // is called the next time. If there would be nothing pending, it will not restart the timer and
     // scheduleRepaint() would restart it again somewhen later, called from functions that
@@ -648,8 +696,11 @@ void Compositor::setCompositeResetTimer(int msecs)
 
 void Compositor::setCompositeTimer()
 {
-    if (!hasScene())  // should not really happen, but there may be e.g. some damage events still pending
+    if (!hasScene()) { // should not really happen, but there may be e.g. some damage events still pending
+        // Nothing will take the posted repaints, drop them so that the next post wakes us up again
+        m_repaintQueue.clear();
         return;
+    }
 
     uint waitTime = 1;
 
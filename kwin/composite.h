@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define KWIN_COMPOSITE_H
 // KWin
 #include <kwinglobals.h>
+#include "repaintqueue.h"
 // KDE
 #include <KDE/KSelectionOwner>
 // Qt
@@ -31,6 +32,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QTimer>
 #include <QBasicTimer>
 #include <QRegion>
+#include <QVariantMap>
+#include <QVector>
 
 namespace KWin {
 
@@ -88,6 +91,12 @@ public:
     void addRepaint(const QRect& r);
     void addRepaint(const QRegion& r);
     void addRepaint(int x, int y, int w, int h);
+    /**
+     * Requests a repaint of @p rect with the next frame. Unlike addRepaint this method can be
+     * called from any thread, e.g. by threads rendering decorations or thumbnails. It does not
+     * take a lock and only wakes up the Compositor for the first rect posted since the last frame.
+     **/
+    void postRepaint(const QRect &rect);
     /**
      * Whether the Compositor is active. That is a Scene is present and the Compositor is
      * not shutting down itself.
@@ -221,6 +230,24 @@ public Q_SLOTS:
     // NOTICE this is atm. for script usage *ONLY* and needs to be extended like resume / suspend are
     // if intended to be used from within KWin code!
     Q_SCRIPTABLE void setCompositing(bool active);
+    /**
+     * @brief Starts recording the statistics returned by @link statistics.
+     *
+     * Statistics are only recorded after this method got called once, each call discards
+     * the statistics recorded so far.
+     **/
+    Q_SCRIPTABLE void resetStatistics();
+    /**
+     * @brief The statistics recorded since the last call of @link resetStatistics.
+     *
+     * The map contains:
+     * @li @c frames The number of painted frames
+     * @li @c frameTimes The time needed to paint each frame in microseconds
+     * @li @c roundTrips The number of round trips to the X server
+     *
+     * Used by the compositing benchmark in the tests directory.
+     **/
+    Q_SCRIPTABLE QVariantMap statistics() const;
     /**
      * Actual slot to perform the toggling compositing.
      * That is if the Compositor is suspended it will be resumed and if the Compositor is active
@@ -295,6 +322,8 @@ private:
     int m_xrrRefreshRate;
     QElapsedTimer nextPaintReference;
     QRegion repaints_region;
+    // rects posted since the last frame, merged into repaints_region when painting
+    RepaintQueue m_repaintQueue;
 
     QTimer unredirectTimer;
     bool forceUnredirectCheck;
@@ -304,6 +333,10 @@ private:
     qint64 m_timeSinceLastVBlank;
     Scene *m_scene;
 
+    bool m_recordStatistics;
+    QVector<qint64> m_frameTimes;
+    quint64 m_statisticsRoundTrips; // round trips at the last reset
+
     KWIN_SINGLETON_VARIABLE(Compositor, s_compositor)
 };
 }
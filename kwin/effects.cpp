@@ -30,6 +30,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "client.h"
 #include "cursor.h"
 #include "group.h"
+#include "lanczosfilter.h"
 #include "scene_xrender.h"
 #include "scene_opengl.h"
 #include "unmanaged.h"
@@ -1642,11 +1643,7 @@ EffectWindowImpl::EffectWindowImpl(Toplevel *toplevel)
 
 EffectWindowImpl::~EffectWindowImpl()
 {
-    QVariant cachedTextureVariant = data(LanczosCacheRole);
-    if (cachedTextureVariant.isValid()) {
-        GLTexture *cachedTexture = static_cast< GLTexture*>(cachedTextureVariant.value<void*>());
-        delete cachedTexture;
-    }
+    delete LanczosCacheEntry::fromWindow(this);
 }
 
 bool EffectWindowImpl::isPaintingEnabled()
@@ -27,6 +27,7 @@
 
 #include <QMatrix4x4>
 #include <QLinkedList>
+#include <qmath.h>
 #include <KDebug>
 
 namespace KWin
@@ -37,6 +38,7 @@ KWIN_EFFECT_SUPPORTED(blur, BlurEffect::supported())
 KWIN_EFFECT_ENABLEDBYDEFAULT(blur, BlurEffect::enabledByDefault())
 
 BlurEffect::BlurEffect()
+    : m_dualFilter(NULL)
 {
     shader = BlurShader::create();
 
@@ -72,6 +74,7 @@ BlurEffect::~BlurEffect()
 {
     windows.clear();
 
+    delete m_dualFilter;
     delete shader;
     delete target;
 }
@@ -90,6 +93,29 @@ void BlurEffect::reconfigure(ReconfigureFlags flags)
     if (shader)
         shader->setRadius(radius);
 
+    delete m_dualFilter;
+    m_dualFilter = NULL;
+    m_downsampleTextures.clear();
+    if (BlurConfig::downsampleBlur() && shader && shader->isValid() && GLSLDualFilterShader::supported()) {
+        m_dualFilter = new GLSLDualFilterShader();
+        if (m_dualFilter->isValid()) {
+            for (int i = 1; i <= 2; i++) {
+                GLTexture texture(displayWidth() >> i, displayHeight() >> i);
+                texture.setFilter(GL_LINEAR);
+                texture.setWrapMode(GL_CLAMP_TO_EDGE);
+                m_downsampleTextures << texture;
+            }
+        } else {
+            delete m_dualFilter;
+            m_dualFilter = NULL;
+        }
+    }
+
+    // The dual filter reaches further than the gaussian kernel: each of the four
+    // passes adds the sample offset plus the footprint of the linear filtering.
+    m_dualFilterOffset = radius / 7.0;
+    m_expandSize = m_dualFilter ? qCeil(6 * m_dualFilterOffset) + 8 : radius;
+
     m_shouldCache = BlurConfig::cacheTexture();
 
     windows.clear();
@@ -182,8 +208,7 @@ bool BlurEffect::supported()
 
 QRect BlurEffect::expand(const QRect &rect) const
 {
-    const int radius = shader->radius();
-    return rect.adjusted(-radius, -radius, radius, radius);
+    return rect.adjusted(-m_expandSize, -m_expandSize, m_expandSize, m_expandSize);
 }
 
 QRegion BlurEffect::expand(const QRegion &region) const
@@ -246,13 +271,15 @@ void BlurEffect::uploadRegion(QVector2D *&map, const QRegion &region)
     }
 }
 
-void BlurEffect::uploadGeometry(GLVertexBuffer *vbo, const QRegion &horizontal, const QRegion &vertical)
+void BlurEffect::uploadGeometry(GLVertexBuffer *vbo, const QRegion &horizontal, const QRegion &vertical,
+                                const QRegion &extra)
 {
-    const int vertexCount = (horizontal.rectCount() + vertical.rectCount()) * 6;
+    const int vertexCount = (horizontal.rectCount() + vertical.rectCount() + extra.rectCount()) * 6;
 
     QVector2D *map = (QVector2D *) vbo->map(vertexCount * sizeof(QVector2D));
     uploadRegion(map, horizontal);
     uploadRegion(map, vertical);
+    uploadRegion(map, extra);
     vbo->unmap();
 
     const GLVertexAttrib layout[] = {
@@ -288,7 +315,7 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
     // to blur an area partially we have to shrink the opaque area of a window
     QRegion newClip;
     const QRegion oldClip = data.clip;
-    const int radius = shader->radius();
+    const int radius = m_expandSize;
     foreach (const QRect& rect, data.clip.rects()) {
         newClip |= rect.adjusted(radius,radius,-radius,-radius);
     }
@@ -310,7 +337,10 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
     const QRegion expandedBlur = expand(blurArea) & screen;
 
     if (m_shouldCache) {
-        // we are caching the horizontally blurred background texture
+        // we are caching the horizontally blurred background texture, or the
+        // first level of the dual filter
+        const QRect cache = cacheRect(expandedBlur.boundingRect());
+        const QSize cacheSize = m_dualFilter ? cache.size() / 2 : cache.size();
 
         // if a window underneath the blurred area is damaged we have to
         // update the cached texture
@@ -318,7 +348,7 @@ void BlurEffect::prePaintWindow(EffectWindow* w, WindowPrePaintData& data, int t
         CacheEntry it = windows.find(w);
         if (it != windows.end() && !it->dropCache &&
             it->windowPos == w->pos() &&
-            it->blurredBackground.size() == expandedBlur.boundingRect().size()) {
+            it->blurredBackground.size() == cacheSize) {
             damagedCache = (expand(expandedBlur & m_damagedArea) |
                             (it->damagedRegion & data.paint)) & expandedBlur;
         } else {
@@ -416,7 +446,9 @@ void BlurEffect::drawWindow(EffectWindow *w, int mask, QRegion region, WindowPai
         }
 
         if (!shape.isEmpty()) {
-            if (m_shouldCache && !translated) {
+            if (m_shouldCache && !translated && m_dualFilter) {
+                doCachedDownsampledBlur(w, region, data.opacity());
+            } else if (m_shouldCache && !translated) {
                 doCachedBlur(w, region, data.opacity());
             } else {
                 doBlur(shape, screen, data.opacity());
@@ -441,6 +473,11 @@ void BlurEffect::paintEffectFrame(EffectFrame *frame, QRegion region, double opa
 
 void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float opacity)
 {
+    if (m_dualFilter) {
+        doDownsampledBlur(shape, screen, opacity);
+        return;
+    }
+
     const QRegion expanded = expand(shape) & screen;
     const QRect r = expanded.boundingRect();
 
@@ -527,6 +564,90 @@ void BlurEffect::doBlur(const QRegion& shape, const QRect& screen, const float o
     shader->unbind();
 }
 
+void BlurEffect::doDownsampledBlur(const QRegion& shape, const QRect& screen, const float opacity)
+{
+    const QRegion expanded = expand(shape) & screen;
+    const QRect r = expanded.boundingRect();
+
+    // Copy the area in the back buffer that we're going to blur into the offscreen
+    // texture. It keeps its screen position, so all passes can work in screen coordinates.
+    tex.bind();
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, r.x(), displayHeight() - r.y() - r.height(),
+                        r.x(), displayHeight() - r.y() - r.height(), r.width(), r.height());
+    tex.unbind();
+
+    // Upload geometry for the offscreen and the final pass
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    uploadGeometry(vbo, expanded, shape);
+    vbo->bindArrays();
+
+    // All textures cover the whole screen, so the same texture matrix transforms
+    // from screen coordinates to texture coordinates for each of them.
+    QMatrix4x4 textureMatrix;
+    textureMatrix.scale(1.0 / displayWidth(), -1.0 / displayHeight(), 1);
+    textureMatrix.translate(0, -displayHeight(), 0);
+
+    const int expandedCount = expanded.rectCount() * 6;
+    const float offset = m_dualFilterOffset * 0.5;
+
+    // Scale the background down, each pass into a texture of half the size
+    m_dualFilter->bind(GLSLDualFilterShader::Downsample);
+    m_dualFilter->setTextureMatrix(textureMatrix);
+    GLTexture *source = &tex;
+    for (int i = 0; i < m_downsampleTextures.count(); i++) {
+        GLTexture *destination = &m_downsampleTextures[i];
+        target->attachTexture(*destination);
+        GLRenderTarget::pushRenderTarget(target);
+
+        source->bind();
+        m_dualFilter->setOffset(QVector2D(offset / destination->width(), offset / destination->height()));
+        vbo->draw(GL_TRIANGLES, 0, expandedCount);
+        source->unbind();
+
+        GLRenderTarget::popRenderTarget();
+        source = destination;
+    }
+    m_dualFilter->unbind();
+
+    // And up again until we are back at the first level
+    m_dualFilter->bind(GLSLDualFilterShader::Upsample);
+    m_dualFilter->setTextureMatrix(textureMatrix);
+    for (int i = m_downsampleTextures.count() - 2; i >= 0; i--) {
+        GLTexture *destination = &m_downsampleTextures[i];
+        target->attachTexture(*destination);
+        GLRenderTarget::pushRenderTarget(target);
+
+        source->bind();
+        m_dualFilter->setOffset(QVector2D(offset / destination->width(), offset / destination->height()));
+        vbo->draw(GL_TRIANGLES, 0, expandedCount);
+        source->unbind();
+
+        GLRenderTarget::popRenderTarget();
+        source = destination;
+    }
+
+    // Finally draw the blurred background to the backbuffer, clipped to the window shape.
+    source->bind();
+    m_dualFilter->setOffset(QVector2D(offset / displayWidth(), offset / displayHeight()));
+
+    // Modulate the blurred texture with the window opacity if the window isn't opaque
+    if (opacity < 1.0) {
+        glEnable(GL_BLEND);
+        glBlendColor(0, 0, 0, opacity);
+        glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    }
+
+    vbo->draw(GL_TRIANGLES, expandedCount, shape.rectCount() * 6);
+    vbo->unbindArrays();
+
+    if (opacity < 1.0) {
+        glDisable(GL_BLEND);
+    }
+
+    source->unbind();
+    m_dualFilter->unbind();
+}
+
 void BlurEffect::doCachedBlur(EffectWindow *w, const QRegion& region, const float opacity)
 {
     const QRect screen(0, 0, displayWidth(), displayHeight());
@@ -716,6 +837,177 @@ void BlurEffect::doCachedBlur(EffectWindow *w, const QRegion& region, const floa
     shader->unbind();
 }
 
+QRect BlurEffect::cacheRect(const QRect &rect) const
+{
+    if (!m_dualFilter)
+        return rect;
+
+    // The cache of the dual filter has half the resolution of the screen. Its texels
+    // have to line up with the ones of the downsample textures, so it starts and
+    // ends at even screen coordinates.
+    const int left = rect.x() & ~1;
+    const int top = rect.y() & ~1;
+    const int right = (rect.x() + rect.width() + 1) & ~1;
+    const int bottom = (rect.y() + rect.height() + 1) & ~1;
+    return QRect(left, top, right - left, bottom - top);
+}
+
+void BlurEffect::doCachedDownsampledBlur(EffectWindow *w, const QRegion& region, const float opacity)
+{
+    const QRect screen(0, 0, displayWidth(), displayHeight());
+    const QRegion blurredRegion = blurRegion(w).translated(w->pos()) & screen;
+    const QRegion expanded = expand(blurredRegion) & screen;
+    const QRect cache = cacheRect(expanded.boundingRect());
+
+    CacheEntry it = windows.find(w);
+    if (it == windows.end()) {
+        BlurWindowInfo bwi;
+        bwi.blurredBackground = GLTexture(cache.width() / 2, cache.height() / 2);
+        bwi.damagedRegion = expanded;
+        bwi.dropCache = false;
+        bwi.windowPos = w->pos();
+        it = windows.insert(w, bwi);
+    } else if (it->blurredBackground.size() != cache.size() / 2) {
+        it->blurredBackground = GLTexture(cache.width() / 2, cache.height() / 2);
+        it->dropCache = false;
+        it->windowPos = w->pos();
+    } else if (it->windowPos != w->pos()) {
+        it->dropCache = false;
+        it->windowPos = w->pos();
+    }
+
+    GLTexture cacheTexture = it->blurredBackground;
+    cacheTexture.setFilter(GL_LINEAR);
+    cacheTexture.setWrapMode(GL_CLAMP_TO_EDGE);
+
+    // The same part of the cache can be updated as in doCachedBlur(). The cache keeps
+    // the result of the last upsample pass, so only the damaged texels go through the
+    // whole filter, and all others only through the final pass to the backbuffer.
+    const QRegion damagedRegion = it->damagedRegion;
+    const QRegion updateBackground = damagedRegion & region;
+    const QRegion validUpdate = damagedRegion - expand(damagedRegion - region);
+
+    // A texel of the cache covers two by two pixels, all of which are updated together
+    QRegion update;
+    if (!validUpdate.isEmpty()) {
+        foreach (const QRect &rect, (updateBackground & screen).rects())
+            update += cacheRect(rect);
+        update &= cache;
+    }
+    const QRegion expandedUpdate = expand(update) & expanded;
+    const QRegion vertical = blurredRegion & region;
+
+    const int expandedCount = expandedUpdate.rectCount() * 6;
+    const int updateOffset = expandedCount;
+    const int updateCount = update.rectCount() * 6;
+    const int verticalOffset = updateOffset + updateCount;
+    const int verticalCount = vertical.rectCount() * 6;
+
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    uploadGeometry(vbo, expandedUpdate, update, vertical);
+    vbo->bindArrays();
+
+    const float offset = m_dualFilterOffset * 0.5;
+
+    if (!update.isEmpty()) {
+        const QRect updateRect = expandedUpdate.boundingRect();
+
+        // Copy the background the update depends on into the offscreen texture,
+        // at its screen position like in doDownsampledBlur()
+        tex.bind();
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, updateRect.x(), displayHeight() - updateRect.y() - updateRect.height(),
+                            updateRect.x(), displayHeight() - updateRect.y() - updateRect.height(),
+                            updateRect.width(), updateRect.height());
+        tex.unbind();
+
+        QMatrix4x4 textureMatrix;
+        textureMatrix.scale(1.0 / displayWidth(), -1.0 / displayHeight(), 1);
+        textureMatrix.translate(0, -displayHeight(), 0);
+
+        // Scale the background down, each pass into a texture of half the size
+        m_dualFilter->bind(GLSLDualFilterShader::Downsample);
+        m_dualFilter->setTextureMatrix(textureMatrix);
+        GLTexture *source = &tex;
+        for (int i = 0; i < m_downsampleTextures.count(); i++) {
+            GLTexture *destination = &m_downsampleTextures[i];
+            target->attachTexture(*destination);
+            GLRenderTarget::pushRenderTarget(target);
+
+            source->bind();
+            m_dualFilter->setOffset(QVector2D(offset / destination->width(), offset / destination->height()));
+            vbo->draw(GL_TRIANGLES, 0, expandedCount);
+            source->unbind();
+
+            GLRenderTarget::popRenderTarget();
+            source = destination;
+        }
+        m_dualFilter->unbind();
+
+        // And up again, the pass to the first level goes into the cache instead
+        m_dualFilter->bind(GLSLDualFilterShader::Upsample);
+        m_dualFilter->setTextureMatrix(textureMatrix);
+        for (int i = m_downsampleTextures.count() - 2; i >= 0; i--) {
+            const GLTexture *level = &m_downsampleTextures[i];
+            GLTexture *destination = i == 0 ? &cacheTexture : &m_downsampleTextures[i];
+            target->attachTexture(*destination);
+            GLRenderTarget::pushRenderTarget(target);
+
+            source->bind();
+            m_dualFilter->setOffset(QVector2D(offset / level->width(), offset / level->height()));
+            if (i == 0) {
+                QMatrix4x4 modelViewProjectionMatrix;
+                modelViewProjectionMatrix.ortho(0, cache.width(), cache.height(), 0, 0, 65535);
+                modelViewProjectionMatrix.translate(-cache.x(), -cache.y(), 0);
+                m_dualFilter->setModelViewProjectionMatrix(modelViewProjectionMatrix);
+                vbo->draw(GL_TRIANGLES, updateOffset, updateCount);
+            } else {
+                vbo->draw(GL_TRIANGLES, 0, expandedCount);
+            }
+            source->unbind();
+
+            GLRenderTarget::popRenderTarget();
+            source = destination;
+        }
+
+        QMatrix4x4 modelViewProjectionMatrix;
+        modelViewProjectionMatrix.ortho(0, displayWidth(), displayHeight(), 0, 0, 65535);
+        m_dualFilter->setModelViewProjectionMatrix(modelViewProjectionMatrix);
+        m_dualFilter->unbind();
+
+        // mark the updated region as valid
+        it->damagedRegion -= validUpdate;
+    }
+
+    // Finally draw the cache to the backbuffer, clipped to the window shape
+    m_dualFilter->bind(GLSLDualFilterShader::Upsample);
+    cacheTexture.bind();
+
+    // Set up the texture matrix to transform from screen coordinates
+    // to the texture coordinates of the cache.
+    QMatrix4x4 textureMatrix;
+    textureMatrix.scale(1.0 / cache.width(), -1.0 / cache.height(), 1);
+    textureMatrix.translate(-cache.x(), -cache.height() - cache.y(), 0);
+    m_dualFilter->setTextureMatrix(textureMatrix);
+    m_dualFilter->setOffset(QVector2D(offset / cache.width(), offset / cache.height()));
+
+    // Modulate the blurred texture with the window opacity if the window isn't opaque
+    if (opacity < 1.0) {
+        glEnable(GL_BLEND);
+        glBlendColor(0, 0, 0, opacity);
+        glBlendFunc(GL_CONSTANT_ALPHA, GL_ONE_MINUS_CONSTANT_ALPHA);
+    }
+
+    vbo->draw(GL_TRIANGLES, verticalOffset, verticalCount);
+    vbo->unbindArrays();
+
+    if (opacity < 1.0) {
+        glDisable(GL_BLEND);
+    }
+
+    cacheTexture.unbind();
+    m_dualFilter->unbind();
+}
+
 int BlurEffect::blurRadius() const
 {
     if (!shader) {
@@ -31,6 +31,7 @@ namespace KWin
 {
 
 class BlurShader;
+class GLSLDualFilterShader;
 
 class BlurEffect : public KWin::Effect
 {
@@ -70,9 +71,13 @@ private:
     bool shouldBlur(const EffectWindow *w, int mask, const WindowPaintData &data) const;
     void updateBlurRegion(EffectWindow *w) const;
     void doBlur(const QRegion &shape, const QRect &screen, const float opacity);
+    void doDownsampledBlur(const QRegion &shape, const QRect &screen, const float opacity);
     void doCachedBlur(EffectWindow *w, const QRegion& region, const float opacity);
+    void doCachedDownsampledBlur(EffectWindow *w, const QRegion& region, const float opacity);
+    QRect cacheRect(const QRect &rect) const;
     void uploadRegion(QVector2D *&map, const QRegion &region);
-    void uploadGeometry(GLVertexBuffer *vbo, const QRegion &horizontal, const QRegion &vertical);
+    void uploadGeometry(GLVertexBuffer *vbo, const QRegion &horizontal, const QRegion &vertical,
+                        const QRegion &extra = QRegion());
 
 private:
     BlurShader *shader;
@@ -83,9 +88,14 @@ private:
     QRegion m_paintedArea; // actually painted area which is greater than m_damagedArea
     QRegion m_currentBlur; // keeps track of the currently blured area of non-caching windows(from bottom to top)
     bool m_shouldCache;
+    GLSLDualFilterShader *m_dualFilter; // only set if the downsampled blur is used
+    QList<GLTexture> m_downsampleTextures; // textures of half, quarter, ... the screen size
+    float m_dualFilterOffset;
+    int m_expandSize; // how far the blur reaches outside of the blurred area
 
     struct BlurWindowInfo {
-        GLTexture blurredBackground; // keeps the horizontally blurred background
+        GLTexture blurredBackground; // keeps the horizontally blurred background, or the
+                                     // first level of the dual filter at half the size
         QRegion damagedRegion;
         QPoint windowPos;
         bool dropCache;
@@ -336,6 +336,174 @@ void GLSLBlurShader::init()
 
 
 
+// ----------------------------------------------------------------------------
+
+
+
+GLSLDualFilterShader::GLSLDualFilterShader()
+    : mPass(Downsample), mValid(false)
+{
+    shader[Downsample] = shader[Upsample] = NULL;
+    init();
+}
+
+GLSLDualFilterShader::~GLSLDualFilterShader()
+{
+    delete shader[Downsample];
+    delete shader[Upsample];
+}
+
+bool GLSLDualFilterShader::supported()
+{
+    return GLSLBlurShader::supported();
+}
+
+void GLSLDualFilterShader::bind(Pass pass)
+{
+    if (!isValid())
+        return;
+
+    mPass = pass;
+    ShaderManager::instance()->pushShader(shader[pass]);
+}
+
+void GLSLDualFilterShader::unbind()
+{
+    ShaderManager::instance()->popShader();
+}
+
+void GLSLDualFilterShader::setOffset(const QVector2D &offset)
+{
+    if (!isValid())
+        return;
+
+    shader[mPass]->setUniform(offsetLocation[mPass], offset);
+}
+
+void GLSLDualFilterShader::setTextureMatrix(const QMatrix4x4 &matrix)
+{
+    if (!isValid())
+        return;
+
+    shader[mPass]->setUniform(textureMatrixLocation[mPass], matrix);
+}
+
+void GLSLDualFilterShader::setModelViewProjectionMatrix(const QMatrix4x4 &matrix)
+{
+    if (!isValid())
+        return;
+
+    shader[mPass]->setUniform(mvpMatrixLocation[mPass], matrix);
+}
+
+void GLSLDualFilterShader::init()
+{
+#ifdef KWIN_HAVE_OPENGLES
+    const bool glsl_140 = false;
+#else
+    const bool glsl_140 = GLPlatform::instance()->glslVersion() >= kVersionNumber(1, 40);
+#endif
+
+    const QByteArray attribute   = glsl_140 ? "in"                : "attribute";
+    const QByteArray varying_in  = glsl_140 ? "noperspective in"  : "varying";
+    const QByteArray varying_out = glsl_140 ? "noperspective out" : "varying";
+    const QByteArray texture2D   = glsl_140 ? "texture"           : "texture2D";
+    const QByteArray fragColor   = glsl_140 ? "fragColor"         : "gl_FragColor";
+
+    // Vertex shader, shared by both passes
+    // ===================================================================
+    QByteArray vertexSource;
+    QTextStream stream(&vertexSource);
+
+    if (glsl_140)
+        stream << "#version 140\n\n";
+
+    stream << "uniform mat4 modelViewProjectionMatrix;\n";
+    stream << "uniform mat4 textureMatrix;\n\n";
+    stream << attribute << " vec4 vertex;\n\n";
+    stream << varying_out << " vec2 uv;\n";
+    stream << "\n";
+    stream << "void main(void)\n";
+    stream << "{\n";
+    stream << "    uv = vec4(textureMatrix * vertex).st;\n";
+    stream << "    gl_Position = modelViewProjectionMatrix * vertex;\n";
+    stream << "}\n";
+    stream.flush();
+
+    // Fragment shaders
+    // ===================================================================
+    QByteArray header;
+    QTextStream stream2(&header);
+
+    if (glsl_140)
+        stream2 << "#version 140\n\n";
+
+    stream2 << "uniform sampler2D texUnit;\n";
+    stream2 << "uniform vec2 offset;\n\n";
+    stream2 << varying_in << " vec2 uv;\n\n";
+    if (glsl_140)
+        stream2 << "out vec4 fragColor;\n\n";
+    stream2.flush();
+
+    // The downsample pass weights the center four times and the four diagonal neighbours once
+    QByteArray downsampleSource;
+    QTextStream stream3(&downsampleSource);
+    stream3 << header;
+    stream3 << "void main(void)\n";
+    stream3 << "{\n";
+    stream3 << "    vec4 sum = " << texture2D << "(texUnit, uv) * 4.0;\n";
+    stream3 << "    sum += " << texture2D << "(texUnit, uv - offset);\n";
+    stream3 << "    sum += " << texture2D << "(texUnit, uv + offset);\n";
+    stream3 << "    sum += " << texture2D << "(texUnit, uv + vec2(offset.x, -offset.y));\n";
+    stream3 << "    sum += " << texture2D << "(texUnit, uv - vec2(offset.x, -offset.y));\n";
+    stream3 << "    " << fragColor << " = sum / 8.0;\n";
+    stream3 << "}\n";
+    stream3.flush();
+
+    // The upsample pass samples a ring of eight texels around the current one
+    QByteArray upsampleSource;
+    QTextStream stream4(&upsampleSource);
+    stream4 << header;
+    stream4 << "void main(void)\n";
+    stream4 << "{\n";
+    stream4 << "    vec4 sum = " << texture2D << "(texUnit, uv + vec2(-offset.x * 2.0, 0.0));\n";
+    stream4 << "    sum += " << texture2D << "(texUnit, uv + vec2(-offset.x, offset.y)) * 2.0;\n";
+    stream4 << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, offset.y * 2.0));\n";
+    stream4 << "    sum += " << texture2D << "(texUnit, uv + vec2(offset.x, offset.y)) * 2.0;\n";
+    stream4 << "    sum += " << texture2D << "(texUnit, uv + vec2(offset.x * 2.0, 0.0));\n";
+    stream4 << "    sum += " << texture2D << "(texUnit, uv + vec2(offset.x, -offset.y)) * 2.0;\n";
+    stream4 << "    sum += " << texture2D << "(texUnit, uv + vec2(0.0, -offset.y * 2.0));\n";
+    stream4 << "    sum += " << texture2D << "(texUnit, uv + vec2(-offset.x, -offset.y)) * 2.0;\n";
+    stream4 << "    " << fragColor << " = sum / 12.0;\n";
+    stream4 << "}\n";
+    stream4.flush();
+
+    shader[Downsample] = ShaderManager::instance()->loadShaderFromCode(vertexSource, downsampleSource);
+    shader[Upsample] = ShaderManager::instance()->loadShaderFromCode(vertexSource, upsampleSource);
+
+    mValid = shader[Downsample]->isValid() && shader[Upsample]->isValid();
+    if (!mValid)
+        return;
+
+    // Every texture used by the passes covers the whole screen, the viewport of the
+    // render target takes care of the scaling.
+    QMatrix4x4 modelViewProjection;
+    modelViewProjection.ortho(0, displayWidth(), displayHeight(), 0, 0, 65535);
+    for (int i = Downsample; i <= Upsample; i++) {
+        offsetLocation[i]        = shader[i]->uniformLocation("offset");
+        textureMatrixLocation[i] = shader[i]->uniformLocation("textureMatrix");
+        mvpMatrixLocation[i]     = shader[i]->uniformLocation("modelViewProjectionMatrix");
+
+        ShaderManager::instance()->pushShader(shader[i]);
+        shader[i]->setUniform(textureMatrixLocation[i], QMatrix4x4());
+        shader[i]->setUniform(mvpMatrixLocation[i], modelViewProjection);
+        shader[i]->setUniform(shader[i]->uniformLocation("texUnit"), 0);
+        ShaderManager::instance()->popShader();
+    }
+}
+
+
+
 // ----------------------------------------------------------------------------
 
 
@@ -23,6 +23,7 @@
 #include <kwinglutils.h>
 
 class QMatrix4x4;
+class QVector2D;
 
 namespace KWin
 {
@@ -118,6 +119,56 @@ private:
 
 
 
+// ----------------------------------------------------------------------------
+
+
+/**
+ * Dual filter blur used by the downsampled blur path.
+ *
+ * Instead of a separable gaussian kernel the background is repeatedly scaled
+ * down into textures of half the size and scaled up again. Each pass only takes
+ * a few samples around the current texel, so most of the work is done at a
+ * fraction of the screen resolution. The result does not depend on a kernel
+ * size, the blur strength is controlled by the sample offset.
+ **/
+class GLSLDualFilterShader
+{
+public:
+    enum Pass {
+        Downsample = 0,
+        Upsample = 1
+    };
+
+    GLSLDualFilterShader();
+    ~GLSLDualFilterShader();
+
+    static bool supported();
+
+    bool isValid() const {
+        return mValid;
+    }
+
+    void bind(Pass pass);
+    void unbind();
+
+    // Sets the distance to the samples in texture coordinates
+    void setOffset(const QVector2D &offset);
+    void setTextureMatrix(const QMatrix4x4 &matrix);
+    void setModelViewProjectionMatrix(const QMatrix4x4 &matrix);
+
+private:
+    void init();
+
+    GLShader *shader[2];
+    int offsetLocation[2];
+    int textureMatrixLocation[2];
+    int mvpMatrixLocation[2];
+    Pass mPass;
+    bool mValid;
+};
+
+
+
 // ----------------------------------------------------------------------------
 
 
@@ -0,0 +1,526 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2008 Lucas Murray <lmurray@undefinedfire.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "naturallayout.h"
+
+#include <QPair>
+#include <QtAlgorithms>
+
+#include <math.h>
+
+namespace KWin
+{
+
+// Upper bound for the passes pushing windows apart. Normally the windows are separated
+// long before, this only protects against windows pushing each other back and forth forever.
+// If it is reached the windows are arranged in a grid instead.
+static const int s_maxPasses = 1000;
+
+static inline int floorDiv(int value, int divisor)
+{
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+static inline int heightForWidth(const QRect &geometry, int width)
+{
+    return int((width / double(geometry.width())) * geometry.height());
+}
+
+// Windows are considered overlapping when they are closer than 10 pixels to each other
+static inline QRect padded(const QRect &rect)
+{
+    return rect.adjusted(-5, -5, 5, 5);
+}
+
+typedef QPair<EffectWindow*, QRect> WindowGeometry;
+
+// top to bottom, then left to right
+static bool centerLessThan(const WindowGeometry &left, const WindowGeometry &right)
+{
+    const QPoint leftCenter = left.second.center();
+    const QPoint rightCenter = right.second.center();
+    if (leftCenter.y() != rightCenter.y())
+        return leftCenter.y() < rightCenter.y();
+    return leftCenter.x() < rightCenter.x();
+}
+
+static int averageCellSize(const QVector<QRect> &targets)
+{
+    if (targets.isEmpty()) {
+        return 64;
+    }
+    qint64 size = 0;
+    foreach (const QRect &target, targets) {
+        size += qMax(target.width(), target.height());
+    }
+    return qMax<qint64>(64, size / targets.count()) + 10;
+}
+
+//-----------------------------------------------------------------------------
+// LayoutGrid
+
+LayoutGrid::LayoutGrid()
+    : m_cellSize(64)
+{
+}
+
+void LayoutGrid::reset(int cellSize)
+{
+    m_cellSize = qMax(1, cellSize);
+    m_buckets.clear();
+}
+
+QRect LayoutGrid::cells(const QRect &rect) const
+{
+    return QRect(QPoint(floorDiv(rect.left(), m_cellSize), floorDiv(rect.top(), m_cellSize)),
+                 QPoint(floorDiv(rect.right(), m_cellSize), floorDiv(rect.bottom(), m_cellSize)));
+}
+
+void LayoutGrid::insert(int index, const QRect &rect)
+{
+    const QRect c = cells(rect);
+    for (int x = c.left(); x <= c.right(); ++x) {
+        for (int y = c.top(); y <= c.bottom(); ++y) {
+            m_buckets[key(x, y)].append(index);
+        }
+    }
+}
+
+void LayoutGrid::remove(int index, const QRect &rect)
+{
+    const QRect c = cells(rect);
+    for (int x = c.left(); x <= c.right(); ++x) {
+        for (int y = c.top(); y <= c.bottom(); ++y) {
+            QHash<qint64, QVector<int> >::iterator bucket = m_buckets.find(key(x, y));
+            if (bucket == m_buckets.end()) {
+                continue;
+            }
+            const int i = bucket->indexOf(index);
+            if (i != -1) {
+                bucket->remove(i);
+            }
+            if (bucket->isEmpty()) {
+                m_buckets.erase(bucket);
+            }
+        }
+    }
+}
+
+void LayoutGrid::move(int index, const QRect &oldRect, const QRect &newRect)
+{
+    if (cells(oldRect) == cells(newRect)) {
+        return;
+    }
+    remove(index, oldRect);
+    insert(index, newRect);
+}
+
+void LayoutGrid::candidates(const QRect &rect, QVector<int> *result) const
+{
+    const int start = result->count();
+    const QRect c = cells(rect);
+    for (int x = c.left(); x <= c.right(); ++x) {
+        for (int y = c.top(); y <= c.bottom(); ++y) {
+            QHash<qint64, QVector<int> >::const_iterator bucket = m_buckets.constFind(key(x, y));
+            if (bucket != m_buckets.constEnd()) {
+                *result += *bucket;
+            }
+        }
+    }
+    // sort for a stable order and drop the rects found in several buckets
+    qSort(result->begin() + start, result->end());
+    int last = start;
+    for (int i = start; i < result->count(); ++i) {
+        if (i == start || result->at(i) != result->at(last - 1)) {
+            (*result)[last++] = result->at(i);
+        }
+    }
+    result->resize(last);
+}
+
+//-----------------------------------------------------------------------------
+// NaturalLayout
+
+NaturalLayout::NaturalLayout()
+    : m_accuracy(20)
+    , m_fillGaps(true)
+{
+}
+
+void NaturalLayout::reset()
+{
+    m_lastArea = QRect();
+    m_lastGeometries.clear();
+    m_separated.clear();
+}
+
+bool NaturalLayout::canReuse(const QMap<EffectWindow*, QRect> &windows, const QRect &area) const
+{
+    if (m_separated.isEmpty() || area != m_lastArea) {
+        return false;
+    }
+    int added = 0;
+    for (QMap<EffectWindow*, QRect>::const_iterator it = windows.constBegin(); it != windows.constEnd(); ++it) {
+        QHash<EffectWindow*, QRect>::const_iterator last = m_lastGeometries.constFind(it.key());
+        if (last == m_lastGeometries.constEnd()) {
+            ++added;
+        } else if (*last != it.value()) {
+            // a window moved, the old arrangement does not fit anymore
+            return false;
+        }
+    }
+    const int removed = m_lastGeometries.count() - (windows.count() - added);
+    return added + removed <= 1;
+}
+
+QHash<EffectWindow*, QRect> NaturalLayout::layout(const QMap<EffectWindow*, QRect> &windows, const QRect &area)
+{
+    const bool reuse = canReuse(windows, area);
+
+    QVector<QRect> geometries;
+    QVector<QRect> targets;
+    QVector<int> directions;
+    geometries.reserve(windows.count());
+    targets.reserve(windows.count());
+    directions.reserve(windows.count());
+
+    // The map is sorted by window, as we are using pseudo-random movement (See "slot")
+    // we need the windows always in the same order no matter which window is active.
+    QRect bounds = area;
+    int direction = 0;
+    for (QMap<EffectWindow*, QRect>::const_iterator it = windows.constBegin(); it != windows.constEnd(); ++it) {
+        QRect target = it.value();
+        if (reuse) {
+            QHash<EffectWindow*, QRect>::const_iterator separated = m_separated.constFind(it.key());
+            if (separated != m_separated.constEnd()) {
+                target = *separated;
+            }
+        }
+        geometries << it.value();
+        targets << target;
+        bounds = bounds.united(target);
+        // Reuse the unused "slot" as a preferred direction attribute. This is used when the window
+        // is on the edge of the screen to try to use as much screen real estate as possible.
+        directions << direction;
+        direction++;
+        if (direction == 4)
+            direction = 0;
+    }
+
+    if (!separate(targets, bounds, directions)) {
+        // Rather show the windows in a grid than overlapping each other, there is
+        // nothing to remember for the next layout
+        reset();
+        return gridLayout(windows, area);
+    }
+
+    // Remember the separated arrangement for the next layout
+    m_lastArea = area;
+    m_lastGeometries.clear();
+    m_separated.clear();
+    int index = 0;
+    for (QMap<EffectWindow*, QRect>::const_iterator it = windows.constBegin(); it != windows.constEnd(); ++it, ++index) {
+        m_lastGeometries.insert(it.key(), it.value());
+        m_separated.insert(it.key(), targets.at(index));
+    }
+
+    // Work out scaling by getting the most top-left and most bottom-right window coords.
+    // The 20's and 10's are so that the windows don't touch the edge of the screen.
+    double scale;
+    if (bounds == area)
+        scale = 1.0; // Don't add borders to the screen
+    else if (area.width() / double(bounds.width()) < area.height() / double(bounds.height()))
+        scale = (area.width() - 20) / double(bounds.width());
+    else
+        scale = (area.height() - 20) / double(bounds.height());
+    // Make bounding rect fill the screen size for later steps
+    bounds = QRect(
+                 bounds.x() - (area.width() - 20 - bounds.width() * scale) / 2 - 10 / scale,
+                 bounds.y() - (area.height() - 20 - bounds.height() * scale) / 2 - 10 / scale,
+                 area.width() / scale,
+                 area.height() / scale
+             );
+
+    // Move all windows back onto the screen and set their scale
+    for (int i = 0; i < targets.count(); ++i) {
+        QRect &target = targets[i];
+        target.setRect((target.x() - bounds.x()) * scale + area.x(),
+                       (target.y() - bounds.y()) * scale + area.y(),
+                       target.width() * scale,
+                       target.height() * scale
+                       );
+    }
+
+    // Try to fill the gaps by enlarging windows if they have the space
+    if (m_fillGaps)
+        fillGaps(targets, geometries, area, scale);
+
+    QHash<EffectWindow*, QRect> result;
+    index = 0;
+    for (QMap<EffectWindow*, QRect>::const_iterator it = windows.constBegin(); it != windows.constEnd(); ++it, ++index) {
+        result.insert(it.key(), targets.at(index));
+    }
+    return result;
+}
+
+bool NaturalLayout::separate(QVector<QRect> &targets, QRect &bounds, const QVector<int> &directions)
+{
+    const int count = targets.count();
+    m_grid.reset(averageCellSize(targets));
+    for (int i = 0; i < count; ++i) {
+        m_grid.insert(i, padded(targets.at(i)));
+    }
+
+    // Iterate over all windows, if two overlap push them apart _slightly_ as we try to
+    // brute-force the most optimal positions over many iterations.
+    // Two windows which did not overlap when they were last compared can only overlap
+    // after one of them moved, so each pass only has to look at the windows which moved
+    // during the previous one.
+    QVector<bool> active(count, true);
+    QVector<bool> moved(count, false);
+    QVector<int> candidates;
+    bool overlap = true;
+    for (int pass = 0; pass < s_maxPasses && overlap; ++pass) {
+        overlap = false;
+        for (int w = 0; w < count; ++w) {
+            if (!active.at(w))
+                continue;
+            candidates.clear();
+            m_grid.candidates(padded(targets.at(w)), &candidates);
+            for (int c = 0; c < candidates.count(); ++c) {
+                const int e = candidates.at(c);
+                if (w == e)
+                    continue;
+                QRect *target_w = &targets[w];
+                QRect *target_e = &targets[e];
+                if (!padded(*target_w).intersects(padded(*target_e)))
+                    continue;
+                overlap = true;
+                const QRect oldW = *target_w;
+                const QRect oldE = *target_e;
+
+                // Determine pushing direction
+                QPoint diff(target_e->center() - target_w->center());
+                // Prevent dividing by zero and non-movement
+                if (diff.x() == 0 && diff.y() == 0)
+                    diff.setX(1);
+                // Approximate a vector of between 10px and 20px in magnitude in the same direction
+                diff *= m_accuracy / double(diff.manhattanLength());
+                // Move both windows apart
+                target_w->translate(-diff);
+                target_e->translate(diff);
+
+                // Try to keep the bounding rect the same aspect as the screen so that more
+                // screen real estate is utilised. We do this by splitting the screen into nine
+                // equal sections, if the window center is in any of the corner sections pull the
+                // window towards the outer corner. If it is in any of the other edge sections
+                // alternate between each corner on that edge. We don't want to determine it
+                // randomly as it will not produce consistant locations when using the filter.
+                // Only move one window so we don't cause large amounts of unnecessary zooming
+                // in some situations. We need to do this even when expanding later just in case
+                // all windows are the same size.
+                // (We are using an old bounding rect for this, hopefully it doesn't matter)
+                int xSection = (target_w->x() - bounds.x()) / (bounds.width() / 3);
+                int ySection = (target_w->y() - bounds.y()) / (bounds.height() / 3);
+                diff = QPoint(0, 0);
+                if (xSection != 1 || ySection != 1) { // Remove this if you want the center to pull as well
+                    if (xSection == 1)
+                        xSection = (directions.at(w) / 2 ? 2 : 0);
+                    if (ySection == 1)
+                        ySection = (directions.at(w) % 2 ? 2 : 0);
+                }
+                if (xSection == 0 && ySection == 0)
+                    diff = QPoint(bounds.topLeft() - target_w->center());
+                if (xSection == 2 && ySection == 0)
+                    diff = QPoint(bounds.topRight() - target_w->center());
+                if (xSection == 2 && ySection == 2)
+                    diff = QPoint(bounds.bottomRight() - target_w->center());
+                if (xSection == 0 && ySection == 2)
+                    diff = QPoint(bounds.bottomLeft() - target_w->center());
+                if (diff.x() != 0 || diff.y() != 0) {
+                    diff *= m_accuracy / double(diff.manhattanLength());
+                    target_w->translate(diff);
+                }
+
+                // Update bounding rect
+                bounds = bounds.united(*target_w);
+                bounds = bounds.united(*target_e);
+
+                m_grid.move(w, padded(oldW), padded(*target_w));
+                m_grid.move(e, padded(oldE), padded(*target_e));
+                moved[w] = true;
+                moved[e] = true;
+            }
+        }
+        active = moved;
+        moved.fill(false);
+    }
+    return !overlap;
+}
+
+QHash<EffectWindow*, QRect> NaturalLayout::gridLayout(const QMap<EffectWindow*, QRect> &windows, const QRect &area) const
+{
+    // The same slots as the regular grid layout, the windows fill them in the
+    // order of their positions
+    QList<WindowGeometry> ordered;
+    for (QMap<EffectWindow*, QRect>::const_iterator it = windows.constBegin(); it != windows.constEnd(); ++it)
+        ordered << WindowGeometry(it.key(), it.value());
+    qStableSort(ordered.begin(), ordered.end(), centerLessThan);
+
+    QHash<EffectWindow*, QRect> result;
+    if (ordered.isEmpty())
+        return result;
+    const int columns = int(ceil(sqrt(double(ordered.count()))));
+    const int rows = int(ceil(ordered.count() / double(columns)));
+    const int slotWidth = area.width() / columns;
+    const int slotHeight = area.height() / rows;
+    for (int i = 0; i < ordered.count(); ++i) {
+        // the windows are 10 pixels apart, like in the natural layout
+        const QRect slot = QRect(area.x() + (i % columns) * slotWidth, area.y() + (i / columns) * slotHeight,
+                                 slotWidth, slotHeight).adjusted(5, 5, -5, -5);
+        const QRect &geometry = ordered.at(i).second;
+        const double scale = qMin(1.0, qMin(slot.width() / double(geometry.width()),
+                                            slot.height() / double(geometry.height())));
+        const int width = qMax(1, int(geometry.width() * scale));
+        const int height = qMax(1, int(geometry.height() * scale));
+        result.insert(ordered.at(i).first, QRect(slot.center().x() - width / 2, slot.center().y() - height / 2,
+                                                 width, height));
+    }
+    return result;
+}
+
+void NaturalLayout::fillGaps(QVector<QRect> &targets, const QVector<QRect> &geometries, const QRect &area, double scale)
+{
+    const int count = targets.count();
+
+    // Don't expand onto or over the border
+    QRegion borderRegion(area.adjusted(-200, -200, 200, 200));
+    borderRegion ^= area.adjusted(10 / scale, 10 / scale, -10 / scale, -10 / scale);
+
+    m_grid.reset(averageCellSize(targets));
+    for (int i = 0; i < count; ++i) {
+        m_grid.insert(i, padded(targets.at(i)));
+    }
+
+    QVector<int> buffer;
+    bool moved;
+    do {
+        moved = false;
+        for (int i = 0; i < count; ++i) {
+            QRect oldRect;
+            QRect *target = &targets[i];
+            const QRect startRect = *target;
+            // This may cause some slight distortion if the windows are enlarged a large amount
+            int widthDiff = m_accuracy;
+            int heightDiff = heightForWidth(geometries.at(i), target->width() + widthDiff) - target->height();
+            int xDiff = widthDiff / 2;  // Also move a bit in the direction of the enlarge, allows the
+            int yDiff = heightDiff / 2; // center windows to be enlarged if there is gaps on the side.
+
+            // Attempt enlarging to the top-right
+            oldRect = *target;
+            target->setRect(target->x() + xDiff,
+                            target->y() - yDiff - heightDiff,
+                            target->width() + widthDiff,
+                            target->height() + heightDiff
+                            );
+            if (isOverlappingAny(i, targets, borderRegion, &buffer))
+                *target = oldRect;
+            else
+                moved = true;
+
+            // Attempt enlarging to the bottom-right
+            oldRect = *target;
+            target->setRect(
+                             target->x() + xDiff,
+                             target->y() + yDiff,
+                             target->width() + widthDiff,
+                             target->height() + heightDiff
+                         );
+            if (isOverlappingAny(i, targets, borderRegion, &buffer))
+                *target = oldRect;
+            else
+                moved = true;
+
+            // Attempt enlarging to the bottom-left
+            oldRect = *target;
+            target->setRect(
+                             target->x() - xDiff - widthDiff,
+                             target->y() + yDiff,
+                             target->width() + widthDiff,
+                             target->height() + heightDiff
+                         );
+            if (isOverlappingAny(i, targets, borderRegion, &buffer))
+                *target = oldRect;
+            else
+                moved = true;
+
+            // Attempt enlarging to the top-left
+            oldRect = *target;
+            target->setRect(
+                             target->x() - xDiff - widthDiff,
+                             target->y() - yDiff - heightDiff,
+                             target->width() + widthDiff,
+                             target->height() + heightDiff
+                         );
+            if (isOverlappingAny(i, targets, borderRegion, &buffer))
+                *target = oldRect;
+            else
+                moved = true;
+
+            m_grid.move(i, padded(startRect), padded(*target));
+        }
+    } while (moved);
+
+    // The expanding code above can actually enlarge windows over 1.0/2.0 scale, we don't like this
+    // We can't add this to the loop above as it would cause a never-ending loop so we have to make
+    // do with the less-than-optimal space usage with using this method.
+    for (int i = 0; i < count; ++i) {
+        QRect *target = &targets[i];
+        const QRect &geometry = geometries.at(i);
+        double scale = target->width() / double(geometry.width());
+        if (scale > 2.0 || (scale > 1.0 && (geometry.width() > 300 || geometry.height() > 300))) {
+            scale = (geometry.width() > 300 || geometry.height() > 300) ? 1.0 : 2.0;
+            target->setRect(
+                             target->center().x() - int(geometry.width() * scale) / 2,
+                             target->center().y() - int(geometry.height() * scale) / 2,
+                             geometry.width() * scale,
+                             geometry.height() * scale);
+        }
+    }
+}
+
+bool NaturalLayout::isOverlappingAny(int index, const QVector<QRect> &targets, const QRegion &border, QVector<int> *buffer) const
+{
+    const QRect target = targets.at(index);
+    if (border.intersects(target))
+        return true;
+    buffer->clear();
+    m_grid.candidates(padded(target), buffer);
+    for (int i = 0; i < buffer->count(); ++i) {
+        const int other = buffer->at(i);
+        if (other == index)
+            continue;
+        if (padded(target).intersects(padded(targets.at(other))))
+            return true;
+    }
+    return false;
+}
+
+} // namespace
@@ -0,0 +1,127 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+Copyright (C) 2008 Lucas Murray <lmurray@undefinedfire.com>
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_NATURALLAYOUT_H
+#define KWIN_NATURALLAYOUT_H
+
+#include <QHash>
+#include <QMap>
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace KWin
+{
+
+class EffectWindow;
+
+/**
+ * @short Spatial index for the overlap queries of the natural layout.
+ *
+ * The rects are sorted into a uniform grid of buckets, so finding the rects
+ * intersecting a given one only has to look at the buckets it covers instead
+ * of all rects.
+ **/
+class LayoutGrid
+{
+public:
+    LayoutGrid();
+    void reset(int cellSize);
+    void insert(int index, const QRect &rect);
+    void remove(int index, const QRect &rect);
+    void move(int index, const QRect &oldRect, const QRect &newRect);
+    /**
+     * Appends the index of every rect whose buckets intersect @p rect to @p result,
+     * in ascending order and without duplicates. The caller still has to test for
+     * the actual intersection.
+     **/
+    void candidates(const QRect &rect, QVector<int> *result) const;
+
+private:
+    QRect cells(const QRect &rect) const;
+    static qint64 key(int x, int y) {
+        return (qint64(x) << 32) | quint32(y);
+    }
+    int m_cellSize;
+    QHash<qint64, QVector<int> > m_buckets;
+};
+
+/**
+ * @short The "natural" window layout of the PresentWindows effect.
+ *
+ * Windows start at their real position and overlapping windows are pushed apart
+ * step by step until no window overlaps another one. The resulting arrangement is
+ * scaled to fit the screen area and, if enabled, the windows are enlarged as long
+ * as they do not overlap.
+ *
+ * The separated arrangement is remembered. If the next layout is requested for
+ * the same area and only a single window was added or removed, the pushing starts
+ * from the remembered arrangement, which is already free of overlaps except for
+ * the new window.
+ *
+ * If the windows cannot be separated within a bounded number of passes, they are
+ * arranged in a grid of equal slots instead, like the regular grid layout does.
+ **/
+class NaturalLayout
+{
+public:
+    NaturalLayout();
+
+    /**
+     * Distance in pixels windows are moved in each step.
+     **/
+    void setAccuracy(int accuracy) {
+        m_accuracy = accuracy;
+    }
+    void setFillGaps(bool fillGaps) {
+        m_fillGaps = fillGaps;
+    }
+
+    /**
+     * Calculates the target geometry for each of the @p windows, which maps
+     * a window to its current geometry, within @p area.
+     **/
+    QHash<EffectWindow*, QRect> layout(const QMap<EffectWindow*, QRect> &windows, const QRect &area);
+
+    /**
+     * Forgets the remembered arrangement, the next layout starts from scratch.
+     **/
+    void reset();
+
+private:
+    bool canReuse(const QMap<EffectWindow*, QRect> &windows, const QRect &area) const;
+    bool separate(QVector<QRect> &targets, QRect &bounds, const QVector<int> &directions);
+    QHash<EffectWindow*, QRect> gridLayout(const QMap<EffectWindow*, QRect> &windows, const QRect &area) const;
+    void fillGaps(QVector<QRect> &targets, const QVector<QRect> &geometries, const QRect &area, double scale);
+    bool isOverlappingAny(int index, const QVector<QRect> &targets, const QRegion &border, QVector<int> *buffer) const;
+
+    int m_accuracy;
+    bool m_fillGaps;
+    LayoutGrid m_grid;
+
+    // state of the previous layout
+    QRect m_lastArea;
+    QHash<EffectWindow*, QRect> m_lastGeometries;
+    QHash<EffectWindow*, QRect> m_separated;
+};
+
+} // namespace
+
+#endif
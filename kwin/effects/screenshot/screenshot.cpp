@@ -24,6 +24,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <KDE/KDebug>
 #include <KDE/KTemporaryFile>
 #include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusServiceWatcher>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QtConcurrentRun>
 #include <QVarLengthArray>
 #include <QtGui/QPainter>
 #include <QMatrix4x4>
@@ -43,20 +47,34 @@ bool ScreenShotEffect::supported()
 
 ScreenShotEffect::ScreenShotEffect()
     : m_scheduledScreenshot(0)
+    , m_streamPixmap(XCB_PIXMAP_NONE)
+    , m_streamFrameInFlight(false)
+    , m_streamWatcher(NULL)
 {
     connect ( effects, SIGNAL(windowClosed(KWin::EffectWindow*)), SLOT(windowClosed(KWin::EffectWindow*)) );
+    // the transfer of a screenshot is usually done within a frame
+    m_readbackTimer.setInterval(1);
+    connect(&m_readbackTimer, SIGNAL(timeout()), SLOT(pollReadbacks()));
+    connect(&m_streamTimer, SIGNAL(timeout()), SLOT(captureStreamFrame()));
     QDBusConnection::sessionBus().registerObject("/Screenshot", this, QDBusConnection::ExportScriptableContents);
     QDBusConnection::sessionBus().registerService("org.kde.kwin.Screenshot");
 }
 
 ScreenShotEffect::~ScreenShotEffect()
 {
+    stopStreaming();
+#ifndef KWIN_HAVE_OPENGLES
+    foreach (const PendingReadback &readback, m_readbacks) {
+        glDeleteSync(readback.fence);
+        glDeleteBuffers(1, &readback.buffer);
+    }
+#endif
     QDBusConnection::sessionBus().unregisterObject("/Screenshot");
     QDBusConnection::sessionBus().unregisterService("org.kde.kwin.Screenshot");
 }
 
 #ifdef KWIN_HAVE_XRENDER_COMPOSITING
-static QImage xPictureToImage(xcb_render_picture_t srcPic, const QRect &geometry, xcb_image_t **xImage)
+static QImage xPictureToImage(xcb_render_picture_t srcPic, const QRect &geometry)
 {
     xcb_pixmap_t xpix = xcb_generate_id(connection());
     xcb_create_pixmap(connection(), 32, xpix, rootWindow(), geometry.width(), geometry.height());
@@ -64,14 +82,36 @@ static QImage xPictureToImage(xcb_render_picture_t srcPic, const QRect &geometry
     xcb_render_composite(connection(), XCB_RENDER_PICT_OP_SRC, srcPic, XCB_RENDER_PICTURE_NONE, pic,
                          geometry.x(), geometry.y(), 0, 0, 0, 0, geometry.width(), geometry.height());
     xcb_flush(connection());
-    *xImage = xcb_image_get(connection(), xpix, 0, 0, geometry.width(), geometry.height(), ~0, XCB_IMAGE_FORMAT_Z_PIXMAP);
-    QImage img((*xImage)->data, (*xImage)->width, (*xImage)->height, (*xImage)->stride, QImage::Format_ARGB32_Premultiplied);
-    // TODO: byte order might need swapping
+    xcb_image_t *xImage = xcb_image_get(connection(), xpix, 0, 0, geometry.width(), geometry.height(), ~0, XCB_IMAGE_FORMAT_Z_PIXMAP);
+    QImage img;
+    if (xImage) {
+        // deep copy, the image is processed after the xcb image is gone
+        img = QImage(xImage->data, xImage->width, xImage->height, xImage->stride, QImage::Format_ARGB32_Premultiplied).copy();
+        // TODO: byte order might need swapping
+        xcb_image_destroy(xImage);
+    }
     xcb_free_pixmap(connection(), xpix);
     return img;
 }
 #endif
 
+static QImage readPixels(const QSize &size)
+{
+    QImage img(size, QImage::Format_ARGB32);
+    glReadnPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, img.byteCount(), (GLvoid*)img.bits());
+    return img;
+}
+
+static void putImage(xcb_pixmap_t pixmap, const QImage &img)
+{
+    xcb_gcontext_t cid = xcb_generate_id(connection());
+    xcb_create_gc(connection(), cid, pixmap, 0, NULL);
+    xcb_put_image(connection(), XCB_IMAGE_FORMAT_Z_PIXMAP, pixmap, cid, img.width(), img.height(),
+                  0, 0, 0, img.depth(), img.byteCount(), img.constBits());
+    xcb_free_gc(connection(), cid);
+    xcb_flush(connection());
+}
+
 void ScreenShotEffect::postPaintScreen()
 {
     effects->postPaintScreen();
@@ -128,9 +168,14 @@ void ScreenShotEffect::postPaintScreen()
             d.setXTranslation(-m_scheduledScreenshot->x() - left);
             d.setYTranslation(-m_scheduledScreenshot->y() - top);
 
+            Request request;
+            request.target = Request::Pixmap;
+            if (m_type & INCLUDE_CURSOR) {
+                grabPointerImage(request, m_scheduledScreenshot->x() + left, m_scheduledScreenshot->y() + top);
+            }
+
             // render window into offscreen texture
             int mask = PAINT_WINDOW_TRANSFORMED | PAINT_WINDOW_TRANSLUCENT;
-            QImage img;
             if (effects->isOpenGLCompositing()) {
                 GLRenderTarget::pushRenderTarget(target.data());
                 glClearColor(0.0, 0.0, 0.0, 0.0);
@@ -140,43 +185,20 @@ void ScreenShotEffect::postPaintScreen()
                 effects->drawWindow(m_scheduledScreenshot, mask, infiniteRegion(), d);
                 restoreMatrix();
                 // copy content from framebuffer into image
-                img = QImage(QSize(width, height), QImage::Format_ARGB32);
-                glReadnPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, img.byteCount(), (GLvoid*)img.bits());
+                request.convertFromGL = true;
+                readFramebuffer(QSize(width, height), request);
                 GLRenderTarget::popRenderTarget();
-                ScreenShotEffect::convertFromGLImage(img, width, height);
             }
 #ifdef KWIN_HAVE_XRENDER_COMPOSITING
-            xcb_image_t *xImage = NULL;
             if (effects->compositingType() == XRenderCompositing) {
                 setXRenderOffscreen(true);
                 effects->drawWindow(m_scheduledScreenshot, mask, QRegion(0, 0, width, height), d);
                 if (xRenderOffscreenTarget()) {
-                    img = xPictureToImage(xRenderOffscreenTarget(), QRect(0, 0, width, height), &xImage);
+                    processImage(xPictureToImage(xRenderOffscreenTarget(), QRect(0, 0, width, height)), request);
                 }
                 setXRenderOffscreen(false);
             }
 #endif
-
-            if (m_type & INCLUDE_CURSOR) {
-                grabPointerImage(img, m_scheduledScreenshot->x() + left, m_scheduledScreenshot->y() + top);
-            }
-
-            const int depth = img.depth();
-            xcb_pixmap_t xpix = xcb_generate_id(connection());
-            xcb_create_pixmap(connection(), depth, xpix, rootWindow(), img.width(), img.height());
-
-            xcb_gcontext_t cid = xcb_generate_id(connection());
-            xcb_create_gc(connection(), cid, xpix, 0, NULL);
-            xcb_put_image(connection(), XCB_IMAGE_FORMAT_Z_PIXMAP, xpix, cid, img.width(), img.height(),
-                        0, 0, 0, depth, img.byteCount(), img.constBits());
-            xcb_free_gc(connection(), cid);
-            xcb_flush(connection());
-            emit screenshotCreated(xpix);
-#ifdef KWIN_HAVE_XRENDER_COMPOSITING
-            if (xImage) {
-                xcb_image_destroy(xImage);
-            }
-#endif
         }
         m_scheduledScreenshot = NULL;
     }
@@ -272,57 +294,254 @@ QString ScreenShotEffect::screenshotArea(int x, int y, int width, int height)
 
 QString ScreenShotEffect::blitScreenshot(const QRect &geometry)
 {
-#ifdef KWIN_HAVE_OPENGLES
-    Q_UNUSED(geometry)
-    kDebug(1212) << "Framebuffer Blit not supported";
+    KTemporaryFile temp;
+    temp.setSuffix(".png");
+    temp.setAutoRemove(false);
+    if (!temp.open()) {
+        return QString();
+    }
+    temp.close();
+
+    Request request;
+    request.target = Request::File;
+    request.fileName = temp.fileName();
+    request.convertFromGL = effects->isOpenGLCompositing();
+    if (!calledFromDBus()) {
+        QImage img;
+        if (!grabArea(geometry, request, &img)) {
+            QFile::remove(request.fileName);
+            return QString();
+        }
+        return processImageThreaded(img, request).fileName;
+    }
+
+    // the file name is replied once the image is written
+    request.reply = message();
+    if (!grabArea(geometry, request)) {
+        QFile::remove(request.fileName);
+        return QString();
+    }
+    setDelayedReply(true);
     return QString();
+}
+
+bool ScreenShotEffect::grabArea(const QRect &geometry, const Request &request, QImage *image)
+{
+    if (effects->isOpenGLCompositing()) {
+#ifdef KWIN_HAVE_OPENGLES
+        kDebug(1212) << "Framebuffer Blit not supported";
+        return false;
 #else
-    QImage img;
-    if (effects->isOpenGLCompositing())
-    {
         if (!GLRenderTarget::blitSupported()) {
             kDebug(1212) << "Framebuffer Blit not supported";
-            return QString();
+            return false;
         }
         GLTexture tex(geometry.width(), geometry.height());
         GLRenderTarget target(tex);
         target.blitFromFramebuffer(geometry);
         // copy content from framebuffer into image
-        tex.bind();
-        img = QImage(geometry.size(), QImage::Format_ARGB32);
-        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)img.bits());
-        tex.unbind();
-        ScreenShotEffect::convertFromGLImage(img, geometry.width(), geometry.height());
+        GLRenderTarget::pushRenderTarget(&target);
+        if (image) {
+            *image = readPixels(geometry.size());
+        } else {
+            readFramebuffer(geometry.size(), request);
+        }
+        GLRenderTarget::popRenderTarget();
+        return true;
+#endif
     }
-
 #ifdef KWIN_HAVE_XRENDER_COMPOSITING
-    xcb_image_t *xImage = NULL;
-#endif
     if (effects->compositingType() == XRenderCompositing) {
-#ifdef KWIN_HAVE_XRENDER_COMPOSITING
-        img = xPictureToImage(effects->xrenderBufferPicture(), geometry, &xImage);
-#endif
+        const QImage img = xPictureToImage(effects->xrenderBufferPicture(), geometry);
+        if (image) {
+            *image = img;
+        } else {
+            processImage(img, request);
+        }
+        return true;
     }
+#endif
+    return false;
+}
 
-    KTemporaryFile temp;
-    temp.setSuffix(".png");
-    temp.setAutoRemove(false);
-    if (!temp.open()) {
-        return QString();
+void ScreenShotEffect::readFramebuffer(const QSize &size, const Request &request)
+{
+#ifndef KWIN_HAVE_OPENGLES
+    if (glFenceSync && glMapBuffer) {
+        // read into a pixel buffer object, glReadPixels returns without waiting for the GPU
+        PendingReadback readback;
+        readback.size = size;
+        readback.request = request;
+        glGenBuffers(1, &readback.buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size.width() * size.height() * 4, NULL, GL_STREAM_READ);
+        glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_readbacks << readback;
+        if (!m_readbackTimer.isActive()) {
+            m_readbackTimer.start();
+        }
+        return;
     }
-    img.save(&temp);
-#ifdef KWIN_HAVE_XRENDER_COMPOSITING
-    if (xImage) {
-        xcb_image_destroy(xImage);
+#endif
+    processImage(readPixels(size), request);
+}
+
+void ScreenShotEffect::pollReadbacks()
+{
+#ifndef KWIN_HAVE_OPENGLES
+    QList<PendingReadback>::iterator it = m_readbacks.begin();
+    while (it != m_readbacks.end()) {
+        if (glClientWaitSync(it->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) == GL_TIMEOUT_EXPIRED) {
+            ++it;
+            continue;
+        }
+        glDeleteSync(it->fence);
+        QImage img(it->size, QImage::Format_ARGB32);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, it->buffer);
+        if (const GLvoid *data = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY)) {
+            memcpy(img.bits(), data, img.byteCount());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            img = QImage();
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glDeleteBuffers(1, &it->buffer);
+        processImage(img, it->request);
+        it = m_readbacks.erase(it);
     }
 #endif
-    temp.close();
-    return temp.fileName();
+    if (m_readbacks.isEmpty()) {
+        m_readbackTimer.stop();
+    }
+}
+
+void ScreenShotEffect::processImage(const QImage &image, const Request &request)
+{
+    QFutureWatcher<Result> *watcher = new QFutureWatcher<Result>(this);
+    connect(watcher, SIGNAL(finished()), SLOT(imageProcessed()));
+    watcher->setFuture(QtConcurrent::run(&ScreenShotEffect::processImageThreaded, image, request));
+}
+
+ScreenShotEffect::Result ScreenShotEffect::processImageThreaded(QImage image, Request request)
+{
+    Result result;
+    if (!image.isNull()) {
+        if (request.convertFromGL) {
+            convertFromGLImage(image, image.width(), image.height());
+        }
+        if (!request.cursor.isNull()) {
+            QPainter painter(&image);
+            painter.drawImage(request.cursorPosition, request.cursor);
+        }
+        if (request.target == Request::File) {
+            if (image.save(request.fileName, "PNG")) {
+                result.fileName = request.fileName;
+            } else {
+                QFile::remove(request.fileName);
+            }
+        }
+    }
+    result.request = request;
+    result.image = image;
+    return result;
+}
+
+void ScreenShotEffect::imageProcessed()
+{
+    QFutureWatcher<Result> *watcher = dynamic_cast<QFutureWatcher<Result>*>(sender());
+    if (!watcher) {
+        return;
+    }
+    finishImage(watcher->result());
+    watcher->deleteLater();
+}
+
+void ScreenShotEffect::finishImage(const Result &result)
+{
+    const QImage &img = result.image;
+    switch (result.request.target) {
+    case Request::File:
+        QDBusConnection::sessionBus().send(result.request.reply.createReply(result.fileName));
+        break;
+    case Request::Pixmap: {
+        if (img.isNull()) {
+            break;
+        }
+        xcb_pixmap_t xpix = xcb_generate_id(connection());
+        xcb_create_pixmap(connection(), img.depth(), xpix, rootWindow(), img.width(), img.height());
+        putImage(xpix, img);
+        emit screenshotCreated(xpix);
+        break;
+    }
+    case Request::Stream:
+        m_streamFrameInFlight = false;
+        // the stream might have been stopped or restarted in between
+        if (m_streamPixmap != XCB_PIXMAP_NONE && img.size() == m_streamGeometry.size()) {
+            putImage(m_streamPixmap, img);
+            emit streamFrameCaptured(m_streamPixmap);
+        }
+        break;
+    }
+}
+
+qulonglong ScreenShotEffect::startStreaming(int x, int y, int width, int height, int fps)
+{
+    if (width <= 0 || height <= 0 || fps <= 0) {
+        return 0;
+    }
+#ifdef KWIN_HAVE_OPENGLES
+    kDebug(1212) << "Framebuffer Blit not supported";
+    return 0;
+#else
+    if (effects->isOpenGLCompositing() && !GLRenderTarget::blitSupported()) {
+        kDebug(1212) << "Framebuffer Blit not supported";
+        return 0;
+    }
+    stopStreaming();
+    m_streamGeometry = QRect(x, y, width, height);
+    m_streamPixmap = xcb_generate_id(connection());
+    xcb_create_pixmap(connection(), 32, m_streamPixmap, rootWindow(), width, height);
+    xcb_flush(connection());
+    m_streamTimer.start(1000 / qMin(fps, 60));
+    if (calledFromDBus()) {
+        m_streamWatcher = new QDBusServiceWatcher(message().service(), QDBusConnection::sessionBus(),
+                                                  QDBusServiceWatcher::WatchForUnregistration, this);
+        connect(m_streamWatcher, SIGNAL(serviceUnregistered(QString)), SLOT(stopStreaming()));
+    }
+    return m_streamPixmap;
 #endif
 }
 
-void ScreenShotEffect::grabPointerImage(QImage& snapshot, int offsetx, int offsety)
-// Uses the X11_EXTENSIONS_XFIXES_H extension to grab the pointer image, and overlays it onto the snapshot.
+void ScreenShotEffect::stopStreaming()
+{
+    m_streamTimer.stop();
+    if (m_streamWatcher) {
+        m_streamWatcher->deleteLater();
+        m_streamWatcher = NULL;
+    }
+    if (m_streamPixmap != XCB_PIXMAP_NONE) {
+        xcb_free_pixmap(connection(), m_streamPixmap);
+        xcb_flush(connection());
+        m_streamPixmap = XCB_PIXMAP_NONE;
+    }
+}
+
+void ScreenShotEffect::captureStreamFrame()
+{
+    if (m_streamFrameInFlight) {
+        // rather drop a frame than let the frames queue up
+        return;
+    }
+    Request request;
+    request.target = Request::Stream;
+    request.convertFromGL = effects->isOpenGLCompositing();
+    m_streamFrameInFlight = grabArea(m_streamGeometry, request);
+}
+
+void ScreenShotEffect::grabPointerImage(Request &request, int offsetx, int offsety)
+// Uses the X11_EXTENSIONS_XFIXES_H extension to grab the pointer image, it is overlaid onto the snapshot when processing it.
 {
     QScopedPointer<xcb_xfixes_get_cursor_image_reply_t, QScopedPointerPodDeleter> cursor(
         xcb_xfixes_get_cursor_image_reply(connection(),
@@ -331,11 +550,10 @@ void ScreenShotEffect::grabPointerImage(QImage& snapshot, int offsetx, int offse
     if (cursor.isNull())
         return;
 
-    QImage qcursorimg((uchar *) xcb_xfixes_get_cursor_image_cursor_image(cursor.data()), cursor->width, cursor->height,
-                      QImage::Format_ARGB32_Premultiplied);
-
-    QPainter painter(&snapshot);
-    painter.drawImage(QPointF(cursor->x - cursor->xhot - offsetx, cursor->y - cursor ->yhot - offsety), qcursorimg);
+    // deep copy, the reply is gone when the image is processed
+    request.cursor = QImage((uchar *) xcb_xfixes_get_cursor_image_cursor_image(cursor.data()), cursor->width, cursor->height,
+                            QImage::Format_ARGB32_Premultiplied).copy();
+    request.cursorPosition = QPoint(cursor->x - cursor->xhot - offsetx, cursor->y - cursor ->yhot - offsety);
 }
 
 void ScreenShotEffect::convertFromGLImage(QImage &img, int w, int h)
@@ -22,13 +22,25 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define KWIN_SCREENSHOT_H
 
 #include <kwineffects.h>
+#include <kwinglutils.h>
 #include <QObject>
 #include <QImage>
+#include <QTimer>
+#include <QtDBus/QDBusContext>
+#include <QtDBus/QDBusMessage>
+
+class QDBusServiceWatcher;
 
 namespace KWin
 {
 
-class ScreenShotEffect : public Effect
+/**
+ * The pixels of a screenshot are not read back synchronously. They are transferred
+ * into a pixel buffer object guarded by a fence, which is polled until the GPU
+ * completed the transfer. Converting the pixels and encoding the PNG file happens
+ * in a worker thread, the D-Bus reply is sent once the file is written.
+ **/
+class ScreenShotEffect : public Effect, protected QDBusContext
 {
     Q_OBJECT
     Q_CLASSINFO("D-Bus Interface", "org.kde.kwin.Screenshot")
@@ -70,20 +82,78 @@ public Q_SLOTS:
      * @returns Path to stored screenshot, or null string in failure case.
      **/
     Q_SCRIPTABLE QString screenshotArea(int x, int y, int width, int height);
+    /**
+     * Starts to capture the selected geometry @p fps times per second. Every frame is
+     * copied into the same X pixmap, which is announced by the streamFrameCaptured signal.
+     * The stream ends with stopStreaming() or when the calling client disconnects.
+     * Functionality requires hardware support, if not available 0 is returned.
+     * @returns The X pixmap the frames are copied into, 0 in failure case.
+     **/
+    Q_SCRIPTABLE qulonglong startStreaming(int x, int y, int width, int height, int fps);
+    Q_SCRIPTABLE void stopStreaming();
 
 Q_SIGNALS:
     Q_SCRIPTABLE void screenshotCreated(qulonglong handle);
+    /**
+     * Emitted when the next frame of the stream has been copied into @p handle.
+     * The content remains valid until the next frame is captured.
+     **/
+    Q_SCRIPTABLE void streamFrameCaptured(qulonglong handle);
 
 private slots:
     void windowClosed( KWin::EffectWindow* w );
+    void pollReadbacks();
+    void imageProcessed();
+    void captureStreamFrame();
 
 private:
-    void grabPointerImage(QImage& snapshot, int offsetx, int offsety);
+    /**
+     * What to do with a screenshot once it has been read back.
+     **/
+    struct Request {
+        enum Target {
+            File, ///< save as PNG and reply the file name to a D-Bus call
+            Pixmap, ///< copy into a new X pixmap, see screenshotCreated
+            Stream ///< copy into the pixmap of the stream
+        };
+        Request() : target(File), convertFromGL(false) {}
+        Target target;
+        QDBusMessage reply;
+        QString fileName;
+        bool convertFromGL;
+        QImage cursor;
+        QPoint cursorPosition;
+    };
+    struct Result {
+        Request request;
+        QImage image;
+        QString fileName;
+    };
+    struct PendingReadback {
+        GLuint buffer;
+        GLsync fence;
+        QSize size;
+        Request request;
+    };
+    void grabPointerImage(Request &request, int offsetx, int offsety);
     QString blitScreenshot(const QRect &geometry);
+    bool grabArea(const QRect &geometry, const Request &request, QImage *image = NULL);
+    void readFramebuffer(const QSize &size, const Request &request);
+    void processImage(const QImage &image, const Request &request);
+    static Result processImageThreaded(QImage image, Request request);
+    void finishImage(const Result &result);
     void setMatrix(int width, int height);
     void restoreMatrix();
     EffectWindow *m_scheduledScreenshot;
     ScreenShotType m_type;
+    QList<PendingReadback> m_readbacks;
+    QTimer m_readbackTimer;
+    // streaming
+    QRect m_streamGeometry;
+    xcb_pixmap_t m_streamPixmap;
+    bool m_streamFrameInFlight;
+    QTimer m_streamTimer;
+    QDBusServiceWatcher *m_streamWatcher;
 };
 
 } // namespace
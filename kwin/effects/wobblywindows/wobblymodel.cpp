@@ -0,0 +1,470 @@
+/*****************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+You can Freely distribute this program under the GNU General Public
+License. See the file "COPYING" for the exact licensing terms.
+******************************************************************/
+
+#include "wobblymodel.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#  define HAVE_SSE2
+#  include <emmintrin.h>
+#endif
+
+namespace KWin
+{
+
+namespace
+{
+
+// The kernels below operate on one row of the grid at once
+#ifdef HAVE_SSE2
+
+typedef __m128 Row;
+
+static inline Row load(const float *data)
+{
+    return _mm_loadu_ps(data);
+}
+
+static inline void store(float *data, Row row)
+{
+    _mm_storeu_ps(data, row);
+}
+
+static inline Row splat(float value)
+{
+    return _mm_set1_ps(value);
+}
+
+static inline Row add(Row a, Row b)
+{
+    return _mm_add_ps(a, b);
+}
+
+static inline Row sub(Row a, Row b)
+{
+    return _mm_sub_ps(a, b);
+}
+
+static inline Row mul(Row a, Row b)
+{
+    return _mm_mul_ps(a, b);
+}
+
+// element i holds element i-1, the first one holds itself
+static inline Row previous(Row row)
+{
+    return _mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 1, 0, 0));
+}
+
+// element i holds element i+1, the last one holds itself
+static inline Row next(Row row)
+{
+    return _mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 2, 1));
+}
+
+// sum of each element and its horizontal neighbours
+static inline Row horizontalSum3(Row row)
+{
+    const __m128i bits = _mm_castps_si128(row);
+    return add(row, add(_mm_castsi128_ps(_mm_slli_si128(bits, 4)),
+                        _mm_castsi128_ps(_mm_srli_si128(bits, 4))));
+}
+
+static inline Row absolute(Row row)
+{
+    return _mm_andnot_ps(_mm_set1_ps(-0.0f), row);
+}
+
+// values with a magnitude below min become 0, the magnitude of the others is cut to max
+static inline Row bound(Row row, float min, float max)
+{
+    const Row sign = _mm_and_ps(_mm_set1_ps(-0.0f), row);
+    const Row magnitude = absolute(row);
+    const Row bounded = _mm_and_ps(_mm_min_ps(magnitude, splat(max)),
+                                   _mm_cmpge_ps(magnitude, splat(min)));
+    return _mm_or_ps(bounded, sign);
+}
+
+static inline float sum(Row row)
+{
+    float values[4];
+    _mm_storeu_ps(values, row);
+    return values[0] + values[1] + values[2] + values[3];
+}
+
+#else
+
+struct Row {
+    float v[4];
+};
+
+static inline Row load(const float *data)
+{
+    Row row;
+    memcpy(row.v, data, sizeof(row.v));
+    return row;
+}
+
+static inline void store(float *data, const Row &row)
+{
+    memcpy(data, row.v, sizeof(row.v));
+}
+
+static inline Row splat(float value)
+{
+    Row row = {{value, value, value, value}};
+    return row;
+}
+
+static inline Row add(const Row &a, const Row &b)
+{
+    Row row = {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};
+    return row;
+}
+
+static inline Row sub(const Row &a, const Row &b)
+{
+    Row row = {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};
+    return row;
+}
+
+static inline Row mul(const Row &a, const Row &b)
+{
+    Row row = {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};
+    return row;
+}
+
+static inline Row previous(const Row &r)
+{
+    Row row = {{r.v[0], r.v[0], r.v[1], r.v[2]}};
+    return row;
+}
+
+static inline Row next(const Row &r)
+{
+    Row row = {{r.v[1], r.v[2], r.v[3], r.v[3]}};
+    return row;
+}
+
+static inline Row horizontalSum3(const Row &r)
+{
+    Row row = {{r.v[0] + r.v[1], r.v[0] + r.v[1] + r.v[2], r.v[1] + r.v[2] + r.v[3], r.v[2] + r.v[3]}};
+    return row;
+}
+
+static inline Row absolute(const Row &r)
+{
+    Row row = {{fabsf(r.v[0]), fabsf(r.v[1]), fabsf(r.v[2]), fabsf(r.v[3])}};
+    return row;
+}
+
+static inline float bound(float value, float min, float max)
+{
+    const float magnitude = fabsf(value);
+    if (magnitude < min)
+        return 0.0f;
+    if (magnitude > max)
+        return value > 0.0f ? max : -max;
+    return value;
+}
+
+static inline Row bound(const Row &r, float min, float max)
+{
+    Row row = {{bound(r.v[0], min, max), bound(r.v[1], min, max),
+                bound(r.v[2], min, max), bound(r.v[3], min, max)}};
+    return row;
+}
+
+static inline float sum(const Row &row)
+{
+    return row.v[0] + row.v[1] + row.v[2] + row.v[3];
+}
+
+#endif // HAVE_SSE2
+
+// 1 / number of points connected by springs, ie. the horizontal and vertical neighbours
+static const float s_springWeight[WobblyModel::PointCount] = {
+    1.0f / 2, 1.0f / 3, 1.0f / 3, 1.0f / 2,
+    1.0f / 3, 1.0f / 4, 1.0f / 4, 1.0f / 3,
+    1.0f / 3, 1.0f / 4, 1.0f / 4, 1.0f / 3,
+    1.0f / 2, 1.0f / 3, 1.0f / 3, 1.0f / 2
+};
+
+// 1 / number of all adjacent points, including the diagonal ones
+static const float s_meanWeight[WobblyModel::PointCount] = {
+    1.0f / 3, 1.0f / 5, 1.0f / 5, 1.0f / 3,
+    1.0f / 5, 1.0f / 8, 1.0f / 8, 1.0f / 5,
+    1.0f / 5, 1.0f / 8, 1.0f / 8, 1.0f / 5,
+    1.0f / 3, 1.0f / 5, 1.0f / 5, 1.0f / 3
+};
+
+// The springs of the points on the first and last column (row) are only stretched
+// to one side, the rest length does not cancel out
+static const float s_restLength[4] = { -1.0f, 0.0f, 0.0f, 1.0f };
+
+/**
+ * Acceleration of the points of one component caused by the springs,
+ * @p rest being the rest length of the springs along that component.
+ **/
+static void springForce(const float *position, const float *origin, const float *constraint,
+                        Row rest, bool vertical, float stiffness, float *result)
+{
+    const Row k = splat(stiffness);
+    for (int j = 0; j < WobblyModel::GridHeight; ++j) {
+        const int row = j * WobblyModel::GridWidth;
+        const int above = j > 0 ? row - WobblyModel::GridWidth : row;
+        const int below = j < WobblyModel::GridHeight - 1 ? row + WobblyModel::GridWidth : row;
+
+        const Row pos = load(position + row);
+        Row force = add(add(sub(previous(pos), pos), sub(next(pos), pos)),
+                        add(sub(load(position + above), pos), sub(load(position + below), pos)));
+        force = add(force, vertical ? mul(splat(s_restLength[j]), rest) : rest);
+        force = mul(force, mul(k, load(s_springWeight + row)));
+
+        // constrained points are only pulled towards their origin
+        const Row pull = mul(k, sub(load(origin + row), pos));
+        force = add(force, mul(load(constraint + row), sub(pull, force)));
+        store(result + row, force);
+    }
+}
+
+/**
+ * Replaces each value by the mean of itself and the mean of its adjacent values.
+ **/
+static void smooth(float *data)
+{
+    float result[WobblyModel::PointCount];
+    const Row half = splat(0.5f);
+    for (int j = 0; j < WobblyModel::GridHeight; ++j) {
+        const int row = j * WobblyModel::GridWidth;
+        const Row value = load(data + row);
+        Row neighbours = sub(horizontalSum3(value), value);
+        if (j > 0)
+            neighbours = add(neighbours, horizontalSum3(load(data + row - WobblyModel::GridWidth)));
+        if (j < WobblyModel::GridHeight - 1)
+            neighbours = add(neighbours, horizontalSum3(load(data + row + WobblyModel::GridWidth)));
+        store(result + row, mul(half, add(value, mul(neighbours, load(s_meanWeight + row)))));
+    }
+    memcpy(data, result, sizeof(result));
+}
+
+} // namespace
+
+WobblyModel::WobblyModel()
+{
+    reset(QRectF());
+}
+
+void WobblyModel::reset(const QRectF &geometry)
+{
+    setGeometry(geometry);
+    memcpy(m_positionX, m_originX, sizeof(m_positionX));
+    memcpy(m_positionY, m_originY, sizeof(m_positionY));
+    memcpy(m_previousX, m_originX, sizeof(m_previousX));
+    memcpy(m_previousY, m_originY, sizeof(m_previousY));
+    memcpy(m_controlX, m_originX, sizeof(m_controlX));
+    memcpy(m_controlY, m_originY, sizeof(m_controlY));
+    for (int i = 0; i < PointCount; ++i) {
+        m_velocityX[i] = m_velocityY[i] = 0.0f;
+        m_constraint[i] = 0.0f;
+    }
+    for (int i = 0; i < 4; ++i)
+        m_canWobble[i] = true;
+    m_accumulatedTime = 0;
+}
+
+void WobblyModel::setGeometry(const QRectF &geometry)
+{
+    m_geometry = geometry;
+    const float xLength = geometry.width() / (GridWidth - 1);
+    const float yLength = geometry.height() / (GridHeight - 1);
+    for (int j = 0; j < GridHeight; ++j) {
+        for (int i = 0; i < GridWidth; ++i) {
+            const int index = j * GridWidth + i;
+            // the last point is exactly on the edge
+            m_originX[index] = i == GridWidth - 1 ? geometry.x() + geometry.width() : geometry.x() + i * xLength;
+            m_originY[index] = j == GridHeight - 1 ? geometry.y() + geometry.height() : geometry.y() + j * yLength;
+        }
+    }
+}
+
+QPointF WobblyModel::origin(int index) const
+{
+    return QPointF(m_originX[index], m_originY[index]);
+}
+
+QPointF WobblyModel::position(int index) const
+{
+    return QPointF(m_positionX[index], m_positionY[index]);
+}
+
+void WobblyModel::setPosition(int index, const QPointF &position)
+{
+    m_positionX[index] = m_previousX[index] = m_controlX[index] = position.x();
+    m_positionY[index] = m_previousY[index] = m_controlY[index] = position.y();
+}
+
+void WobblyModel::setVelocity(int index, const QPointF &velocity)
+{
+    m_velocityX[index] = velocity.x();
+    m_velocityY[index] = velocity.y();
+}
+
+bool WobblyModel::isConstrained(int index) const
+{
+    return m_constraint[index] != 0.0f;
+}
+
+void WobblyModel::setConstrained(int index, bool constrained)
+{
+    m_constraint[index] = constrained ? 1.0f : 0.0f;
+}
+
+void WobblyModel::setCanWobble(bool top, bool left, bool right, bool bottom)
+{
+    m_canWobble[0] = top;
+    m_canWobble[1] = left;
+    m_canWobble[2] = right;
+    m_canWobble[3] = bottom;
+}
+
+bool WobblyModel::advance(const QRectF &geometry, int time, const Parameters &parameters, bool canStop)
+{
+    setGeometry(geometry);
+    m_accumulatedTime += time;
+    while (m_accumulatedTime >= StepTime) {
+        m_accumulatedTime -= StepTime;
+        memcpy(m_previousX, m_positionX, sizeof(m_previousX));
+        memcpy(m_previousY, m_positionY, sizeof(m_previousY));
+        if (!step(parameters) && canStop) {
+            m_accumulatedTime = 0;
+            updateControlPoints();
+            return false;
+        }
+    }
+    updateControlPoints();
+    return true;
+}
+
+bool WobblyModel::step(const Parameters &parameters)
+{
+    const float xLength = m_geometry.width() / (GridWidth - 1);
+    const float yLength = m_geometry.height() / (GridHeight - 1);
+
+    float accelerationX[PointCount];
+    float accelerationY[PointCount];
+    springForce(m_positionX, m_originX, m_constraint, mul(load(s_restLength), splat(xLength)),
+                false, parameters.stiffness, accelerationX);
+    springForce(m_positionY, m_originY, m_constraint, splat(yLength),
+                true, parameters.stiffness, accelerationY);
+    smooth(accelerationX);
+    smooth(accelerationY);
+
+    // compute the new velocity of each point
+    const Row time = splat(StepTime);
+    const Row drag = splat(parameters.drag);
+    float accelerationSum = 0.0f;
+    for (int row = 0; row < PointCount; row += GridWidth) {
+        const Row ax = bound(load(accelerationX + row), parameters.minAcceleration, parameters.maxAcceleration);
+        const Row ay = bound(load(accelerationY + row), parameters.minAcceleration, parameters.maxAcceleration);
+        store(m_velocityX + row, add(mul(ax, time), mul(load(m_velocityX + row), drag)));
+        store(m_velocityY + row, add(mul(ay, time), mul(load(m_velocityY + row), drag)));
+        accelerationSum += sum(add(absolute(ax), absolute(ay)));
+    }
+    smooth(m_velocityX);
+    smooth(m_velocityY);
+
+    // compute the new position of each point
+    const Row move = splat(StepTime * parameters.moveFactor);
+    float velocitySum = 0.0f;
+    for (int row = 0; row < PointCount; row += GridWidth) {
+        const Row vx = bound(load(m_velocityX + row), parameters.minVelocity, parameters.maxVelocity);
+        const Row vy = bound(load(m_velocityY + row), parameters.minVelocity, parameters.maxVelocity);
+        store(m_velocityX + row, vx);
+        store(m_velocityY + row, vy);
+        store(m_positionX + row, add(load(m_positionX + row), mul(vx, move)));
+        store(m_positionY + row, add(load(m_positionY + row), mul(vy, move)));
+        velocitySum += sum(add(absolute(vx), absolute(vy)));
+    }
+
+    // the sides which may not wobble stay in place, together with the inner points next to them
+    for (int j = 0; j < GridHeight; ++j) {
+        for (int i = 0; i < GridWidth; ++i) {
+            const int index = j * GridWidth + i;
+            if ((!m_canWobble[0] && j < GridHeight - 1) || (!m_canWobble[3] && j > 0))
+                m_positionY[index] = m_originY[index];
+            if ((!m_canWobble[1] && i < GridWidth - 1) || (!m_canWobble[2] && i > 0))
+                m_positionX[index] = m_originX[index];
+        }
+    }
+
+    return accelerationSum >= parameters.stopAcceleration || velocitySum >= parameters.stopVelocity;
+}
+
+void WobblyModel::updateControlPoints()
+{
+    const Row progress = splat(float(m_accumulatedTime) / StepTime);
+    for (int row = 0; row < PointCount; row += GridWidth) {
+        const Row px = load(m_previousX + row);
+        const Row py = load(m_previousY + row);
+        store(m_controlX + row, add(px, mul(progress, sub(load(m_positionX + row), px))));
+        store(m_controlY + row, add(py, mul(progress, sub(load(m_positionY + row), py))));
+    }
+}
+
+void WobblyModel::map(float *x, float *y, int count) const
+{
+    const float left = m_geometry.x();
+    const float top = m_geometry.y();
+    const float scaleX = m_geometry.width() > 0.0 ? 1.0 / m_geometry.width() : 0.0;
+    const float scaleY = m_geometry.height() > 0.0 ? 1.0 / m_geometry.height() : 0.0;
+    const Row one = splat(1.0f);
+    const Row three = splat(3.0f);
+
+    // four points at once, the last incomplete batch is padded
+    for (int n = 0; n < count; n += 4) {
+        const int batch = qMin(4, count - n);
+        float bx[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float by[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        memcpy(bx, x + n, batch * sizeof(float));
+        memcpy(by, y + n, batch * sizeof(float));
+
+        // cubic Bernstein polynomials of the position on the grid
+        const Row tx = mul(sub(load(bx), splat(left)), splat(scaleX));
+        const Row ty = mul(sub(load(by), splat(top)), splat(scaleY));
+        const Row sx = sub(one, tx);
+        const Row sy = sub(one, ty);
+        const Row px[4] = { mul(mul(sx, sx), sx), mul(three, mul(mul(sx, sx), tx)),
+                            mul(three, mul(mul(sx, tx), tx)), mul(mul(tx, tx), tx) };
+        const Row py[4] = { mul(mul(sy, sy), sy), mul(three, mul(mul(sy, sy), ty)),
+                            mul(three, mul(mul(sy, ty), ty)), mul(mul(ty, ty), ty) };
+
+        Row resultX = splat(0.0f);
+        Row resultY = splat(0.0f);
+        for (int j = 0; j < GridHeight; ++j) {
+            Row rowX = splat(0.0f);
+            Row rowY = splat(0.0f);
+            for (int i = 0; i < GridWidth; ++i) {
+                const int index = j * GridWidth + i;
+                rowX = add(rowX, mul(px[i], splat(m_controlX[index])));
+                rowY = add(rowY, mul(px[i], splat(m_controlY[index])));
+            }
+            resultX = add(resultX, mul(py[j], rowX));
+            resultY = add(resultY, mul(py[j], rowY));
+        }
+
+        store(bx, resultX);
+        store(by, resultY);
+        memcpy(x + n, bx, batch * sizeof(float));
+        memcpy(y + n, by, batch * sizeof(float));
+    }
+}
+
+} // namespace KWin
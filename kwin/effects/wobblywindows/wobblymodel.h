@@ -0,0 +1,120 @@
+/*****************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+You can Freely distribute this program under the GNU General Public
+License. See the file "COPYING" for the exact licensing terms.
+******************************************************************/
+
+#ifndef KWIN_WOBBLYMODEL_H
+#define KWIN_WOBBLYMODEL_H
+
+#include <QPointF>
+#include <QRectF>
+
+namespace KWin
+{
+
+/**
+ * @short Spring model of the WobblyWindows effect.
+ *
+ * A window is represented by a grid of 4x4 control points, each connected to its
+ * horizontal and vertical neighbours by springs. Every component of the state is
+ * stored in its own array, so that a row of the grid is processed at once - in a
+ * single SSE2 register if available.
+ *
+ * The model is advanced in fixed steps of StepTime milliseconds, independently of
+ * the rate the window is painted at. The control points used for painting are
+ * interpolated between the last two steps.
+ **/
+class WobblyModel
+{
+public:
+    enum {
+        GridWidth = 4,
+        GridHeight = 4,
+        PointCount = GridWidth * GridHeight
+    };
+    enum {
+        StepTime = 10 // in milliseconds
+    };
+
+    struct Parameters {
+        float stiffness;
+        float drag;
+        float moveFactor;
+        float minVelocity;
+        float maxVelocity;
+        float stopVelocity;
+        float minAcceleration;
+        float maxAcceleration;
+        float stopAcceleration;
+    };
+
+    WobblyModel();
+
+    /**
+     * Puts all control points at rest on the grid of @p geometry and
+     * removes all constraints.
+     **/
+    void reset(const QRectF &geometry);
+
+    /**
+     * The place of the point with @p index on the grid.
+     **/
+    QPointF origin(int index) const;
+    QPointF position(int index) const;
+    void setPosition(int index, const QPointF &position);
+    void setVelocity(int index, const QPointF &velocity);
+    bool isConstrained(int index) const;
+    /**
+     * A constrained point is only pulled towards its place on the grid,
+     * ignoring its neighbours.
+     **/
+    void setConstrained(int index, bool constrained);
+    /**
+     * The sides which are not allowed to wobble stay on the grid.
+     **/
+    void setCanWobble(bool top, bool left, bool right, bool bottom);
+
+    /**
+     * Advances the model by @p time milliseconds towards the grid of @p geometry.
+     * Time not filling a complete step is carried over to the next call.
+     * @returns false if @p canStop is true and the model came to rest.
+     **/
+    bool advance(const QRectF &geometry, int time, const Parameters &parameters, bool canStop);
+
+    /**
+     * Maps the @p count points given by @p x and @p y onto the wobbled surface,
+     * the results are written back to @p x and @p y. The points are relative to the
+     * geometry passed to the last call of advance().
+     **/
+    void map(float *x, float *y, int count) const;
+
+private:
+    void setGeometry(const QRectF &geometry);
+    bool step(const Parameters &parameters);
+    void updateControlPoints();
+
+    QRectF m_geometry;
+    int m_accumulatedTime;
+    bool m_canWobble[4];
+
+    float m_originX[PointCount];
+    float m_originY[PointCount];
+    float m_positionX[PointCount];
+    float m_positionY[PointCount];
+    float m_previousX[PointCount];
+    float m_previousY[PointCount];
+    float m_velocityX[PointCount];
+    float m_velocityY[PointCount];
+    // 1.0 for constrained points, 0.0 otherwise
+    float m_constraint[PointCount];
+    // interpolated between the previous and the current positions
+    float m_controlX[PointCount];
+    float m_controlY[PointCount];
+};
+
+} // namespace KWin
+
+#endif // KWIN_WOBBLYMODEL_H
@@ -14,6 +14,8 @@ License. See the file "COPYING" for the exact licensing terms.
 // Include with base class for effects.
 #include <kwineffects.h>
 
+#include "wobblymodel.h"
+
 namespace KWin
 {
 
@@ -59,11 +61,6 @@ public:
     void setVelocityThreshold(qreal velocityThreshold);
     void setMoveFactor(qreal factor);
 
-    struct Pair {
-        qreal x;
-        qreal y;
-    };
-
     enum WindowStatus {
         Free,
         Moving,
@@ -134,27 +131,10 @@ private:
 
     void startMovedResized(EffectWindow* w);
     void stepMovedResized(EffectWindow* w);
-    bool updateWindowWobblyDatas(EffectWindow* w, qreal time);
+    bool updateWindowWobblyDatas(EffectWindow* w, int time);
 
     struct WindowWobblyInfos {
-        Pair* origin;
-        Pair* position;
-        Pair* velocity;
-        Pair* acceleration;
-        Pair* buffer;
-
-        // if true, the physics system moves this point based only on it "normal" destination
-        // given by the window position, ignoring neighbour points.
-        bool* constraint;
-
-        unsigned int width;
-        unsigned int height;
-        unsigned int count;
-
-        Pair* bezierSurface;
-        unsigned int bezierWidth;
-        unsigned int bezierHeight;
-        unsigned int bezierCount;
+        WobblyModel model;
 
         WindowStatus status;
 
@@ -195,13 +175,9 @@ private:
     bool m_resizeWobble;
 
     void initWobblyInfo(WindowWobblyInfos& wwi, QRect geometry) const;
-    void freeWobblyInfo(WindowWobblyInfos& wwi) const;
     void wobblyOpenInit(WindowWobblyInfos& wwi) const;
     void wobblyCloseInit(WindowWobblyInfos& wwi, EffectWindow* w) const;
-
-    WobblyWindowsEffect::Pair computeBezierPoint(const WindowWobblyInfos& wwi, Pair point) const;
-
-    static void heightRingLinearMean(Pair** data_pointer, WindowWobblyInfos& wwi);
+    WobblyModel::Parameters modelParameters() const;
 
     void setParameterSet(const ParameterSet& pset);
 };
@@ -151,26 +151,19 @@ bool Workspace::workspaceEvent(XEvent * e)
         break;
     };
 
-    if (Client* c = findClient(WindowMatchPredicate(e->xany.window))) {
+    // The window may be the client window, the wrapper, the frame or the input window of a Client
+    if (Client* c = findClientByWindowId(e->xany.window)) {
         if (c->windowEvent(e))
             return true;
-    } else if (Client* c = findClient(WrapperIdMatchPredicate(e->xany.window))) {
-        if (c->windowEvent(e))
-            return true;
-    } else if (Client* c = findClient(FrameIdMatchPredicate(e->xany.window))) {
-        if (c->windowEvent(e))
-            return true;
-    } else if (Client *c = findClient(InputIdMatchPredicate(e->xany.window))) {
-        if (c->windowEvent(e))
-            return true;
-    } else if (Unmanaged* c = findUnmanaged(WindowMatchPredicate(e->xany.window))) {
+    } else if (Unmanaged* c = findUnmanagedByWindowId(e->xany.window)) {
         if (c->windowEvent(e))
             return true;
     } else {
         Window special = findSpecialEventWindow(e);
+        WindowIdRole role;
         if (special != None)
-            if (Client* c = findClient(WindowMatchPredicate(special))) {
-                if (c->windowEvent(e))
+            if (Client* c = findClientByWindowId(special, &role)) {
+                if (role == ClientWindowId && c->windowEvent(e))
                     return true;
             }
 
@@ -213,7 +206,9 @@ bool Workspace::workspaceEvent(XEvent * e)
     case MapRequest: {
         updateXTime();
 
-        if (Client* c = findClient(WindowMatchPredicate(e->xmaprequest.window))) {
+        WindowIdRole role;
+        Client* c = findClientByWindowId(e->xmaprequest.window, &role);
+        if (c && role == ClientWindowId) {
             // e->xmaprequest.window is different from e->xany.window
             // TODO this shouldn't be necessary now
             c->windowEvent(e);
@@ -233,7 +228,7 @@ bool Workspace::workspaceEvent(XEvent * e)
     }
     case MapNotify: {
         if (e->xmap.override_redirect) {
-            Unmanaged* c = findUnmanaged(WindowMatchPredicate(e->xmap.window));
+            Unmanaged* c = findUnmanagedByWindowId(e->xmap.window);
             if (c == NULL)
                 c = createUnmanaged(e->xmap.window);
             if (c)
@@ -1314,7 +1309,9 @@ static Bool predicate_follows_focusin(Display*, XEvent* e, XPointer arg)
     Q_UNUSED(arg)
     if (follows_focusin || follows_focusin_failed)
         return False;
-    if (e->type == FocusIn && workspace()->findClient(WindowMatchPredicate(e->xfocus.window))) {
+    Workspace::WindowIdRole role;
+    if (e->type == FocusIn && workspace()->findClientByWindowId(e->xfocus.window, &role)
+            && role == Workspace::ClientWindowId) {
         // found FocusIn
         follows_focusin = true;
         return False;
@@ -1432,10 +1432,44 @@ QSize Client::sizeForClientSize(const QSize& wsize, Sizemode mode, bool noframe)
  */
 void Client::getWmNormalHints()
 {
-    long msize;
+    Xcb::Property hints(window(), XCB_ATOM_WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 0, 18);
+    getWmNormalHints(hints);
+}
+
+void Client::getWmNormalHints(Xcb::Property &hints)
+{
     const bool hadFixedAspect = xSizeHint.flags & PAspect;
-    if (XGetWMNormalHints(display(), window(), &xSizeHint, &msize) == 0)
+    // WM_SIZE_HINTS are the 32 bit values flags, x, y, width, height, min size, max size,
+    // size increments, min aspect, max aspect, base size and gravity.
+    // Pre ICCCM clients don't set base size and gravity.
+    uint32_t count = 0;
+    const int32_t *data = static_cast<const int32_t*>(hints.value(XCB_ATOM_WM_SIZE_HINTS, 32, &count));
+    if (data && count >= 15) {
+        xSizeHint.flags = data[0];
+        xSizeHint.x = data[1];
+        xSizeHint.y = data[2];
+        xSizeHint.width = data[3];
+        xSizeHint.height = data[4];
+        xSizeHint.min_width = data[5];
+        xSizeHint.min_height = data[6];
+        xSizeHint.max_width = data[7];
+        xSizeHint.max_height = data[8];
+        xSizeHint.width_inc = data[9];
+        xSizeHint.height_inc = data[10];
+        xSizeHint.min_aspect.x = data[11];
+        xSizeHint.min_aspect.y = data[12];
+        xSizeHint.max_aspect.x = data[13];
+        xSizeHint.max_aspect.y = data[14];
+        if (count >= 18) {
+            xSizeHint.base_width = data[15];
+            xSizeHint.base_height = data[16];
+            xSizeHint.win_gravity = data[17];
+        } else {
+            xSizeHint.flags &= ~(PBaseSize | PWinGravity);
+        }
+    } else {
         xSizeHint.flags = 0;
+    }
     // set defined values for the fields, even if they're not in flags
 
     if (!(xSizeHint.flags & PMinSize))
@@ -0,0 +1,89 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "iconcache.h"
+
+namespace KWin
+{
+
+// Enough for the four icon sizes of about 100 different applications
+static const int s_cacheBudget = 8 * 1024 * 1024; // in bytes
+
+IconKey::IconKey()
+    : m_valid(false)
+    , m_dataHash(0)
+{
+}
+
+IconKey::IconKey(const QByteArray &resourceClass, const QSize &size, const uchar *data)
+    : m_valid(data != NULL)
+    , m_resourceClass(resourceClass)
+    , m_size(size)
+    , m_dataHash(0)
+{
+    if (data) {
+        // the icon data are 32 bit ARGB values
+        m_dataHash = qHash(QByteArray::fromRawData(reinterpret_cast<const char*>(data),
+                                                   size.width() * size.height() * 4));
+    }
+}
+
+bool IconKey::operator==(const IconKey &other) const
+{
+    return m_valid == other.m_valid && m_dataHash == other.m_dataHash &&
+           m_size == other.m_size && m_resourceClass == other.m_resourceClass;
+}
+
+uint qHash(const IconKey &key)
+{
+    return key.m_dataHash ^ qHash(key.m_resourceClass);
+}
+
+uint qHash(const IconCache::Entry &entry)
+{
+    return qHash(entry.key) ^ entry.size;
+}
+
+KWIN_SINGLETON_FACTORY(IconCache)
+
+IconCache::IconCache(QObject *parent)
+    : QObject(parent)
+    , m_cache(s_cacheBudget)
+{
+}
+
+IconCache::~IconCache()
+{
+    s_self = NULL;
+}
+
+QPixmap IconCache::icon(const IconKey &key, int size) const
+{
+    if (QPixmap *icon = m_cache.object(Entry(key, size))) {
+        return *icon;
+    }
+    return QPixmap();
+}
+
+void IconCache::insert(const IconKey &key, int size, const QPixmap &icon)
+{
+    m_cache.insert(Entry(key, size), new QPixmap(icon), icon.width() * icon.height() * 4);
+}
+
+} // namespace
+
+#include "iconcache.moc"
@@ -0,0 +1,94 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_ICONCACHE_H
+#define KWIN_ICONCACHE_H
+
+#include <kwinglobals.h>
+
+#include <QCache>
+#include <QObject>
+#include <QPixmap>
+
+namespace KWin
+{
+
+/**
+ * @short Identifies the icon of a window independently from the window.
+ *
+ * Windows of the same application usually provide identical icon data, so the key
+ * consists of the resource class and a hash of the icon data.
+ **/
+class IconKey
+{
+public:
+    IconKey();
+    IconKey(const QByteArray &resourceClass, const QSize &size, const uchar *data);
+
+    bool isValid() const {
+        return m_valid;
+    }
+    bool operator==(const IconKey &other) const;
+
+private:
+    friend uint qHash(const IconKey &key);
+    bool m_valid;
+    QByteArray m_resourceClass;
+    QSize m_size;
+    uint m_dataHash;
+};
+
+uint qHash(const IconKey &key);
+
+/**
+ * @short Cache of the decoded window icons, shared by all Clients.
+ *
+ * The Clients only decode their icon when it is requested in a specific size and
+ * insert the result into this cache. The cache is bounded by the memory used by
+ * the pixmaps, least recently used icons are dropped first.
+ **/
+class IconCache : public QObject
+{
+    Q_OBJECT
+public:
+    virtual ~IconCache();
+
+    /**
+     * @returns The cached icon for @p key in the given @p size or a null pixmap.
+     **/
+    QPixmap icon(const IconKey &key, int size) const;
+    void insert(const IconKey &key, int size, const QPixmap &icon);
+
+private:
+    struct Entry {
+        Entry(const IconKey &key, int size)
+            : key(key)
+            , size(size) {}
+        bool operator==(const Entry &other) const {
+            return size == other.size && key == other.key;
+        }
+        IconKey key;
+        int size;
+    };
+    friend uint qHash(const Entry &entry);
+    QCache<Entry, QPixmap> m_cache;
+    KWIN_SINGLETON(IconCache)
+};
+
+} // namespace
+
+#endif
@@ -20,10 +20,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 *********************************************************************/
 
 #include "lanczosfilter.h"
-#include "client.h"
-#include "deleted.h"
+#include "lanczosrefilter.h"
 #include "effects.h"
-#include "unmanaged.h"
 #include "options.h"
 #include "workspace.h"
 
@@ -33,12 +31,47 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <kwineffects.h>
 #include <KDE/KGlobalSettings>
 
-#include <qmath.h>
-#include <cmath>
-
 namespace KWin
 {
 
+// Upper bound for the memory used by all cached lanczos textures together
+static const qint64 s_cacheBudget = 64 * 1024 * 1024;
+
+LanczosCacheEntry::LanczosCacheEntry(LanczosFilter *filter, EffectWindow *w, GLTexture *texture)
+    : m_filter(filter)
+    , m_window(w)
+    , m_texture(texture)
+{
+    m_filter->m_cache.append(this);
+    m_filter->m_cacheSize += size();
+    m_window->setData(LanczosCacheRole, QVariant::fromValue(static_cast<void*>(this)));
+}
+
+LanczosCacheEntry::~LanczosCacheEntry()
+{
+    m_filter->m_cache.removeOne(this);
+    m_filter->m_cacheSize -= size();
+    m_window->setData(LanczosCacheRole, QVariant());
+    delete m_texture;
+}
+
+qint64 LanczosCacheEntry::size() const
+{
+    return qint64(m_texture->width()) * m_texture->height() * 4;
+}
+
+LanczosCacheEntry *LanczosCacheEntry::fromWindow(EffectWindow *w)
+{
+    return static_cast<LanczosCacheEntry*>(w->data(LanczosCacheRole).value<void*>());
+}
+
+void LanczosCacheEntry::addDamage(EffectWindow *w, const QRegion &region)
+{
+    if (LanczosCacheEntry *entry = fromWindow(w)) {
+        entry->m_stale += region;
+    }
+}
+
 LanczosFilter::LanczosFilter(QObject* parent)
     : QObject(parent)
     , m_offscreenTex(0)
@@ -48,11 +81,13 @@ LanczosFilter::LanczosFilter(QObject* parent)
     , m_uTexUnit(0)
     , m_uOffsets(0)
     , m_uKernel(0)
+    , m_cacheSize(0)
 {
 }
 
 LanczosFilter::~LanczosFilter()
 {
+    discardCache();
     delete m_offscreenTarget;
     delete m_offscreenTex;
 }
@@ -120,51 +155,17 @@ void LanczosFilter::updateOffscreenSurfaces()
     }
 }
 
-static float sinc(float x)
-{
-    return std::sin(x * M_PI) / (x * M_PI);
-}
-
-static float lanczos(float x, float a)
-{
-    if (qFuzzyCompare(x + 1.0, 1.0))
-        return 1.0;
-
-    if (qAbs(x) >= a)
-        return 0.0;
-
-    return sinc(x) * sinc(x / a);
-}
-
 void LanczosFilter::createKernel(float delta, int *size)
 {
-    const float a = 2.0;
-
-    // The two outermost samples always fall at points where the lanczos
-    // function returns 0, so we'll skip them.
-    const int sampleCount = qBound(3, qCeil(delta * a) * 2 + 1 - 2, 29);
-    const int center = sampleCount / 2;
-    const int kernelSize = center + 1;
-    const float factor = 1.0 / delta;
-
-    QVector<float> values(kernelSize);
-    float sum = 0;
-
-    for (int i = 0; i < kernelSize; i++) {
-        const float val = lanczos(i * factor, a);
-        sum += i > 0 ? val * 2 : val;
-        values[i] = val;
-    }
+    const QVector<float> values = LanczosRefilter::kernel(delta);
 
     memset(m_kernel, 0, 16 * sizeof(QVector4D));
-
-    // Normalize the kernel
-    for (int i = 0; i < kernelSize; i++) {
-        const float val = values[i] / sum;
+    for (int i = 0; i < values.count(); i++) {
+        const float val = values.at(i);
         m_kernel[i] = QVector4D(val, val, val, val);
     }
 
-    *size = kernelSize;
+    *size = values.count();
 }
 
 void LanczosFilter::createOffsets(int count, float width, Qt::Orientation direction)
@@ -201,142 +202,36 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
 
             int sw = width;
             int sh = height;
+            // the part of the window covered by the cache texture, in window coordinates
+            const QRect sourceRect(left, top, sw, sh);
+
+            LanczosCacheEntry *entry = LanczosCacheEntry::fromWindow(w);
+            if (entry && (entry->texture()->width() != tw || entry->texture()->height() != th)) {
+                // offscreen texture not matching - delete
+                delete entry;
+                entry = 0;
+            }
 
-            GLTexture *cachedTexture = static_cast< GLTexture*>(w->data(LanczosCacheRole).value<void*>());
-            if (cachedTexture) {
-                if (cachedTexture->width() == tw && cachedTexture->height() == th) {
-                    cachedTexture->bind();
-                    if (hardwareClipping) {
-                        glEnable(GL_SCISSOR_TEST);
-                    }
-
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-
-                    const qreal rgb = data.brightness() * data.opacity();
-                    const qreal a = data.opacity();
-
-                    ShaderBinder binder(ShaderManager::SimpleShader);
-                    GLShader *shader = binder.shader();
-                    shader->setUniform(GLShader::Offset, QVector2D(0, 0));
-                    shader->setUniform(GLShader::ModulationConstant, QVector4D(rgb, rgb, rgb, a));
-                    shader->setUniform(GLShader::Saturation, data.saturation());
-
-                    cachedTexture->render(region, textureRect, hardwareClipping);
-
-                    glDisable(GL_BLEND);
-                    if (hardwareClipping) {
-                        glDisable(GL_SCISSOR_TEST);
-                    }
-                    cachedTexture->unbind();
-                    m_timer.start(5000, this);
-                    return;
-                } else {
-                    // offscreen texture not matching - delete
-                    delete cachedTexture;
-                    cachedTexture = 0;
-                    w->setData(LanczosCacheRole, QVariant());
+            if (!entry) {
+                // create cache texture
+                GLTexture *cache = new GLTexture(tw, th);
+                cache->setFilter(GL_LINEAR);
+                cache->setWrapMode(GL_CLAMP_TO_EDGE);
+                entry = new LanczosCacheEntry(this, w, cache);
+                updateCacheTexture(w, mask, data, cache, sourceRect, LanczosRefilter(sourceRect, QSize(tw, th), sourceRect));
+            } else if (!entry->staleRegion().isEmpty()) {
+                // only refilter the part of the texture affected by the damage
+                const LanczosRefilter refilter(sourceRect, QSize(tw, th), entry->staleRegion());
+                if (!refilter.isEmpty()) {
+                    updateCacheTexture(w, mask, data, entry->texture(), sourceRect, refilter);
                 }
             }
+            entry->markUpdated();
+            touchCacheEntry(entry);
+            enforceCacheBudget(entry);
 
-            WindowPaintData thumbData = data;
-            thumbData.setXScale(1.0);
-            thumbData.setYScale(1.0);
-            thumbData.setXTranslation(-w->x() - left);
-            thumbData.setYTranslation(-w->y() - top);
-            thumbData.setBrightness(1.0);
-            thumbData.setOpacity(1.0);
-            thumbData.setSaturation(1.0);
-
-            // Bind the offscreen FBO and draw the window on it unscaled
-            updateOffscreenSurfaces();
-            GLRenderTarget::pushRenderTarget(m_offscreenTarget);
-
-            glClearColor(0.0, 0.0, 0.0, 0.0);
-            glClear(GL_COLOR_BUFFER_BIT);
-            w->sceneWindow()->performPaint(mask, infiniteRegion(), thumbData);
-
-            // Create a scratch texture and copy the rendered window into it
-            GLTexture tex(sw, sh);
-            tex.setFilter(GL_LINEAR);
-            tex.setWrapMode(GL_CLAMP_TO_EDGE);
-            tex.bind();
-
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, sw, sh);
-
-            // Set up the shader for horizontal scaling
-            float dx = sw / float(tw);
-            int kernelSize;
-            createKernel(dx, &kernelSize);
-            createOffsets(kernelSize, sw, Qt::Horizontal);
-
-            ShaderManager::instance()->pushShader(m_shader.data());
-            setUniforms();
-
-            // Draw the window back into the FBO, this time scaled horizontally
-            glClear(GL_COLOR_BUFFER_BIT);
-            QVector<float> verts;
-            QVector<float> texCoords;
-            verts.reserve(12);
-            texCoords.reserve(12);
-
-            texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
-            texCoords << 0.0 << 0.0; verts << 0.0 << 0.0; // Top left
-            texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
-            texCoords << 0.0 << 1.0; verts << 0.0 << sh;  // Bottom left
-            texCoords << 1.0 << 1.0; verts << tw  << sh;  // Bottom right
-            texCoords << 1.0 << 0.0; verts << tw  << 0.0; // Top right
-            GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
-            vbo->reset();
-            vbo->setData(6, 2, verts.constData(), texCoords.constData());
-            vbo->render(GL_TRIANGLES);
-
-            // At this point we don't need the scratch texture anymore
-            tex.unbind();
-            tex.discard();
-
-            // create scratch texture for second rendering pass
-            GLTexture tex2(tw, sh);
-            tex2.setFilter(GL_LINEAR);
-            tex2.setWrapMode(GL_CLAMP_TO_EDGE);
-            tex2.bind();
-
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - sh, tw, sh);
-
-            // Set up the shader for vertical scaling
-            float dy = sh / float(th);
-            createKernel(dy, &kernelSize);
-            createOffsets(kernelSize, m_offscreenTex->height(), Qt::Vertical);
-            setUniforms();
-
-            // Now draw the horizontally scaled window in the FBO at the right
-            // coordinates on the screen, while scaling it vertically and blending it.
-            glClear(GL_COLOR_BUFFER_BIT);
-
-            verts.clear();
-
-            verts << tw  << 0.0; // Top right
-            verts << 0.0 << 0.0; // Top left
-            verts << 0.0 << th;  // Bottom left
-            verts << 0.0 << th;  // Bottom left
-            verts << tw  << th;  // Bottom right
-            verts << tw  << 0.0; // Top right
-            vbo->setData(6, 2, verts.constData(), texCoords.constData());
-            vbo->render(GL_TRIANGLES);
-
-            tex2.unbind();
-            tex2.discard();
-            ShaderManager::instance()->popShader();
-
-            // create cache texture
-            GLTexture *cache = new GLTexture(tw, th);
-
-            cache->setFilter(GL_LINEAR);
-            cache->setWrapMode(GL_CLAMP_TO_EDGE);
+            GLTexture *cache = entry->texture();
             cache->bind();
-            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, m_offscreenTex->height() - th, tw, th);
-            GLRenderTarget::popRenderTarget();
-
             if (hardwareClipping) {
                 glEnable(GL_SCISSOR_TEST);
             }
@@ -362,7 +257,6 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
             }
 
             cache->unbind();
-            w->setData(LanczosCacheRole, QVariant::fromValue(static_cast<void*>(cache)));
 
             // Delete the offscreen surface after 5 seconds
             m_timer.start(5000, this);
@@ -372,6 +266,135 @@ void LanczosFilter::performPaint(EffectWindowImpl* w, int mask, QRegion region,
     w->sceneWindow()->performPaint(mask, region, data);
 } // End of function
 
+/**
+ * Copies @p rect of the currently bound offscreen surface into the same area of the bound
+ * texture. Both @p rect and the texture are in the top-left based coordinates used for
+ * rendering, the texture is expected to be copied from the bottom of the offscreen surface.
+ **/
+static void copyToTexture(const QRect &rect, int textureHeight, int offscreenHeight)
+{
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, rect.x(), textureHeight - rect.y() - rect.height(),
+                        rect.x(), offscreenHeight - rect.y() - rect.height(), rect.width(), rect.height());
+}
+
+/**
+ * Renders @p rect of a texture stretched to @p width x @p height.
+ **/
+static void renderRect(const QRect &rect, float width, float height)
+{
+    const float x1 = rect.x();
+    const float y1 = rect.y();
+    const float x2 = rect.x() + rect.width();
+    const float y2 = rect.y() + rect.height();
+    const float u1 = x1 / width;
+    const float v1 = y1 / height;
+    const float u2 = x2 / width;
+    const float v2 = y2 / height;
+
+    QVector<float> verts;
+    QVector<float> texCoords;
+    verts.reserve(12);
+    texCoords.reserve(12);
+
+    texCoords << u2 << v1; verts << x2 << y1; // Top right
+    texCoords << u1 << v1; verts << x1 << y1; // Top left
+    texCoords << u1 << v2; verts << x1 << y2; // Bottom left
+    texCoords << u1 << v2; verts << x1 << y2; // Bottom left
+    texCoords << u2 << v2; verts << x2 << y2; // Bottom right
+    texCoords << u2 << v1; verts << x2 << y1; // Top right
+    GLVertexBuffer *vbo = GLVertexBuffer::streamingBuffer();
+    vbo->reset();
+    vbo->setData(6, 2, verts.constData(), texCoords.constData());
+    vbo->render(GL_TRIANGLES);
+}
+
+void LanczosFilter::updateCacheTexture(EffectWindowImpl *w, int mask, const WindowPaintData &data, GLTexture *cache,
+                                       const QRect &sourceRect, const LanczosRefilter &refilter)
+{
+    const int sw = sourceRect.width();
+    const int sh = sourceRect.height();
+    const int tw = cache->width();
+    const int th = cache->height();
+    const float dx = sw / float(tw);
+    const float dy = sh / float(th);
+    const QRect paintRect = refilter.paintRect();
+    const QRect horizontalRect = refilter.horizontalRect();
+    const QRect target = refilter.targetRect();
+
+    WindowPaintData thumbData = data;
+    thumbData.setXScale(1.0);
+    thumbData.setYScale(1.0);
+    thumbData.setXTranslation(-w->x() - sourceRect.x());
+    thumbData.setYTranslation(-w->y() - sourceRect.y());
+    thumbData.setBrightness(1.0);
+    thumbData.setOpacity(1.0);
+    thumbData.setSaturation(1.0);
+
+    // Bind the offscreen FBO and draw the needed part of the window on it unscaled
+    updateOffscreenSurfaces();
+    const int offscreenHeight = m_offscreenTex->height();
+    GLRenderTarget::pushRenderTarget(m_offscreenTarget);
+
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    // The whole window is painted, as for a full refilter. The clip region of the scene is
+    // in screen coordinates, while the window is translated into the offscreen surface. Only
+    // the copies and the filter passes below are restricted to the stale part.
+    w->sceneWindow()->performPaint(mask, infiniteRegion(), thumbData);
+
+    // Create a scratch texture and copy the rendered window into it
+    GLTexture tex(sw, sh);
+    tex.setFilter(GL_LINEAR);
+    tex.setWrapMode(GL_CLAMP_TO_EDGE);
+    tex.bind();
+
+    copyToTexture(paintRect, sh, offscreenHeight);
+
+    // Set up the shader for horizontal scaling
+    int kernelSize;
+    createKernel(dx, &kernelSize);
+    createOffsets(kernelSize, sw, Qt::Horizontal);
+
+    ShaderManager::instance()->pushShader(m_shader.data());
+    setUniforms();
+
+    // Draw the window back into the FBO, this time scaled horizontally.
+    // Only the target columns and the source rows needed for the vertical pass are drawn.
+    glClear(GL_COLOR_BUFFER_BIT);
+    renderRect(horizontalRect, tw, sh);
+
+    // At this point we don't need the scratch texture anymore
+    tex.unbind();
+    tex.discard();
+
+    // create scratch texture for second rendering pass
+    GLTexture tex2(tw, sh);
+    tex2.setFilter(GL_LINEAR);
+    tex2.setWrapMode(GL_CLAMP_TO_EDGE);
+    tex2.bind();
+
+    copyToTexture(horizontalRect, sh, offscreenHeight);
+
+    // Set up the shader for vertical scaling
+    createKernel(dy, &kernelSize);
+    createOffsets(kernelSize, offscreenHeight, Qt::Vertical);
+    setUniforms();
+
+    // Now draw the horizontally scaled window in the FBO while scaling it vertically
+    glClear(GL_COLOR_BUFFER_BIT);
+    renderRect(target, tw, th);
+
+    tex2.unbind();
+    tex2.discard();
+    ShaderManager::instance()->popShader();
+
+    // update the affected part of the cache texture
+    cache->bind();
+    copyToTexture(target, th, offscreenHeight);
+    cache->unbind();
+    GLRenderTarget::popRenderTarget();
+}
+
 void LanczosFilter::timerEvent(QTimerEvent *event)
 {
     if (event->timerId() == m_timer.timerId()) {
@@ -381,27 +404,31 @@ void LanczosFilter::timerEvent(QTimerEvent *event)
         delete m_offscreenTex;
         m_offscreenTarget = 0;
         m_offscreenTex = 0;
-        foreach (Client *c, Workspace::self()->clientList()) {
-            discardCacheTexture(c->effectWindow());
-        }
-        foreach (Client *c, Workspace::self()->desktopList()) {
-            discardCacheTexture(c->effectWindow());
-        }
-        foreach (Unmanaged *u, Workspace::self()->unmanagedList()) {
-            discardCacheTexture(u->effectWindow());
-        }
-        foreach (Deleted *d, Workspace::self()->deletedList()) {
-            discardCacheTexture(d->effectWindow());
-        }
+        discardCache();
+    }
+}
+
+void LanczosFilter::discardCache()
+{
+    while (!m_cache.isEmpty()) {
+        delete m_cache.first();
+    }
+}
+
+void LanczosFilter::touchCacheEntry(LanczosCacheEntry *entry)
+{
+    if (!m_cache.isEmpty() && m_cache.last() == entry) {
+        return;
     }
+    m_cache.removeOne(entry);
+    m_cache.append(entry);
 }
 
-void LanczosFilter::discardCacheTexture(EffectWindow *w)
+void LanczosFilter::enforceCacheBudget(LanczosCacheEntry *keep)
 {
-    QVariant cachedTextureVariant = w->data(LanczosCacheRole);
-    if (cachedTextureVariant.isValid()) {
-        delete static_cast< GLTexture*>(cachedTextureVariant.value<void*>());
-        w->setData(LanczosCacheRole, QVariant());
+    // evict the least recently used textures, the entry which is about to be painted is always kept
+    while (m_cacheSize > s_cacheBudget && !m_cache.isEmpty() && m_cache.first() != keep) {
+        delete m_cache.first();
     }
 }
 
@@ -24,6 +24,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QObject>
 #include <QBasicTimer>
+#include <QList>
+#include <QRegion>
 #include <QVector>
 #include <QVector2D>
 #include <QVector4D>
@@ -40,6 +42,62 @@ class GLTexture;
 class GLRenderTarget;
 class GLShader;
 
+class LanczosFilter;
+class LanczosRefilter;
+
+/**
+ * @short Cached lanczos downscale of one window.
+ *
+ * The entry is stored in the LanczosCacheRole of the EffectWindow. Instead of throwing
+ * the cached texture away on every damage event the Compositor only records the damaged
+ * area through addDamage() and the LanczosFilter refilters just the stale part of the
+ * texture the next time the window is painted scaled.
+ *
+ * The entry unregisters itself from the owning LanczosFilter when it gets deleted, which
+ * happens either on eviction or when the EffectWindow is destroyed.
+ **/
+class LanczosCacheEntry
+{
+public:
+    LanczosCacheEntry(LanczosFilter *filter, EffectWindow *w, GLTexture *texture);
+    ~LanczosCacheEntry();
+
+    GLTexture *texture() const {
+        return m_texture;
+    }
+    /**
+     * The area of the window which changed since the texture was last updated,
+     * in window (frame) coordinates.
+     **/
+    const QRegion &staleRegion() const {
+        return m_stale;
+    }
+    void markUpdated() {
+        m_stale = QRegion();
+    }
+    /**
+     * Size of the cached texture in bytes, used for the memory budget.
+     **/
+    qint64 size() const;
+
+    /**
+     * Marks @p region (in window coordinates) of the window @p w as stale in the
+     * cached texture, if @p w has one.
+     **/
+    static void addDamage(EffectWindow *w, const QRegion &region);
+    /**
+     * @returns the cache entry of @p w or @c null if there is none.
+     **/
+    static LanczosCacheEntry *fromWindow(EffectWindow *w);
+
+private:
+    friend class LanczosFilter;
+    LanczosFilter *m_filter;
+    EffectWindow *m_window;
+    GLTexture *m_texture;
+    QRegion m_stale;
+};
+
 class LanczosFilter
     : public QObject
 {
@@ -56,7 +114,11 @@ private:
     void init();
     void updateOffscreenSurfaces();
     void setUniforms();
-    void discardCacheTexture(EffectWindow *w);
+    void touchCacheEntry(LanczosCacheEntry *entry);
+    void enforceCacheBudget(LanczosCacheEntry *keep);
+    void updateCacheTexture(EffectWindowImpl *w, int mask, const WindowPaintData &data, GLTexture *cache,
+                            const QRect &sourceRect, const LanczosRefilter &refilter);
+    void discardCache();
 
     void createKernel(float delta, int *kernelSize);
     void createOffsets(int count, float width, Qt::Orientation direction);
@@ -70,6 +132,12 @@ private:
     int m_uKernel;
     QVector2D m_offsets[16];
     QVector4D m_kernel[16];
+    /**
+     * Cache entries ordered by last use, least recently used first.
+     **/
+    QList<LanczosCacheEntry*> m_cache;
+    qint64 m_cacheSize;
+    friend class LanczosCacheEntry;
 };
 
 } // namespace
@@ -0,0 +1,91 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "lanczosrefilter.h"
+
+#include <qmath.h>
+#include <cmath>
+
+namespace KWin
+{
+
+LanczosRefilter::LanczosRefilter(const QRect &sourceRect, const QSize &targetSize, const QRegion &stale)
+    : m_targetSize(targetSize)
+{
+    const QRect source(QPoint(0, 0), sourceRect.size());
+    const QRect dirty = stale.boundingRect().translated(-sourceRect.topLeft()) & source;
+    if (dirty.isEmpty() || targetSize.isEmpty()) {
+        return;
+    }
+    const float dx = sourceRect.width() / float(targetSize.width());
+    const float dy = sourceRect.height() / float(targetSize.height());
+
+    // The kernel reaches up to 2 * delta - 1 samples to each side, the linear
+    // texture lookups one more source pixel.
+    const int rx = qCeil(dx * 2.0) + 1;
+    const int ry = qCeil(dy * 2.0) + 1;
+    const QRect affected = dirty.adjusted(-rx, -ry, rx, ry) & source;
+    m_paintRect = dirty.adjusted(-2 * rx, -2 * ry, 2 * rx, 2 * ry) & source;
+    m_targetRect = QRect(QPoint(qFloor(affected.left() / dx), qFloor(affected.top() / dy)),
+                         QPoint(qCeil((affected.right() + 1) / dx) - 1, qCeil((affected.bottom() + 1) / dy) - 1))
+                   & QRect(QPoint(0, 0), targetSize);
+}
+
+static float sinc(float x)
+{
+    return std::sin(x * M_PI) / (x * M_PI);
+}
+
+static float lanczos(float x, float a)
+{
+    if (qFuzzyCompare(x + 1.0, 1.0))
+        return 1.0;
+
+    if (qAbs(x) >= a)
+        return 0.0;
+
+    return sinc(x) * sinc(x / a);
+}
+
+QVector<float> LanczosRefilter::kernel(float delta)
+{
+    const float a = 2.0;
+
+    // The two outermost samples always fall at points where the lanczos
+    // function returns 0, so we'll skip them.
+    const int sampleCount = qBound(3, qCeil(delta * a) * 2 + 1 - 2, 29);
+    const int center = sampleCount / 2;
+    const int kernelSize = center + 1;
+    const float factor = 1.0 / delta;
+
+    QVector<float> values(kernelSize);
+    float sum = 0;
+
+    for (int i = 0; i < kernelSize; i++) {
+        const float val = lanczos(i * factor, a);
+        sum += i > 0 ? val * 2 : val;
+        values[i] = val;
+    }
+
+    // Normalize the kernel
+    for (int i = 0; i < kernelSize; i++) {
+        values[i] /= sum;
+    }
+    return values;
+}
+
+} // namespace
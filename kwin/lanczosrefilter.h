@@ -0,0 +1,94 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#ifndef KWIN_LANCZOSREFILTER_H
+#define KWIN_LANCZOSREFILTER_H
+
+#include <QRect>
+#include <QRegion>
+#include <QSize>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * @short The part of a lanczos downscale which depends on a stale area of the source.
+ *
+ * Each target pixel is filtered from the source pixels within the kernel radius, so a
+ * stale source area affects all target pixels within that radius. To refilter those
+ * pixels the source has to be rendered including another radius around them.
+ *
+ * All source areas are relative to the top left corner of the downscaled part of the
+ * window, all target areas relative to the top left corner of the target.
+ **/
+class LanczosRefilter
+{
+public:
+    /**
+     * @param sourceRect the part of the window which is downscaled, in window coordinates
+     * @param targetSize the size @p sourceRect is downscaled to
+     * @param stale the area of the window which changed, in window coordinates
+     **/
+    LanczosRefilter(const QRect &sourceRect, const QSize &targetSize, const QRegion &stale);
+
+    /**
+     * The area of the source which has to be rendered to refilter targetRect().
+     **/
+    const QRect &paintRect() const {
+        return m_paintRect;
+    }
+    /**
+     * The rows of paintRect() in the columns of targetRect(), which the horizontal pass
+     * has to produce for the vertical pass.
+     **/
+    QRect horizontalRect() const {
+        return QRect(m_targetRect.x(), m_paintRect.y(), m_targetRect.width(), m_paintRect.height());
+    }
+    /**
+     * The area of the target which has to be refiltered.
+     **/
+    const QRect &targetRect() const {
+        return m_targetRect;
+    }
+    /**
+     * @returns @c true if the whole target has to be refiltered.
+     **/
+    bool isFull() const {
+        return m_targetRect == QRect(QPoint(0, 0), m_targetSize);
+    }
+    bool isEmpty() const {
+        return m_targetRect.isEmpty();
+    }
+
+    /**
+     * The normalized lanczos kernel for downscaling by @p delta source pixels per target
+     * pixel. The first value is the weight of the center sample, the others are the weights
+     * of the samples on both sides of it.
+     **/
+    static QVector<float> kernel(float delta);
+
+private:
+    QSize m_targetSize;
+    QRect m_paintRect;
+    QRect m_targetRect;
+};
+
+} // namespace
+
+#endif // KWIN_LANCZOSREFILTER_H
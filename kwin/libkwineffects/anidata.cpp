@@ -22,6 +22,8 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <KDebug>
 
+#include <QPair>
+
 QDebug operator<<(QDebug dbg, const KWin::AniData &a)
 {
     dbg.nospace() << a.debugInfo();
@@ -31,12 +33,22 @@ QDebug operator<<(QDebug dbg, const KWin::AniData &a)
 using namespace KWin;
 static int Gaussian = 46;
 
+// the easing curves are evaluated by linear interpolation between these many samples
+static const int s_easingSamples = 256;
+// distinct curves (eg. through different amplitudes) beyond this are sampled but not shared
+static const int s_maxEasingTables = 32;
+
+typedef QList< QPair<QEasingCurve, QVector<float> > > EasingTables;
+Q_GLOBAL_STATIC(EasingTables, s_easingTables)
+
 AniData::AniData()
 {
     attribute = AnimationEffect::Opacity;
     windowType = (NET::WindowTypeMask)0;
     duration = time = meta = startTime = 0;
     waitAtSource = keepAtTarget = false;
+    started = false;
+    frameProgress = 0.0;
 }
 
 AniData::AniData(AnimationEffect::Attribute a, int meta, int ms, const FPx2 &to,
@@ -52,6 +64,9 @@ AniData::AniData(AnimationEffect::Attribute a, int meta, int ms, const FPx2 &to,
     this->waitAtSource = waitAtSource;
     this->keepAtTarget = keepAtTarget;
     startTime = AnimationEffect::clock() + delay;
+    started = delay <= 0;
+    frameProgress = 0.0;
+    easing = easingTable(curve);
 }
 
 AniData::AniData(const AniData &other)
@@ -68,6 +83,45 @@ AniData::AniData(const AniData &other)
     waitAtSource = other.waitAtSource;
     keepAtTarget = other.keepAtTarget;
     startTime = other.startTime;
+    started = other.started;
+    frameProgress = other.frameProgress;
+    easing = other.easing;
+}
+
+QVector<float> AniData::easingTable(const QEasingCurve &curve)
+{
+    EasingTables *tables = s_easingTables();
+    for (EasingTables::const_iterator it = tables->constBegin(), end = tables->constEnd(); it != end; ++it) {
+        if (it->first == curve)
+            return it->second;
+    }
+    QVector<float> table(s_easingSamples + 1);
+    for (int i = 0; i <= s_easingSamples; ++i)
+        table[i] = curve.valueForProgress(qreal(i) / s_easingSamples);
+    if (tables->count() < s_maxEasingTables)
+        tables->append(qMakePair(curve, table));
+    return table;
+}
+
+float AniData::easedProgress(float progress) const
+{
+    if (easing.isEmpty())
+        return curve.valueForProgress(progress);
+    const float pos = qBound(0.0f, progress, 1.0f) * s_easingSamples;
+    const int i = qMin(int(pos), s_easingSamples - 1);
+    const float *values = easing.constData();
+    return values[i] + (pos - i) * (values[i + 1] - values[i]);
+}
+
+void AniData::evaluate(qint64 now)
+{
+    started = startTime <= now;
+    if (!started)
+        frameProgress = 0.0;
+    else if (time < duration)
+        frameProgress = easedProgress(float(time) / duration);
+    else
+        frameProgress = 1.0; // we're done and "waiting" at the target value
 }
 
 static FPx2 fpx2(const QString &s, AnimationEffect::Attribute a)
@@ -105,6 +159,8 @@ AniData::AniData(const QString &str) // format: WindowMask:Attribute:Meta:Durati
     time = 0;
     duration = 1; // invalidate
     customCurve = 0; // Linear
+    started = false;
+    frameProgress = 0.0;
 
     QStringList animation = str.split(':');
     if (animation.count() < 5)
@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "kwinanimationeffect.h"
 #include <QEasingCurve>
+#include <QVector>
 #include <netwm.h>
 
 namespace KWin {
@@ -38,6 +39,11 @@ public:
     inline bool isOneDimensional() const {
         return from[0] == from[1] && to[0] == to[1];
     }
+    /**
+     * Updates started and frameProgress for the frame starting at @p now.
+     * Called once per frame, the paint passes only read the result.
+     **/
+    void evaluate(qint64 now);
     static QList<AniData> list(const QString &str);
     QString toString() const;
     QString debugInfo() const;
@@ -50,6 +56,12 @@ public:
     qint64 startTime;
     NET::WindowTypeMask windowType;
     bool waitAtSource, keepAtTarget;
+    bool started;
+    float frameProgress;
+    QVector<float> easing; // sampled curve, shared by all animations with an equal curve
+private:
+    float easedProgress(float progress) const;
+    static QVector<float> easingTable(const QEasingCurve &curve);
 };
 
 } // namespace
@@ -257,14 +257,17 @@ void AnimationEffect::prePaintScreen( ScreenPrePaintData& data, int time )
     d->m_animationsTouched = false;
     AniMap::iterator entry = d->m_animations.begin(), mapEnd = d->m_animations.end();
     d->m_animated = false;
+    // all animations are evaluated against the same time, the paint passes use the result
+    const qint64 now = clock();
 //     short int transformed = 0;
     while (entry != mapEnd) {
         bool invalidateLayerRect = false;
         QList<AniData>::iterator anim = entry->first.begin(), animEnd = entry->first.end();
         int animCounter = 0;
         while (anim != animEnd) {
-            if (anim->startTime > clock()) {
+            if (anim->startTime > now) {
                 if (!anim->waitAtSource) {
+                    anim->evaluate(now);
                     ++anim;
                     ++animCounter;
                     continue;
@@ -276,6 +279,7 @@ void AnimationEffect::prePaintScreen( ScreenPrePaintData& data, int time )
             if (anim->time < anim->duration || anim->keepAtTarget) {
 //                 if (anim->attribute != Brightness && anim->attribute != Saturation && anim->attribute != Opacity)
 //                     transformed = true;
+                anim->evaluate(now);
                 d->m_animated = true;
                 ++anim;
                 ++animCounter;
@@ -437,7 +441,7 @@ void AnimationEffect::prePaintWindow( EffectWindow* w, WindowPrePaintData& data,
         if ( entry != d->m_animations.constEnd() ) {
             bool isUsed = false;
             for (QList<AniData>::const_iterator anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim) {
-                if (anim->startTime > clock() && !anim->waitAtSource)
+                if (!anim->started && !anim->waitAtSource)
                     continue;
 
                 isUsed = true;
@@ -482,7 +486,7 @@ void AnimationEffect::paintWindow( EffectWindow* w, int mask, QRegion region, Wi
         if ( entry != d->m_animations.constEnd() ) {
             for ( QList<AniData>::const_iterator anim = entry->first.constBegin(); anim != entry->first.constEnd(); ++anim ) {
 
-                if (anim->startTime > clock() && !anim->waitAtSource)
+                if (!anim->started && !anim->waitAtSource)
                     continue;
 
                 switch (anim->attribute) {
@@ -600,7 +604,7 @@ void AnimationEffect::postPaintScreen()
                 bool addRepaint = false;
                 QList<AniData>::const_iterator anim = it->first.constBegin();
                 for (; anim != it->first.constEnd(); ++anim) {
-                    if (anim->startTime > clock())
+                    if (!anim->started)
                         continue;
                     if (anim->time < anim->duration) {
                         addRepaint = true;
@@ -618,20 +622,17 @@ void AnimationEffect::postPaintScreen()
 
 float AnimationEffect::interpolated( const AniData &a, int i ) const
 {
-    if (a.startTime > clock())
+    if (!a.started)
         return a.from[i];
     if (a.time < a.duration)
-        return a.from[i] + a.curve.valueForProgress( ((float)a.time)/a.duration )*(a.to[i] - a.from[i]);
+        return a.from[i] + a.frameProgress*(a.to[i] - a.from[i]);
     return a.to[i]; // we're done and "waiting" at the target value
 }
 
 float AnimationEffect::progress( const AniData &a ) const
 {
-    if (a.startTime > clock())
-        return 0.0;
-    if (a.time < a.duration)
-        return a.curve.valueForProgress( ((float)a.time)/a.duration );
-    return 1.0; // we're done and "waiting" at the target value
+    // evaluated in prePaintScreen
+    return a.frameProgress;
 }
 
 
@@ -1348,8 +1348,7 @@ PaintClipper::Iterator::Iterator()
     }
 #ifdef KWIN_HAVE_XRENDER_COMPOSITING
     if (clip() && effects->compositingType() == XRenderCompositing) {
-        XFixesRegion region(paintArea());
-        xcb_xfixes_set_picture_clip_region(connection(), effects->xrenderBufferPicture(), region, 0, 0);
+        xRenderSetClip(effects->xrenderBufferPicture(), paintArea());
     }
 #endif
 }
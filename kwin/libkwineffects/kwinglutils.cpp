@@ -1565,6 +1565,14 @@ struct VertexAttrib
 //*********************************
 // GLVertexBufferPrivate
 //*********************************
+#ifndef KWIN_HAVE_OPENGLES
+struct BufferFence
+{
+    GLsync sync;
+    intptr_t nextEnd; // the buffer end for the next lap once the fence has signalled
+};
+#endif
+
 class GLVertexBufferPrivate
 {
 public:
@@ -1576,6 +1584,13 @@ public:
         , mappedSize(0)
         , nextOffset(0)
         , baseAddress(0)
+#ifndef KWIN_HAVE_OPENGLES
+        , persistent(usageHint == GLVertexBuffer::Stream && GLVertexBufferPrivate::hasBufferStorage)
+        , persistentMap(0)
+        , bufferEnd(0)
+        , frameSize(0)
+        , lastFrameSize(0)
+#endif
     {
         if (GLVertexBufferPrivate::supported)
             glGenBuffers(1, &buffer);
@@ -1594,6 +1609,10 @@ public:
     }
 
     ~GLVertexBufferPrivate() {
+#ifndef KWIN_HAVE_OPENGLES
+        foreach (const BufferFence &fence, fences)
+            glDeleteSync(fence.sync);
+#endif
         if (GLVertexBufferPrivate::supported)
             glDeleteBuffers(1, &buffer);
     }
@@ -1603,6 +1622,12 @@ public:
     void unbindArrays();
     void reallocateBuffer(size_t size);
     GLvoid *mapNextFreeRange(size_t size);
+#ifndef KWIN_HAVE_OPENGLES
+    bool reallocatePersistentBuffer(size_t size);
+    GLvoid *getIdleRange(size_t size);
+    void emitFence(intptr_t nextEnd);
+    void waitForFence(const BufferFence &fence);
+#endif
 
     GLuint buffer;
     GLenum usage;
@@ -1623,6 +1648,16 @@ public:
     Bitfield enabledArrays;
 #ifndef KWIN_HAVE_OPENGLES
     static IndexBuffer *s_indexBuffer;
+    static bool hasBufferStorage;
+
+    // Persistently mapped ring buffer, used for streaming buffers when
+    // GL_ARB_buffer_storage and GL_ARB_sync are available
+    bool persistent;
+    GLvoid *persistentMap;
+    QList<BufferFence> fences;
+    intptr_t bufferEnd;
+    size_t frameSize;
+    size_t lastFrameSize;
 #endif
 };
 
@@ -1632,6 +1667,7 @@ bool GLVertexBufferPrivate::supportsIndexedQuads = false;
 GLVertexBuffer *GLVertexBufferPrivate::streamingBuffer = NULL;
 #ifndef KWIN_HAVE_OPENGLES
 IndexBuffer *GLVertexBufferPrivate::s_indexBuffer = NULL;
+bool GLVertexBufferPrivate::hasBufferStorage = false;
 #endif
 
 void GLVertexBufferPrivate::interleaveArrays(float *dst, int dim,
@@ -1766,6 +1802,104 @@ GLvoid *GLVertexBufferPrivate::mapNextFreeRange(size_t size)
     return glMapBufferRange(GL_ARRAY_BUFFER, nextOffset, size, access);
 }
 
+#ifndef KWIN_HAVE_OPENGLES
+bool GLVertexBufferPrivate::reallocatePersistentBuffer(size_t size)
+{
+    if (persistentMap) {
+        // Deleting the buffer also unmaps it. Draw calls that are still in
+        // flight keep the old data store alive until they are done.
+        glDeleteBuffers(1, &buffer);
+        glGenBuffers(1, &buffer);
+        persistentMap = 0;
+    }
+
+    foreach (const BufferFence &fence, fences)
+        glDeleteSync(fence.sync);
+    fences.clear();
+
+    // Make room for at least three frames, so that we rarely have to wait
+    // for the GPU to release a range
+    const size_t minSize = qMax<size_t>(lastFrameSize * 3, 128 * 1024);
+    const size_t alloc = align(qMax(size, minSize), 64 * 1024);
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferStorage(GL_ARRAY_BUFFER, alloc, 0, flags);
+    persistentMap = glMapBufferRange(GL_ARRAY_BUFFER, 0, alloc, flags);
+
+    if (!persistentMap) {
+        // The data store is immutable, so we need a new buffer object for the fallback path
+        kWarning(1212) << "Failed to map the streaming buffer persistently, falling back to orphaning";
+        glDeleteBuffers(1, &buffer);
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        persistent = false;
+        bufferSize = 0;
+        nextOffset = 0;
+        return false;
+    }
+
+    bufferSize = alloc;
+    bufferEnd = alloc;
+    nextOffset = 0;
+    return true;
+}
+
+void GLVertexBufferPrivate::emitFence(intptr_t nextEnd)
+{
+    BufferFence fence;
+    fence.sync = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    fence.nextEnd = nextEnd;
+    fences.append(fence);
+}
+
+void GLVertexBufferPrivate::waitForFence(const BufferFence &fence)
+{
+    GLenum result;
+    do {
+        result = glClientWaitSync(fence.sync, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100 ms
+    } while (result == GL_TIMEOUT_EXPIRED);
+
+    glDeleteSync(fence.sync);
+}
+
+GLvoid *GLVertexBufferPrivate::getIdleRange(size_t size)
+{
+    // Offsets are relative to the start of the current lap through the buffer.
+    // A fence that was emitted when the ring was at offset N in one lap releases
+    // everything up to N in the following lap, which is stored as N + bufferSize.
+    if (!persistentMap || size > bufferSize) {
+        if (!reallocatePersistentBuffer(size * 2))
+            return 0;
+    }
+
+    if (nextOffset + intptr_t(size) > intptr_t(bufferSize)) {
+        // Grow the buffer instead of wrapping around if it does not hold three frames
+        if (lastFrameSize * 3 > bufferSize) {
+            if (!reallocatePersistentBuffer(size))
+                return 0;
+        } else {
+            nextOffset = 0;
+            bufferEnd -= bufferSize;
+            for (int i = 0; i < fences.count(); ++i)
+                fences[i].nextEnd -= bufferSize;
+
+            // Everything up to the end of the buffer was used in the previous lap
+            emitFence(bufferSize);
+        }
+    }
+
+    // Block until the GPU is done with the range
+    while (nextOffset + intptr_t(size) > bufferEnd && !fences.isEmpty()) {
+        const BufferFence fence = fences.takeFirst();
+        waitForFence(fence);
+        bufferEnd = fence.nextEnd;
+    }
+
+    return (GLvoid *) (intptr_t(persistentMap) + nextOffset);
+}
+#endif
+
 
 //*********************************
 // GLVertexBuffer
@@ -1814,6 +1948,14 @@ GLvoid *GLVertexBuffer::map(size_t size)
 
     bool preferBufferSubData = GLPlatform::instance()->preferBufferSubData();
 
+#ifndef KWIN_HAVE_OPENGLES
+    if (d->persistent && !preferBufferSubData) {
+        GLvoid *ptr = d->getIdleRange(size);
+        if (ptr)
+            return ptr;
+    }
+#endif
+
     if (GLVertexBufferPrivate::hasMapBufferRange && !preferBufferSubData)
         return (GLvoid *) d->mapNextFreeRange(size);
 
@@ -1830,6 +1972,17 @@ void GLVertexBuffer::unmap()
 {
     bool preferBufferSubData = GLPlatform::instance()->preferBufferSubData();
 
+#ifndef KWIN_HAVE_OPENGLES
+    if (d->persistent && !preferBufferSubData) {
+        // The mapping is coherent, there is nothing to flush
+        d->baseAddress = d->nextOffset;
+        d->nextOffset += align(d->mappedSize, 16); // Align to 16 bytes for SSE
+        d->frameSize += d->mappedSize;
+        d->mappedSize = 0;
+        return;
+    }
+#endif
+
     if (GLVertexBufferPrivate::hasMapBufferRange && !preferBufferSubData) {
         glUnmapBuffer(GL_ARRAY_BUFFER);
 
@@ -1989,6 +2142,34 @@ void GLVertexBuffer::reset()
     d->vertexCount    = 0;
 }
 
+void GLVertexBuffer::endOfFrame()
+{
+#ifndef KWIN_HAVE_OPENGLES
+    if (!d->persistent || !d->persistentMap)
+        return;
+
+    // Once the GPU is done with this frame, the next lap may reuse
+    // the buffer up to the current offset
+    if (d->frameSize > 0)
+        d->emitFence(d->nextOffset + d->bufferSize);
+
+    d->lastFrameSize = d->frameSize;
+    d->frameSize = 0;
+
+    // Release the ranges of frames the GPU has already finished, without blocking
+    while (!d->fences.isEmpty()) {
+        const BufferFence &fence = d->fences.first();
+        const GLenum result = glClientWaitSync(fence.sync, 0, 0);
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(fence.sync);
+        d->bufferEnd = fence.nextEnd;
+        d->fences.removeFirst();
+    }
+#endif
+}
+
 void GLVertexBuffer::initStatic()
 {
 #ifdef KWIN_HAVE_OPENGLES
@@ -1999,6 +2180,7 @@ void GLVertexBuffer::initStatic()
     GLVertexBufferPrivate::supported = hasGLVersion(1, 5) || hasGLExtension("GL_ARB_vertex_buffer_object");
     GLVertexBufferPrivate::hasMapBufferRange = hasGLVersion(3, 0) || hasGLExtension("GL_ARB_map_buffer_range");
     GLVertexBufferPrivate::supportsIndexedQuads = glMapBufferRange && glCopyBufferSubData && glDrawElementsBaseVertex;
+    GLVertexBufferPrivate::hasBufferStorage = GLVertexBufferPrivate::supported && glMapBufferRange && glBufferStorage && glFenceSync;
     GLVertexBufferPrivate::s_indexBuffer = 0;
 #endif
     GLVertexBufferPrivate::streamingBuffer = new GLVertexBuffer(GLVertexBuffer::Stream);
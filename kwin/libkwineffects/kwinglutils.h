@@ -781,6 +781,18 @@ public:
      **/
     void reset();
 
+    /**
+     * Notifies the vertex buffer that the current frame has been submitted.
+     *
+     * Streaming buffers are persistently mapped ring buffers when the driver supports
+     * GL_ARB_buffer_storage. All data uploaded in a frame is written into the same
+     * buffer object at increasing offsets, and this method inserts the fence that tells
+     * when the ranges used by the frame can be reused.
+     *
+     * @since 4.12
+     **/
+    void endOfFrame();
+
     /**
      * @internal
      */
@@ -205,6 +205,14 @@ glDrawElementsInstancedBaseVertex_func glDrawElementsInstancedBaseVertex;
 // GL_ARB_copy_buffer
 glCopyBufferSubData_func glCopyBufferSubData;
 
+// GL_ARB_sync
+glFenceSync_func      glFenceSync;
+glClientWaitSync_func glClientWaitSync;
+glDeleteSync_func     glDeleteSync;
+
+// GL_ARB_buffer_storage
+glBufferStorage_func glBufferStorage;
+
 
 static glXFuncPtr getProcAddress(const char* name)
 {
@@ -721,6 +729,24 @@ void glResolveFunctions(OpenGLPlatformInterface platformInterface)
         glCopyBufferSubData = NULL;
     }
 
+    if (hasGLVersion(3, 2) || hasGLExtension("GL_ARB_sync")) {
+        // See http://www.opengl.org/registry/specs/ARB/sync.txt
+        GL_RESOLVE(glFenceSync);
+        GL_RESOLVE(glClientWaitSync);
+        GL_RESOLVE(glDeleteSync);
+    } else {
+        glFenceSync      = NULL;
+        glClientWaitSync = NULL;
+        glDeleteSync     = NULL;
+    }
+
+    if (hasGLVersion(4, 4) || hasGLExtension("GL_ARB_buffer_storage")) {
+        // See http://www.opengl.org/registry/specs/ARB/buffer_storage.txt
+        GL_RESOLVE(glBufferStorage);
+    } else {
+        glBufferStorage = NULL;
+    }
+
 #else
 
     if (hasGLExtension("GL_OES_mapbuffer")) {
@@ -77,6 +77,22 @@ void KWIN_EXPORT glResolveFunctions(OpenGLPlatformInterface platformInterface);
 #define GL_READ_FRAMEBUFFER               0x8CA8
 #endif
 
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+typedef struct __GLsync *GLsync;
+typedef uint64_t GLuint64;
+#define GL_SYNC_GPU_COMMANDS_COMPLETE     0x9117
+#define GL_SYNC_FLUSH_COMMANDS_BIT        0x00000001
+#define GL_ALREADY_SIGNALED               0x911A
+#define GL_TIMEOUT_EXPIRED                0x911B
+#define GL_CONDITION_SATISFIED            0x911C
+#define GL_WAIT_FAILED                    0x911D
+#endif
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_MAP_COHERENT_BIT               0x0080
+#endif
+
 
 #include <fixx11h.h>
 
@@ -468,6 +484,20 @@ typedef void (*glCopyBufferSubData_func)(GLenum readTarget, GLenum writeTarget,
 
 extern KWIN_EXPORT glCopyBufferSubData_func glCopyBufferSubData;
 
+// GL_ARB_sync
+typedef GLsync (*glFenceSync_func)(GLenum condition, GLbitfield flags);
+typedef GLenum (*glClientWaitSync_func)(GLsync sync, GLbitfield flags, GLuint64 timeout);
+typedef void (*glDeleteSync_func)(GLsync sync);
+
+extern KWIN_EXPORT glFenceSync_func      glFenceSync;
+extern KWIN_EXPORT glClientWaitSync_func glClientWaitSync;
+extern KWIN_EXPORT glDeleteSync_func     glDeleteSync;
+
+// GL_ARB_buffer_storage
+typedef void (*glBufferStorage_func)(GLenum target, GLsizeiptr size, const GLvoid *data, GLbitfield flags);
+
+extern KWIN_EXPORT glBufferStorage_func glBufferStorage;
+
 } // namespace
 
 #endif // not KWIN_HAVE_OPENGLES
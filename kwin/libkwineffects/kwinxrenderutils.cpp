@@ -67,7 +67,12 @@ XRenderPicture xRenderBlendPicture(double opacity)
 {
     static XRenderPicture s_blendPicture(XCB_RENDER_PICTURE_NONE);
     static xcb_render_color_t s_blendColor = {0, 0, 0, 0};
-    s_blendColor.alpha = uint16_t(opacity * 0xffff);
+    const uint16_t alpha = uint16_t(opacity * 0xffff);
+    if (s_blendPicture != XCB_RENDER_PICTURE_NONE && s_blendColor.alpha == alpha) {
+        // windows usually ask for the same opacity for all their parts
+        return s_blendPicture;
+    }
+    s_blendColor.alpha = alpha;
     if (s_blendPicture == XCB_RENDER_PICTURE_NONE) {
         s_blendPicture = xRenderFill(s_blendColor);
     } else {
@@ -77,6 +82,21 @@ XRenderPicture xRenderBlendPicture(double opacity)
     return s_blendPicture;
 }
 
+void xRenderSetClip(xcb_render_picture_t pic, const QRegion &region)
+{
+    const QVector<QRect> rects = region.rects();
+    QVector<xcb_rectangle_t> xrects(rects.count());
+    for (int i = 0; i < rects.count(); ++i) {
+        const QRect &rect = rects.at(i);
+        xcb_rectangle_t &xrect = xrects[i];
+        xrect.x = rect.x();
+        xrect.y = rect.y();
+        xrect.width = rect.width();
+        xrect.height = rect.height();
+    }
+    xcb_render_set_picture_clip_rectangles(connection(), pic, 0, 0, xrects.count(), xrects.constData());
+}
+
 static xcb_render_picture_t createPicture(xcb_pixmap_t pix, int depth)
 {
     if (pix == XCB_PIXMAP_NONE)
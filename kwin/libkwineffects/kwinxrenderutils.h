@@ -163,6 +163,12 @@ KWIN_EXPORT XRenderPicture xRenderBlendPicture(double opacity);
 KWIN_EXPORT XRenderPicture xRenderFill(const xcb_render_color_t &c);
 KWIN_EXPORT XRenderPicture xRenderFill(const QColor &c);
 
+/**
+ * Clips @p pic to @p region. Unlike setting an XFixesRegion as clip this does not need
+ * to create a server side region, the rects are sent with a single request.
+ */
+KWIN_EXPORT void xRenderSetClip(xcb_render_picture_t pic, const QRegion &region);
+
 /**
  * Allows to render a window into a (transparent) pixmap
  * NOTICE: the result can be queried as xRenderWindowOffscreenTarget()
@@ -59,6 +59,18 @@ bool Client::manage(xcb_window_t w, bool isMapped)
         return false;
     }
 
+    // Request all the properties read during manage at once, the replies are only waited for
+    // when they are read below. They are requested only once the window is known to exist.
+    Xcb::Property wmHints(w, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 0, 9);
+    Xcb::Property classHint(w, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 2048);
+    Xcb::Property windowRole(w, atoms->wm_window_role, XCB_ATOM_STRING, 0, 10000);
+    Xcb::Property clientLeader(w, atoms->wm_client_leader, XCB_ATOM_WINDOW, 0, 10000);
+    Xcb::TransientFor transientFor(w);
+    Xcb::Property protocols(w, atoms->wm_protocols, XCB_ATOM_ATOM, 0, 2048);
+    Xcb::Property normalHints(w, XCB_ATOM_WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 0, 18);
+    Xcb::Property motifHints(w, atoms->motif_wm_hints, atoms->motif_wm_hints, 0, 5);
+    Xcb::Property opaqueRegion(w, atoms->net_wm_opaque_region, XCB_ATOM_CARDINAL, 0, 32768);
+
     // From this place on, manage() must not return false
     block_geometry_updates = 1;
     pending_geometry_update = PendingGeometryForced; // Force update when finishing with geometry changes
@@ -71,11 +83,11 @@ bool Client::manage(xcb_window_t w, bool isMapped)
     // SELI TODO: Order all these things in some sane manner
 
     bool init_minimize = false;
-    XWMHints* hints = XGetWMHints(display(), w);
-    if (hints && (hints->flags & StateHint) && hints->initial_state == IconicState)
+    uint32_t wmHintsCount = 0;
+    const uint32_t *hints = static_cast<const uint32_t*>(wmHints.value(XCB_ATOM_WM_HINTS, 32, &wmHintsCount));
+    // flags and initial state, see getWMHints()
+    if (hints && wmHintsCount >= 8 && (hints[0] & StateHint) && hints[2] == IconicState)
         init_minimize = true;
-    if (hints)
-        XFree(hints);
     if (isMapped)
         init_minimize = false; // If it's already mapped, ignore hint
 
@@ -104,9 +116,9 @@ bool Client::manage(xcb_window_t w, bool isMapped)
 
     m_colormap = attr.colormap;
 
-    getResourceClass();
-    getWindowRole();
-    getWmClientLeader();
+    getResourceClass(classHint);
+    getWindowRole(windowRole);
+    getWmClientLeader(clientLeader);
     getWmClientMachine();
     getSyncCounter();
     // First only read the caption text, so that setupWindowRules() can use it for matching,
@@ -121,14 +133,14 @@ bool Client::manage(xcb_window_t w, bool isMapped)
     detectShape(window());
     detectNoBorder();
     fetchIconicName();
-    getWMHints(); // Needs to be done before readTransient() because of reading the group
+    getWMHints(wmHints); // Needs to be done before readTransient() because of reading the group
     modal = (info->state() & NET::Modal) != 0;   // Needs to be valid before handling groups
-    readTransient();
+    readTransient(transientFor);
     getIcons();
-    getWindowProtocols();
-    getWmNormalHints(); // Get xSizeHint
-    getMotifHints();
-    getWmOpaqueRegion();
+    getWindowProtocols(protocols);
+    getWmNormalHints(normalHints); // Get xSizeHint
+    getMotifHints(motifHints);
+    getWmOpaqueRegion(opaqueRegion);
 
     // TODO: Try to obey all state information from info->state()
 
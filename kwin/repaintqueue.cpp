@@ -0,0 +1,118 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#include "repaintqueue.h"
+
+namespace KWin
+{
+
+static inline qint64 area(const QRect &rect)
+{
+    return qint64(rect.width()) * rect.height();
+}
+
+RepaintQueue::RepaintQueue()
+    : m_head(NULL)
+{
+}
+
+RepaintQueue::~RepaintQueue()
+{
+    clear();
+}
+
+bool RepaintQueue::post(const QRect &rect)
+{
+    if (rect.isEmpty()) {
+        return false;
+    }
+    Node *node = new Node;
+    node->rect = rect;
+    Node *head;
+    do {
+        head = m_head;
+        node->next = head;
+    } while (!m_head.testAndSetRelease(head, node));
+    return head == NULL;
+}
+
+QVector<QRect> RepaintQueue::take(int maxRects)
+{
+    // the whole list is taken at once, so there is no ABA problem with the producers
+    Node *node = m_head.fetchAndStoreAcquire(NULL);
+    // the list is in reverse order of posting
+    Node *reversed = NULL;
+    while (node) {
+        Node *next = node->next;
+        node->next = reversed;
+        reversed = node;
+        node = next;
+    }
+    QVector<QRect> rects;
+    for (node = reversed; node; node = node->next) {
+        merge(rects, node->rect, maxRects);
+    }
+    deleteList(reversed);
+    return rects;
+}
+
+void RepaintQueue::clear()
+{
+    deleteList(m_head.fetchAndStoreAcquire(NULL));
+}
+
+bool RepaintQueue::isEmpty() const
+{
+    return m_head == NULL;
+}
+
+void RepaintQueue::deleteList(Node *node)
+{
+    while (node) {
+        Node *next = node->next;
+        delete node;
+        node = next;
+    }
+}
+
+void RepaintQueue::merge(QVector<QRect> &rects, const QRect &rect, int maxRects)
+{
+    if (rect.isEmpty()) {
+        return;
+    }
+    int best = -1;
+    qint64 bestGrowth = 0;
+    for (int i = 0; i < rects.count(); ++i) {
+        const QRect &candidate = rects.at(i);
+        if (candidate.contains(rect)) {
+            return;
+        }
+        // how much more is repainted if both are merged
+        const qint64 growth = area(candidate | rect) - area(candidate) - area(rect) + area(candidate & rect);
+        if (best == -1 || growth < bestGrowth) {
+            best = i;
+            bestGrowth = growth;
+        }
+    }
+    if (best != -1 && (bestGrowth <= 0 || rects.count() >= maxRects)) {
+        rects[best] |= rect;
+    } else {
+        rects << rect;
+    }
+}
+
+} // namespace KWin
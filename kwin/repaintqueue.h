@@ -0,0 +1,82 @@
+/********************************************************************
+ KWin - the KDE window manager
+ This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+#ifndef KWIN_REPAINTQUEUE_H
+#define KWIN_REPAINTQUEUE_H
+
+#include <QAtomicPointer>
+#include <QRect>
+#include <QVector>
+
+namespace KWin
+{
+
+/**
+ * @short Collects the areas to repaint until the next frame.
+ *
+ * Rects can be posted from any thread without taking a lock, the posted rects
+ * form a linked list which is swapped out as a whole by take(). Only one thread,
+ * the Compositor's, may call take().
+ *
+ * Instead of uniting every posted rect into a QRegion, take() merges the rects
+ * into a bounded number of rects. Rects are merged into the rect which grows the
+ * least by it, so the result may cover a slightly larger area than was posted.
+ **/
+class RepaintQueue
+{
+public:
+    enum {
+        DefaultMaxRects = 32
+    };
+    RepaintQueue();
+    ~RepaintQueue();
+
+    /**
+     * Adds @p rect to the queue. Thread safe. Empty rects are ignored.
+     * @returns @c true if the queue was empty before, that is the consumer needs to be
+     * woken up.
+     **/
+    bool post(const QRect &rect);
+    /**
+     * Takes all posted rects out of the queue, merged into at most @p maxRects rects.
+     **/
+    QVector<QRect> take(int maxRects = DefaultMaxRects);
+    /**
+     * Drops all posted rects.
+     **/
+    void clear();
+    bool isEmpty() const;
+
+    /**
+     * Adds @p rect to @p rects, merging it with one of the rects if it overlaps or if
+     * @p rects already contains @p maxRects rects.
+     **/
+    static void merge(QVector<QRect> &rects, const QRect &rect, int maxRects);
+
+private:
+    struct Node {
+        QRect rect;
+        Node *next;
+    };
+    static void deleteList(Node *node);
+    QAtomicPointer<Node> m_head;
+    Q_DISABLE_COPY(RepaintQueue)
+};
+
+} // namespace KWin
+
+#endif // KWIN_REPAINTQUEUE_H
@@ -374,6 +374,8 @@ qint64 SceneOpenGL::paint(QRegion damage, ToplevelList toplevels)
 
     m_backend->endRenderingFrame(damage);
 
+    GLVertexBuffer::streamingBuffer()->endOfFrame();
+
     // do cleanup
     stacking_order.clear();
     checkGLError("PostPaint");
@@ -296,6 +296,7 @@ void SceneXrender::windowAdded(Toplevel* c)
 //****************************************
 
 XRenderPicture *SceneXrender::Window::s_tempPicture = 0;
+QList<SceneXrender::Window::TempPicture> SceneXrender::Window::s_tempPictures;
 QRect SceneXrender::Window::temp_visibleRect;
 
 SceneXrender::Window::Window(Toplevel* c)
@@ -312,7 +313,10 @@ SceneXrender::Window::~Window()
 
 void SceneXrender::Window::cleanup()
 {
-    delete s_tempPicture;
+    foreach (const TempPicture &temp, s_tempPictures) {
+        delete temp.picture;
+    }
+    s_tempPictures.clear();
     s_tempPicture = NULL;
 }
 
@@ -366,23 +370,51 @@ QPoint SceneXrender::Window::mapToScreen(int mask, const WindowPaintData &data,
     return pt;
 }
 
+static int tempPictureSizeClass(int size)
+{
+    // 256 pixel steps, so that resizing windows hit the same picture most of the time
+    return (qMax(size, 1) + 255) & ~255;
+}
+
 void SceneXrender::Window::prepareTempPixmap()
 {
-    const QSize oldSize = temp_visibleRect.size();
+    static const int maxTempPictures = 4;
     temp_visibleRect = toplevel->visibleRect().translated(-toplevel->pos());
-    if (s_tempPicture && (oldSize.width() < temp_visibleRect.width() || oldSize.height() < temp_visibleRect.height())) {
-        delete s_tempPicture;
-        s_tempPicture = NULL;
-        scene_setXRenderOffscreenTarget(0); // invalidate, better crash than cause weird results for developers
+    const QSize size = temp_visibleRect.size();
+    // the smallest picture which is large enough
+    int index = -1;
+    for (int i = 0; i < s_tempPictures.count(); ++i) {
+        const QSize &candidate = s_tempPictures.at(i).size;
+        if (candidate.width() < size.width() || candidate.height() < size.height()) {
+            continue;
+        }
+        if (index == -1 || candidate.width() * candidate.height() <
+                s_tempPictures.at(index).size.width() * s_tempPictures.at(index).size.height()) {
+            index = i;
+        }
     }
-    if (!s_tempPicture) {
+    if (index == -1) {
+        if (s_tempPictures.count() == maxTempPictures) {
+            delete s_tempPictures.takeLast().picture;
+            scene_setXRenderOffscreenTarget(0); // invalidate, better crash than cause weird results for developers
+        }
+        TempPicture temp;
+        temp.size = QSize(tempPictureSizeClass(size.width()), tempPictureSizeClass(size.height()));
         xcb_pixmap_t pix = xcb_generate_id(connection());
-        xcb_create_pixmap(connection(), 32, pix, rootWindow(), temp_visibleRect.width(), temp_visibleRect.height());
-        s_tempPicture = new XRenderPicture(pix, 32);
+        xcb_create_pixmap(connection(), 32, pix, rootWindow(), temp.size.width(), temp.size.height());
+        temp.picture = new XRenderPicture(pix, 32);
         xcb_free_pixmap(connection(), pix);
+        s_tempPictures.prepend(temp);
+    } else if (index > 0) {
+        s_tempPictures.move(index, 0);
     }
+    s_tempPicture = s_tempPictures.first().picture;
+    // the picture is larger than the window, clear one more pixel to the right and bottom as well,
+    // so that the bilinear filter of scaled draws samples transparency there and not stale content
+    const QSize &pictureSize = s_tempPictures.first().size;
     const xcb_render_color_t transparent = {0, 0, 0, 0};
-    const xcb_rectangle_t rect = {0, 0, uint16_t(temp_visibleRect.width()), uint16_t(temp_visibleRect.height())};
+    const xcb_rectangle_t rect = {0, 0, uint16_t(qMin(size.width() + 1, pictureSize.width())),
+                                  uint16_t(qMin(size.height() + 1, pictureSize.height()))};
     xcb_render_fill_rectangles(connection(), XCB_RENDER_PICT_OP_SRC, *s_tempPicture, transparent, 1, &rect);
 }
 
@@ -605,10 +637,13 @@ void SceneXrender::Window::performPaint(int mask, QRegion region, WindowPaintDat
 #undef MAP_RECT_TO_TARGET
 
     for (PaintClipper::Iterator iterator; !iterator.isDone(); iterator.next()) {
+        // shadow tiles and decoration parts outside of the painted area are not sent at all
+        const QRect visibleRect = blitInTempPixmap ? infiniteRegion() : iterator.boundingRect();
 
 #define RENDER_SHADOW_TILE(_TILE_, _RECT_) \
-xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, m_xrenderShadow->picture(SceneXRenderShadow::ShadowElement##_TILE_), \
-                 shadowAlpha, renderTarget, 0, 0, 0, 0, _RECT_.x(), _RECT_.y(), _RECT_.width(), _RECT_.height())
+if (_RECT_.intersects(visibleRect)) \
+    xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, m_xrenderShadow->picture(SceneXRenderShadow::ShadowElement##_TILE_), \
+                         shadowAlpha, renderTarget, 0, 0, 0, 0, _RECT_.x(), _RECT_.y(), _RECT_.width(), _RECT_.height())
 
         //shadow
         if (wantShadow) {
@@ -670,8 +705,9 @@ xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, m_xrenderShadow->pic
         }
 
 #define RENDER_DECO_PART(_PART_, _RECT_) \
-xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, _PART_, decorationAlpha, renderTarget,\
-                 0, 0, 0, 0, _RECT_.x(), _RECT_.y(), _RECT_.width(), _RECT_.height())
+if (_RECT_.intersects(visibleRect)) \
+    xcb_render_composite(connection(), XCB_RENDER_PICT_OP_OVER, _PART_, decorationAlpha, renderTarget,\
+                         0, 0, 0, 0, _RECT_.x(), _RECT_.y(), _RECT_.width(), _RECT_.height())
 
         if (client || deleted) {
             if (!noBorder) {
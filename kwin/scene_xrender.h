@@ -93,7 +93,14 @@ private:
     double alpha_cached_opacity;
     QRegion transformed_shape;
     static QRect temp_visibleRect;
+    // the temporary picture used by the current window, taken from s_tempPictures
     static XRenderPicture *s_tempPicture;
+    struct TempPicture {
+        QSize size;
+        XRenderPicture *picture;
+    };
+    // pool of temporary pictures with sizes rounded up to a size class, most recently used first
+    static QList<TempPicture> s_tempPictures;
 };
 
 class XRenderWindowPixmap : public WindowPixmap
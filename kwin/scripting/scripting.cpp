@@ -49,6 +49,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QtDeclarative/QDeclarativeView>
 #include <QtDeclarative/qdeclarative.h>
 #include <QMenu>
+#include <QtScript/QScriptContextInfo>
 #include <QtScript/QScriptEngine>
 #include <QtScript/QScriptValue>
 
@@ -428,11 +429,19 @@ void KWin::AbstractScript::actionDestroyed(QObject *object)
     m_shortcutCallbacks.remove(static_cast<QAction*>(object));
 }
 
+// A handler taking longer than this blocks the compositor for several frames
+static const qint64 s_handlerBudget = 50 * 1000000; // 50 msec
+// A single handler taking longer than this disables the script right away
+static const qint64 s_handlerHardLimit = 1000 * 1000000; // 1 sec
+static const int s_maxBudgetViolations = 10;
+
 KWin::Script::Script(int id, QString scriptName, QString pluginName, QObject* parent)
     : AbstractScript(id, scriptName, pluginName, parent)
     , m_engine(new QScriptEngine(this))
     , m_starting(false)
     , m_agent(new ScriptUnloaderAgent(this))
+    , m_callDepth(0)
+    , m_budgetViolations(0)
 {
     QDBusConnection::sessionBus().registerObject('/' + QString::number(scriptId()), this, QDBusConnection::ExportScriptableContents | QDBusConnection::ExportScriptableInvokables);
 }
@@ -514,6 +523,72 @@ void KWin::Script::sigException(const QScriptValue& exception)
     stop();
 }
 
+void KWin::Script::functionEntered()
+{
+    if (m_callDepth++ > 0) {
+        return;
+    }
+    const QScriptContextInfo info(m_engine->currentContext());
+    const QString name = info.functionName().isEmpty() ? QString("<anonymous>") : info.functionName();
+    m_currentHandler = QString("%1:%2").arg(name).arg(info.functionStartLineNumber());
+    m_handlerTimer.start();
+}
+
+void KWin::Script::functionExited()
+{
+    if (m_callDepth == 0 || --m_callDepth > 0) {
+        return;
+    }
+    const qint64 elapsed = m_handlerTimer.nsecsElapsed();
+    HandlerProfile &handler = m_profile[m_currentHandler];
+    handler.calls++;
+    handler.totalTime += elapsed;
+    handler.maxTime = qMax(handler.maxTime, elapsed);
+
+    if (m_starting || !running()) {
+        // the initial evaluation of the script is allowed to take its time
+        return;
+    }
+    if (elapsed <= s_handlerBudget) {
+        m_budgetViolations = 0;
+        return;
+    }
+    if (elapsed > s_handlerHardLimit || ++m_budgetViolations >= s_maxBudgetViolations) {
+        const QString message = QString("Script %1 disabled: %2 took %3 msec")
+                                .arg(fileName()).arg(m_currentHandler).arg(elapsed / 1000000);
+        kWarning(1212) << message;
+        emit printError(message);
+        setRunning(false);
+        // stop() only schedules the deletion, so it is safe to call while the engine is running
+        stop();
+    }
+}
+
+QStringList KWin::Script::profile() const
+{
+    QMultiMap<qint64, QString> sorted;
+    for (QHash<QString, HandlerProfile>::const_iterator it = m_profile.constBegin();
+            it != m_profile.constEnd(); ++it) {
+        sorted.insert(it->totalTime, QString("%1 calls=%2 total=%3ms max=%4ms")
+                      .arg(it.key())
+                      .arg(it->calls)
+                      .arg(it->totalTime / 1000000.0, 0, 'f', 2)
+                      .arg(it->maxTime / 1000000.0, 0, 'f', 2));
+    }
+    QStringList result;
+    QMapIterator<qint64, QString> it(sorted);
+    it.toBack();
+    while (it.hasPrevious()) {
+        result << it.previous().value();
+    }
+    return result;
+}
+
+void KWin::Script::resetProfile()
+{
+    m_profile.clear();
+}
+
 KWin::ScriptUnloaderAgent::ScriptUnloaderAgent(KWin::Script *script)
     : QScriptEngineAgent(script->engine())
     , m_script(script)
@@ -527,6 +602,19 @@ void KWin::ScriptUnloaderAgent::scriptUnload(qint64 id)
     m_script->stop();
 }
 
+void KWin::ScriptUnloaderAgent::functionEntry(qint64 scriptId)
+{
+    Q_UNUSED(scriptId)
+    m_script->functionEntered();
+}
+
+void KWin::ScriptUnloaderAgent::functionExit(qint64 scriptId, const QScriptValue &returnValue)
+{
+    Q_UNUSED(scriptId)
+    Q_UNUSED(returnValue)
+    m_script->functionExited();
+}
+
 KWin::DeclarativeScript::DeclarativeScript(int id, QString scriptName, QString pluginName, QObject* parent)
     : AbstractScript(id, scriptName, pluginName, parent)
     , m_engine(new QDeclarativeEngine(this))
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <kwinglobals.h>
 #include <kservice.h>
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QHash>
 #include <QStringList>
@@ -228,8 +229,23 @@ public:
         return m_engine;
     }
 
+    /**
+     * Invoked by the ScriptUnloaderAgent whenever a function is entered or left in the engine.
+     * The outermost function call, that is the signal handler or callback invoked by KWin,
+     * is timed for the profile and checked against the watchdog budget.
+     **/
+    void functionEntered();
+    void functionExited();
+
 public Q_SLOTS:
     Q_SCRIPTABLE void run();
+    /**
+     * Returns one line per signal handler or callback which got invoked by KWin, containing
+     * the function name and line, the number of calls, the cumulated and the maximum time
+     * spent in the handler in milliseconds. Sorted by the cumulated time.
+     **/
+    Q_SCRIPTABLE QStringList profile() const;
+    Q_SCRIPTABLE void resetProfile();
 
 Q_SIGNALS:
     Q_SCRIPTABLE void printError(const QString &text);
@@ -251,16 +267,39 @@ private:
      * If file cannot be read an empty byte array is returned.
      **/
     QByteArray loadScriptFromFile();
+    struct HandlerProfile {
+        HandlerProfile()
+            : calls(0)
+            , totalTime(0)
+            , maxTime(0) {}
+        quint32 calls;
+        qint64 totalTime; // in nsec
+        qint64 maxTime; // in nsec
+    };
     QScriptEngine *m_engine;
     bool m_starting;
     QScopedPointer<ScriptUnloaderAgent> m_agent;
+    QHash<QString, HandlerProfile> m_profile;
+    int m_callDepth;
+    QString m_currentHandler;
+    QElapsedTimer m_handlerTimer;
+    /**
+     * Number of consecutive handler invocations exceeding the time budget.
+     **/
+    int m_budgetViolations;
 };
 
+/**
+ * Stops the Script when the engine unloads it and forwards function entry and exit
+ * to the Script for profiling. An engine can only have one agent.
+ **/
 class ScriptUnloaderAgent : public QScriptEngineAgent
 {
 public:
     explicit ScriptUnloaderAgent(Script *script);
     virtual void scriptUnload(qint64 id);
+    virtual void functionEntry(qint64 scriptId);
+    virtual void functionExit(qint64 scriptId, const QScriptValue &returnValue);
 
 private:
     Script *m_script;
@@ -0,0 +1,593 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+/*
+ * Headless compositing benchmark.
+ *
+ * Starts an Xvfb server, a private D-Bus session bus and KWin for each of the
+ * requested scenes. The OpenGL scene runs on Mesa's software rasterizer. Scripted
+ * clients are run against the compositor, after each scenario the frame statistics
+ * of the Compositor (see Compositor::statistics) and the CPU time of the KWin process
+ * are reported as one JSON object per line:
+ *
+ * {"scene":"xrender","scenario":"resize","windows":20,"frames":301,
+ *  "frameTime":{"mean":812,"median":790,"p95":1204,"max":2311},"cpuTime":1340,"roundTrips":12}
+ *
+ * Frame times are in microseconds, the CPU time in milliseconds.
+ *
+ * The blur scenario only runs with the OpenGL scene. It puts translucent windows with
+ * a large blur radius and the downsampled blur over the other windows, and damages
+ * small parts of the windows underneath.
+ *
+ * This is not a unit test, it needs Xvfb and dbus-daemon in the PATH. Run it through the
+ * benchmark-compositing target or directly, see --help.
+ */
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QRect>
+#include <QStringList>
+#include <QTextStream>
+#include <QtDBus/QDBusArgument>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusInterface>
+#include <QtDBus/QDBusReply>
+#include <QtDBus/QDBusVariant>
+
+#include <xcb/xcb.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace
+{
+
+struct Options {
+    Options()
+        : kwin("kwin")
+        , windows(20)
+        , duration(5000)
+        , display(90)
+    {
+        scenes << "xrender" << "opengl";
+    }
+    QString kwin;
+    QStringList scenes;
+    int windows;
+    int duration; // per scenario, in milliseconds
+    int display;
+    QString output;
+};
+
+struct Measurement {
+    QString scene;
+    QString scenario;
+    int windows;
+    QList<qint64> frameTimes;
+    qint64 cpuTime;
+    qulonglong roundTrips;
+};
+
+void sleepMilliseconds(int milliseconds)
+{
+    usleep(milliseconds * 1000);
+}
+
+/**
+ * User and system time of the process @p pid in milliseconds, -1 if unknown.
+ **/
+qint64 cpuTime(Q_PID pid)
+{
+    QFile file(QString("/proc/%1/stat").arg(pid));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QByteArray stat = file.readAll();
+    // the command name might contain spaces, the fields start after its closing paren
+    const QList<QByteArray> fields = stat.mid(stat.lastIndexOf(')') + 2).split(' ');
+    if (fields.count() < 13) {
+        return -1;
+    }
+    // utime and stime are the fields 14 and 15 of the stat file
+    const qint64 ticks = fields.at(11).toLongLong() + fields.at(12).toLongLong();
+    return ticks * 1000 / sysconf(_SC_CLK_TCK);
+}
+
+qint64 percentile(const QList<qint64> &sorted, int percent)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    return sorted.at(qMin(sorted.count() - 1, sorted.count() * percent / 100));
+}
+
+QString toJson(const Measurement &m)
+{
+    QList<qint64> sorted = m.frameTimes;
+    qSort(sorted);
+    qint64 sum = 0;
+    foreach (qint64 time, sorted) {
+        sum += time;
+    }
+    return QString("{\"scene\":\"%1\",\"scenario\":\"%2\",\"windows\":%3,\"frames\":%4,"
+                   "\"frameTime\":{\"mean\":%5,\"median\":%6,\"p95\":%7,\"max\":%8},"
+                   "\"cpuTime\":%9,\"roundTrips\":%10}")
+        .arg(m.scene).arg(m.scenario).arg(m.windows).arg(sorted.count())
+        .arg(sorted.isEmpty() ? 0 : sum / sorted.count())
+        .arg(percentile(sorted, 50)).arg(percentile(sorted, 95))
+        .arg(sorted.isEmpty() ? 0 : sorted.last())
+        .arg(m.cpuTime).arg(m.roundTrips);
+}
+
+/**
+ * The scripted client, all windows are created on its own connection.
+ **/
+class Workload
+{
+public:
+    explicit Workload(xcb_connection_t *c)
+        : m_connection(c)
+        , m_screen(xcb_setup_roots_iterator(xcb_get_setup(c)).data)
+        , m_gc(XCB_NONE)
+        , m_presentWindowsAtom(internAtom("_KDE_PRESENT_WINDOWS_DESKTOP"))
+        , m_blurRegionAtom(internAtom("_KDE_NET_WM_BLUR_BEHIND_REGION"))
+    {
+    }
+
+    void createWindows(int count) {
+        const int columns = qMax(1, int(ceil(sqrt(double(count)))));
+        const int width = m_screen->width_in_pixels / columns;
+        const int height = m_screen->height_in_pixels / columns;
+        for (int i = 0; i < count; ++i) {
+            const uint32_t values[] = { m_screen->white_pixel };
+            xcb_window_t w = xcb_generate_id(m_connection);
+            xcb_create_window(m_connection, XCB_COPY_FROM_PARENT, w, m_screen->root,
+                              (i % columns) * width, (i / columns) * height, width - 20, height - 40, 0,
+                              XCB_WINDOW_CLASS_INPUT_OUTPUT, XCB_COPY_FROM_PARENT, XCB_CW_BACK_PIXEL, values);
+            const QByteArray title = QString("Benchmark %1").arg(i).toLatin1();
+            xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, w, XCB_ATOM_WM_NAME, XCB_ATOM_STRING,
+                                8, title.length(), title.constData());
+            xcb_map_window(m_connection, w);
+            m_windows << w;
+            m_geometries << QRect((i % columns) * width, (i / columns) * height, width - 20, height - 40);
+        }
+        if (m_gc == XCB_NONE && !m_windows.isEmpty()) {
+            m_gc = xcb_generate_id(m_connection);
+            xcb_create_gc(m_connection, m_gc, m_windows.first(), 0, NULL);
+        }
+        xcb_flush(m_connection);
+    }
+
+    void destroyWindows() {
+        foreach (xcb_window_t w, m_windows) {
+            xcb_destroy_window(m_connection, w);
+        }
+        if (m_gc != XCB_NONE) {
+            xcb_free_gc(m_connection, m_gc);
+            m_gc = XCB_NONE;
+        }
+        m_windows.clear();
+        m_geometries.clear();
+        xcb_flush(m_connection);
+    }
+
+    /**
+     * Sets up the scenario @p name before it is measured.
+     **/
+    void prepare(const QString &name) {
+        if (name == "blur") {
+            createBlurWindows();
+        }
+    }
+
+    /**
+     * One step of the scenario @p name, called once per 16 msec. @p step counts from 0.
+     **/
+    void run(const QString &name, int step) {
+        if (name == "map-unmap") {
+            // a window opens or closes in every step, triggering the fade animations
+            xcb_window_t w = m_windows.at((step / 2) % m_windows.count());
+            if (step % 2) {
+                xcb_map_window(m_connection, w);
+            } else {
+                xcb_unmap_window(m_connection, w);
+            }
+        } else if (name == "resize") {
+            const double factor = 0.75 + 0.25 * sin(step / 10.0);
+            for (int i = 0; i < m_windows.count(); ++i) {
+                const uint32_t values[] = { uint32_t(m_geometries.at(i).width() * factor),
+                                            uint32_t(m_geometries.at(i).height() * factor) };
+                xcb_configure_window(m_connection, m_windows.at(i),
+                                     XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT, values);
+            }
+        } else if (name == "damage") {
+            // every window repaints its complete content
+            const uint32_t color = (step % 2) ? m_screen->black_pixel : m_screen->white_pixel;
+            xcb_change_gc(m_connection, m_gc, XCB_GC_FOREGROUND, &color);
+            for (int i = 0; i < m_windows.count(); ++i) {
+                const xcb_rectangle_t rect = { 0, 0, uint16_t(m_geometries.at(i).width()),
+                                               uint16_t(m_geometries.at(i).height()) };
+                xcb_poly_fill_rectangle(m_connection, m_windows.at(i), m_gc, 1, &rect);
+            }
+        } else if (name == "present-windows") {
+            // toggle Present Windows for all desktops about every half second
+            if (step % 30 == 0 && m_presentWindowsAtom != XCB_ATOM_NONE) {
+                const uint32_t desktop = (step / 30) % 2 ? 0 : uint32_t(-1);
+                xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_windows.first(),
+                                    m_presentWindowsAtom, m_presentWindowsAtom, 32, 1, &desktop);
+            }
+        } else if (name == "blur") {
+            // a small area moves through the windows underneath the blurred ones
+            const uint32_t color = (step % 2) ? m_screen->black_pixel : m_screen->white_pixel;
+            xcb_change_gc(m_connection, m_gc, XCB_GC_FOREGROUND, &color);
+            const int i = step % m_windows.count();
+            const QRect &geometry = m_geometries.at(i);
+            const xcb_rectangle_t rect = { int16_t((step * 8) % qMax(1, geometry.width() - 64)),
+                                           int16_t((step * 4) % qMax(1, geometry.height() - 64)), 64, 64 };
+            xcb_poly_fill_rectangle(m_connection, m_windows.at(i), m_gc, 1, &rect);
+        }
+        xcb_flush(m_connection);
+        // nothing is selected, but errors still have to be read
+        while (xcb_generic_event_t *event = xcb_poll_for_event(m_connection)) {
+            free(event);
+        }
+    }
+
+    void finish(const QString &name) {
+        if (name == "map-unmap") {
+            foreach (xcb_window_t w, m_windows) {
+                xcb_map_window(m_connection, w);
+            }
+        } else if (name == "present-windows" && m_presentWindowsAtom != XCB_ATOM_NONE) {
+            const uint32_t desktop = 0;
+            xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, m_windows.first(),
+                                m_presentWindowsAtom, m_presentWindowsAtom, 32, 1, &desktop);
+        } else if (name == "blur") {
+            foreach (xcb_window_t w, m_blurWindows) {
+                xcb_destroy_window(m_connection, w);
+            }
+            m_blurWindows.clear();
+        }
+        xcb_flush(m_connection);
+    }
+
+private:
+    xcb_atom_t internAtom(const char *name) {
+        xcb_atom_t atom = XCB_ATOM_NONE;
+        xcb_intern_atom_cookie_t cookie = xcb_intern_atom(m_connection, false, strlen(name), name);
+        if (xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(m_connection, cookie, NULL)) {
+            atom = reply->atom;
+            free(reply);
+        }
+        return atom;
+    }
+
+    xcb_visualid_t argbVisual() const {
+        for (xcb_depth_iterator_t depths = xcb_screen_allowed_depths_iterator(m_screen);
+                depths.rem; xcb_depth_next(&depths)) {
+            if (depths.data->depth != 32) {
+                continue;
+            }
+            for (xcb_visualtype_iterator_t visuals = xcb_depth_visuals_iterator(depths.data);
+                    visuals.rem; xcb_visualtype_next(&visuals)) {
+                if (visuals.data->_class == XCB_VISUAL_CLASS_TRUE_COLOR) {
+                    return visuals.data->visual_id;
+                }
+            }
+        }
+        return XCB_NONE;
+    }
+
+    /**
+     * Four large translucent windows which ask for the blur behind all of their area.
+     **/
+    void createBlurWindows() {
+        const xcb_visualid_t visual = argbVisual();
+        if (visual == XCB_NONE) {
+            return;
+        }
+        xcb_colormap_t colormap = xcb_generate_id(m_connection);
+        xcb_create_colormap(m_connection, XCB_COLORMAP_ALLOC_NONE, colormap, m_screen->root, visual);
+
+        const int width = m_screen->width_in_pixels * 2 / 5;
+        const int height = m_screen->height_in_pixels * 2 / 5;
+        for (int i = 0; i < 4; ++i) {
+            // half transparent black, the pixel values are premultiplied
+            const uint32_t values[] = { 0x80000000, 0, colormap };
+            xcb_window_t w = xcb_generate_id(m_connection);
+            xcb_create_window(m_connection, 32, w, m_screen->root,
+                              m_screen->width_in_pixels / 20 + (i % 2) * m_screen->width_in_pixels / 2,
+                              m_screen->height_in_pixels / 20 + (i / 2) * m_screen->height_in_pixels / 2,
+                              width, height, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT, visual,
+                              XCB_CW_BACK_PIXEL | XCB_CW_BORDER_PIXEL | XCB_CW_COLORMAP, values);
+            const uint32_t region[] = { 0, 0, uint32_t(width), uint32_t(height) };
+            xcb_change_property(m_connection, XCB_PROP_MODE_REPLACE, w, m_blurRegionAtom, XCB_ATOM_CARDINAL,
+                                32, 4, region);
+            xcb_map_window(m_connection, w);
+            m_blurWindows << w;
+        }
+        xcb_free_colormap(m_connection, colormap);
+        xcb_flush(m_connection);
+        // let KWin manage the windows and finish the opening animations
+        sleepMilliseconds(1000);
+    }
+
+    xcb_connection_t *m_connection;
+    xcb_screen_t *m_screen;
+    xcb_gcontext_t m_gc;
+    xcb_atom_t m_presentWindowsAtom;
+    xcb_atom_t m_blurRegionAtom;
+    QList<xcb_window_t> m_windows;
+    QList<xcb_window_t> m_blurWindows;
+    QList<QRect> m_geometries;
+};
+
+/**
+ * Xvfb, session bus and KWin for one scene.
+ **/
+class Session
+{
+public:
+    Session(const Options &options, const QString &scene)
+        : m_options(options)
+        , m_scene(scene)
+        , m_connection(NULL)
+        , m_displayName(QString(":%1").arg(options.display))
+        , m_bus("benchmark")
+    {
+    }
+    ~Session() {
+        if (m_connection) {
+            xcb_disconnect(m_connection);
+        }
+        QDBusConnection::disconnectFromBus("benchmark");
+        stop(&m_kwin);
+        stop(&m_dbus);
+        stop(&m_xvfb);
+    }
+
+    bool start(QString *error) {
+        m_xvfb.start("Xvfb", QStringList() << m_displayName << "-screen" << "0" << "1920x1080x24"
+                                           << "-nolisten" << "tcp" << "+extension" << "GLX");
+        if (!m_xvfb.waitForStarted()) {
+            *error = "Xvfb could not be started";
+            return false;
+        }
+        for (int i = 0; i < 50 && !m_connection; ++i) {
+            sleepMilliseconds(100);
+            m_connection = xcb_connect(m_displayName.toLatin1().constData(), NULL);
+            if (xcb_connection_has_error(m_connection)) {
+                xcb_disconnect(m_connection);
+                m_connection = NULL;
+            }
+        }
+        if (!m_connection) {
+            *error = "could not connect to " + m_displayName;
+            return false;
+        }
+
+        m_dbus.start("dbus-daemon", QStringList() << "--session" << "--nofork" << "--print-address=1");
+        if (!m_dbus.waitForStarted() || !m_dbus.waitForReadyRead()) {
+            *error = "dbus-daemon could not be started";
+            return false;
+        }
+        const QString address = QString::fromLatin1(m_dbus.readLine()).trimmed();
+
+        // a clean configuration, so that the results do not depend on the user's settings
+        m_home = QDir::temp().absoluteFilePath(QString("kwin-benchmark-%1-%2")
+                                               .arg(QCoreApplication::applicationPid()).arg(m_scene));
+        QDir().mkpath(m_home + "/share/config");
+        QFile config(m_home + "/share/config/kwinrc");
+        if (config.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            // the blur scenario measures the downsampled blur at its largest radius
+            QTextStream(&config) << "[Effect-Blur]\nBlurRadius=14\nDownsampleBlur=true\n";
+        }
+        QStringList environment = QProcess::systemEnvironment();
+        environment << "DISPLAY=" + m_displayName
+                    << "DBUS_SESSION_BUS_ADDRESS=" + address
+                    << "KDEHOME=" + m_home
+                    << QString("KWIN_COMPOSE=") + (m_scene == "opengl" ? "O" : "X")
+                    << "LIBGL_ALWAYS_SOFTWARE=1";
+        m_kwin.setEnvironment(environment);
+        m_kwin.setProcessChannelMode(QProcess::ForwardedChannels);
+        m_kwin.start(m_options.kwin);
+        if (!m_kwin.waitForStarted()) {
+            *error = "KWin could not be started";
+            return false;
+        }
+
+        m_bus = QDBusConnection::connectToBus(address, "benchmark");
+        for (int i = 0; i < 300; ++i) {
+            sleepMilliseconds(100);
+            QDBusInterface compositor("org.kde.KWin", "/Compositor", "org.kde.kwin.Compositing", m_bus);
+            if (compositor.property("active").toBool()) {
+                const QString type = compositor.property("compositingType").toString();
+                if ((m_scene == "opengl") != type.startsWith("gl")) {
+                    *error = "KWin uses the scene " + type;
+                    return false;
+                }
+                QDBusInterface effects("org.kde.KWin", "/Effects", "org.kde.kwin.Effects", m_bus);
+                effects.call("loadEffect", "presentwindows");
+                effects.call("loadEffect", "blur");
+                return true;
+            }
+        }
+        *error = "compositing did not start";
+        return false;
+    }
+
+    Measurement run(Workload *workload, const QString &scenario) {
+        Measurement measurement;
+        measurement.scene = m_scene;
+        measurement.scenario = scenario;
+        measurement.windows = m_options.windows;
+
+        workload->prepare(scenario);
+        QDBusInterface compositor("org.kde.KWin", "/Compositor", "org.kde.kwin.Compositing", m_bus);
+        compositor.call("resetStatistics");
+        const qint64 cpuStart = cpuTime(m_kwin.pid());
+        QElapsedTimer timer;
+        timer.start();
+        int step = 0;
+        while (timer.elapsed() < m_options.duration) {
+            workload->run(scenario, step++);
+            // keep the steps aligned to the timer, also if a step took longer
+            const qint64 next = step * 16;
+            if (next > timer.elapsed()) {
+                sleepMilliseconds(next - timer.elapsed());
+            }
+        }
+        const QDBusReply<QVariantMap> reply = compositor.call("statistics");
+        measurement.cpuTime = cpuTime(m_kwin.pid()) - cpuStart;
+        workload->finish(scenario);
+
+        const QVariantMap statistics = reply.value();
+        measurement.roundTrips = statistics.value("roundTrips").toULongLong();
+        const QVariant frameTimes = statistics.value("frameTimes");
+        if (frameTimes.userType() == qMetaTypeId<QDBusArgument>()) {
+            // QtDBus does not demarshall an array of variants itself
+            const QDBusArgument argument = frameTimes.value<QDBusArgument>();
+            argument.beginArray();
+            while (!argument.atEnd()) {
+                QDBusVariant time;
+                argument >> time;
+                measurement.frameTimes << time.variant().toLongLong();
+            }
+            argument.endArray();
+        } else {
+            foreach (const QVariant &time, frameTimes.toList()) {
+                measurement.frameTimes << time.toLongLong();
+            }
+        }
+        return measurement;
+    }
+
+    xcb_connection_t *connection() const {
+        return m_connection;
+    }
+
+private:
+    static void stop(QProcess *process) {
+        if (process->state() == QProcess::NotRunning) {
+            return;
+        }
+        process->terminate();
+        if (!process->waitForFinished(5000)) {
+            process->kill();
+            process->waitForFinished();
+        }
+    }
+
+    const Options &m_options;
+    QString m_scene;
+    xcb_connection_t *m_connection;
+    QString m_displayName;
+    QString m_home;
+    QProcess m_xvfb;
+    QProcess m_dbus;
+    QProcess m_kwin;
+    QDBusConnection m_bus;
+};
+
+bool parseArguments(const QStringList &arguments, Options *options)
+{
+    for (int i = 1; i < arguments.count(); ++i) {
+        const QString &argument = arguments.at(i);
+        const bool hasValue = i + 1 < arguments.count();
+        if (argument == "--kwin" && hasValue) {
+            options->kwin = arguments.at(++i);
+        } else if (argument == "--scene" && hasValue) {
+            options->scenes = QStringList() << arguments.at(++i);
+        } else if (argument == "--windows" && hasValue) {
+            options->windows = qMax(1, arguments.at(++i).toInt());
+        } else if (argument == "--duration" && hasValue) {
+            options->duration = qMax(100, arguments.at(++i).toInt());
+        } else if (argument == "--display" && hasValue) {
+            options->display = arguments.at(++i).toInt();
+        } else if (argument == "--output" && hasValue) {
+            options->output = arguments.at(++i);
+        } else {
+            return false;
+        }
+    }
+    foreach (const QString &scene, options->scenes) {
+        if (scene != "xrender" && scene != "opengl") {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QTextStream err(stderr);
+
+    Options options;
+    if (!parseArguments(app.arguments(), &options)) {
+        err << "Usage: " << app.arguments().first() << " [--kwin <executable>] [--scene xrender|opengl]"
+            << " [--windows <count>] [--duration <msec per scenario>] [--display <number>]"
+            << " [--output <file>]" << endl;
+        return 1;
+    }
+
+    QFile outputFile;
+    if (options.output.isEmpty()) {
+        outputFile.open(stdout, QIODevice::WriteOnly);
+    } else {
+        outputFile.setFileName(options.output);
+        if (!outputFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            err << "Cannot write " << options.output << endl;
+            return 1;
+        }
+    }
+    QTextStream out(&outputFile);
+
+    const QStringList scenarios = QStringList() << "map-unmap" << "resize" << "damage" << "present-windows"
+                                                    << "blur";
+    bool failed = false;
+    foreach (const QString &scene, options.scenes) {
+        Session session(options, scene);
+        QString error;
+        if (!session.start(&error)) {
+            err << scene << ": " << error << endl;
+            failed = true;
+            continue;
+        }
+        Workload workload(session.connection());
+        workload.createWindows(options.windows);
+        // let KWin manage the windows and finish the opening animations
+        sleepMilliseconds(2000);
+        foreach (const QString &scenario, scenarios) {
+            if (scenario == "blur" && scene != "opengl") {
+                continue;
+            }
+            out << toJson(session.run(&workload, scenario)) << endl;
+            sleepMilliseconds(1000);
+        }
+        workload.destroyWindows();
+    }
+    return failed ? 1 : 0;
+}
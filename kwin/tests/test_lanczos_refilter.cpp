@@ -0,0 +1,193 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "../lanczosrefilter.h"
+
+#include <QtTest/QtTest>
+#include <qmath.h>
+
+using namespace KWin;
+
+// value of the pixels the scene did not render, any use of them shows up in the comparison
+static const float s_garbage = 1000.0;
+
+/**
+ * A single channel image, sampled like a GL_LINEAR texture clamped to the edge.
+ **/
+class Image
+{
+public:
+    Image(int width, int height, float value = s_garbage)
+        : m_width(width)
+        , m_height(height)
+        , m_pixels(width * height, value) {}
+
+    int width() const {
+        return m_width;
+    }
+    int height() const {
+        return m_height;
+    }
+    float &pixel(int x, int y) {
+        return m_pixels[y * m_width + x];
+    }
+    float pixel(int x, int y) const {
+        return m_pixels.at(qBound(0, y, m_height - 1) * m_width + qBound(0, x, m_width - 1));
+    }
+    float sample(float u, float v) const {
+        const float x = u - 0.5;
+        const float y = v - 0.5;
+        const int x0 = qFloor(x);
+        const int y0 = qFloor(y);
+        const float fx = x - x0;
+        const float fy = y - y0;
+        return (pixel(x0, y0) * (1 - fx) + pixel(x0 + 1, y0) * fx) * (1 - fy) +
+               (pixel(x0, y0 + 1) * (1 - fx) + pixel(x0 + 1, y0 + 1) * fx) * fy;
+    }
+    void copy(const Image &other, const QRect &rect) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            for (int x = rect.left(); x <= rect.right(); ++x) {
+                pixel(x, y) = other.pixel(x, y);
+            }
+        }
+    }
+
+private:
+    int m_width;
+    int m_height;
+    QVector<float> m_pixels;
+};
+
+/**
+ * Renders @p rect of @p target from @p source like the lanczos shader does.
+ **/
+static void filterPass(const Image &source, Image &target, const QRect &rect, Qt::Orientation direction)
+{
+    const bool horizontal = direction == Qt::Horizontal;
+    const float delta = horizontal ? source.width() / float(target.width()) : source.height() / float(target.height());
+    const QVector<float> kernel = LanczosRefilter::kernel(delta);
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        for (int x = rect.left(); x <= rect.right(); ++x) {
+            const float u = horizontal ? (x + 0.5) * delta : x + 0.5;
+            const float v = horizontal ? y + 0.5 : (y + 0.5) * delta;
+            float sum = source.sample(u, v) * kernel.first();
+            for (int i = 1; i < kernel.count(); ++i) {
+                sum += (horizontal ? source.sample(u - i, v) + source.sample(u + i, v)
+                                   : source.sample(u, v - i) + source.sample(u, v + i)) * kernel.at(i);
+            }
+            target.pixel(x, y) = sum;
+        }
+    }
+}
+
+static Image fullFilter(const Image &source, const QSize &targetSize)
+{
+    Image horizontal(targetSize.width(), source.height());
+    filterPass(source, horizontal, QRect(0, 0, targetSize.width(), source.height()), Qt::Horizontal);
+    Image target(targetSize.width(), targetSize.height());
+    filterPass(horizontal, target, QRect(QPoint(0, 0), targetSize), Qt::Vertical);
+    return target;
+}
+
+class TestLanczosRefilter : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testFull();
+    void testOutside();
+    void testMatchesFullFilter_data();
+    void testMatchesFullFilter();
+};
+
+void TestLanczosRefilter::testFull()
+{
+    const QRect sourceRect(-20, -15, 340, 250);
+    LanczosRefilter refilter(sourceRect, QSize(100, 73), sourceRect);
+    QVERIFY(refilter.isFull());
+    QCOMPARE(refilter.paintRect(), QRect(0, 0, 340, 250));
+    QCOMPARE(refilter.targetRect(), QRect(0, 0, 100, 73));
+}
+
+void TestLanczosRefilter::testOutside()
+{
+    LanczosRefilter refilter(QRect(-20, -15, 340, 250), QSize(100, 73), QRect(400, 0, 10, 10));
+    QVERIFY(refilter.isEmpty());
+    QVERIFY(!refilter.isFull());
+}
+
+void TestLanczosRefilter::testMatchesFullFilter_data()
+{
+    QTest::addColumn<QRect>("sourceRect");
+    QTest::addColumn<QSize>("targetSize");
+    QTest::addColumn<QRect>("stale");
+
+    // the source rects start at the top left corner of the decoration shadow
+    QTest::newRow("top left") << QRect(-20, -15, 170, 125) << QSize(50, 37) << QRect(0, 0, 16, 16);
+    QTest::newRow("center") << QRect(-20, -15, 170, 125) << QSize(50, 37) << QRect(75, 50, 3, 2);
+    QTest::newRow("bottom right") << QRect(-8, -8, 116, 86) << QSize(30, 20) << QRect(95, 70, 35, 30);
+    QTest::newRow("slight downscale") << QRect(0, 0, 100, 75) << QSize(90, 67) << QRect(60, 40, 1, 1);
+    QTest::newRow("strong downscale") << QRect(-30, -30, 400, 300) << QSize(37, 27) << QRect(150, 100, 50, 20);
+    QTest::newRow("different scales") << QRect(-10, -5, 300, 80) << QSize(40, 60) << QRect(120, 30, 8, 8);
+}
+
+void TestLanczosRefilter::testMatchesFullFilter()
+{
+    QFETCH(QRect, sourceRect);
+    QFETCH(QSize, targetSize);
+    QFETCH(QRect, stale);
+
+    // the window before and after the damage, relative to the source rect
+    qsrand(1);
+    Image before(sourceRect.width(), sourceRect.height());
+    for (int y = 0; y < before.height(); ++y) {
+        for (int x = 0; x < before.width(); ++x) {
+            before.pixel(x, y) = qrand() / float(RAND_MAX);
+        }
+    }
+    Image after = before;
+    const QRect damaged = stale.translated(-sourceRect.topLeft()) & QRect(QPoint(0, 0), sourceRect.size());
+    for (int y = damaged.top(); y <= damaged.bottom(); ++y) {
+        for (int x = damaged.left(); x <= damaged.right(); ++x) {
+            after.pixel(x, y) = qrand() / float(RAND_MAX);
+        }
+    }
+
+    // refilter the stale part of the cache like LanczosFilter does, only the paint rect
+    // of the window is available
+    const LanczosRefilter refilter(sourceRect, targetSize, stale);
+    QVERIFY(!refilter.isEmpty());
+    Image cache = fullFilter(before, targetSize);
+    Image scratch(sourceRect.width(), sourceRect.height());
+    scratch.copy(after, refilter.paintRect());
+    Image horizontal(targetSize.width(), sourceRect.height());
+    filterPass(scratch, horizontal, refilter.horizontalRect(), Qt::Horizontal);
+    filterPass(horizontal, cache, refilter.targetRect(), Qt::Vertical);
+
+    const Image expected = fullFilter(after, targetSize);
+    for (int y = 0; y < targetSize.height(); ++y) {
+        for (int x = 0; x < targetSize.width(); ++x) {
+            if (qAbs(cache.pixel(x, y) - expected.pixel(x, y)) > 1e-4) {
+                QFAIL(qPrintable(QString("pixel %1,%2 differs: %3 instead of %4").arg(x).arg(y)
+                                 .arg(cache.pixel(x, y)).arg(expected.pixel(x, y))));
+            }
+        }
+    }
+}
+
+QTEST_MAIN(TestLanczosRefilter)
+#include "test_lanczos_refilter.moc"
@@ -0,0 +1,184 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "../effects/presentwindows/naturallayout.h"
+
+#include <QtTest/QtTest>
+
+using namespace KWin;
+
+class TestNaturalLayout : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testSingleWindow();
+    void testNoOverlap_data();
+    void testNoOverlap();
+    void testAddWindow();
+    void testRemoveWindow();
+    void benchmarkLayout_data();
+    void benchmarkLayout();
+    void benchmarkAddWindow_data();
+    void benchmarkAddWindow();
+private:
+    // The layout never dereferences the windows, they are only used as keys
+    static EffectWindow *window(int i) {
+        return reinterpret_cast<EffectWindow*>(quintptr(i + 1) * 8);
+    }
+    static QMap<EffectWindow*, QRect> createWindows(int count);
+    static bool overlaps(const QHash<EffectWindow*, QRect> &targets);
+    static const QRect s_area;
+};
+
+const QRect TestNaturalLayout::s_area = QRect(0, 0, 1920, 1080);
+
+QMap<EffectWindow*, QRect> TestNaturalLayout::createWindows(int count)
+{
+    // windows cascaded over the screen, so that most of them overlap
+    QMap<EffectWindow*, QRect> windows;
+    qsrand(count);
+    for (int i = 0; i < count; ++i) {
+        const int width = 200 + qrand() % 800;
+        const int height = 150 + qrand() % 600;
+        const int x = qrand() % (s_area.width() - width);
+        const int y = qrand() % (s_area.height() - height);
+        windows.insert(window(i), QRect(x, y, width, height));
+    }
+    return windows;
+}
+
+bool TestNaturalLayout::overlaps(const QHash<EffectWindow*, QRect> &targets)
+{
+    // ignore rounding errors from scaling the layout onto the screen
+    QList<QRect> rects;
+    foreach (const QRect &rect, targets) {
+        rects << rect.adjusted(1, 1, -1, -1);
+    }
+    for (int i = 0; i < rects.count(); ++i) {
+        for (int j = i + 1; j < rects.count(); ++j) {
+            if (rects.at(i).intersects(rects.at(j))) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void TestNaturalLayout::testSingleWindow()
+{
+    NaturalLayout layout;
+    QMap<EffectWindow*, QRect> windows;
+    windows.insert(window(0), QRect(100, 100, 500, 400));
+    const QHash<EffectWindow*, QRect> targets = layout.layout(windows, s_area);
+    QCOMPARE(targets.count(), 1);
+    QVERIFY(s_area.contains(targets.value(window(0))));
+}
+
+void TestNaturalLayout::testNoOverlap_data()
+{
+    QTest::addColumn<int>("count");
+    QTest::addColumn<bool>("fillGaps");
+
+    QTest::newRow("2") << 2 << false;
+    QTest::newRow("2/fill") << 2 << true;
+    QTest::newRow("10") << 10 << false;
+    QTest::newRow("10/fill") << 10 << true;
+    QTest::newRow("50") << 50 << false;
+    QTest::newRow("50/fill") << 50 << true;
+    QTest::newRow("500") << 500 << false;
+    QTest::newRow("500/fill") << 500 << true;
+}
+
+void TestNaturalLayout::testNoOverlap()
+{
+    QFETCH(int, count);
+    QFETCH(bool, fillGaps);
+    NaturalLayout layout;
+    layout.setFillGaps(fillGaps);
+    const QMap<EffectWindow*, QRect> windows = createWindows(count);
+    const QHash<EffectWindow*, QRect> targets = layout.layout(windows, s_area);
+    QCOMPARE(targets.count(), count);
+    QVERIFY(!overlaps(targets));
+    foreach (const QRect &target, targets) {
+        QVERIFY(s_area.contains(target));
+    }
+}
+
+void TestNaturalLayout::testAddWindow()
+{
+    NaturalLayout layout;
+    QMap<EffectWindow*, QRect> windows = createWindows(20);
+    layout.layout(windows, s_area);
+    // the new window overlaps the existing arrangement
+    windows.insert(window(20), QRect(500, 300, 800, 600));
+    const QHash<EffectWindow*, QRect> targets = layout.layout(windows, s_area);
+    QCOMPARE(targets.count(), 21);
+    QVERIFY(!overlaps(targets));
+}
+
+void TestNaturalLayout::testRemoveWindow()
+{
+    NaturalLayout layout;
+    QMap<EffectWindow*, QRect> windows = createWindows(20);
+    layout.layout(windows, s_area);
+    windows.remove(window(5));
+    const QHash<EffectWindow*, QRect> targets = layout.layout(windows, s_area);
+    QCOMPARE(targets.count(), 19);
+    QVERIFY(!targets.contains(window(5)));
+    QVERIFY(!overlaps(targets));
+}
+
+void TestNaturalLayout::benchmarkLayout_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("50") << 50;
+    QTest::newRow("200") << 200;
+    QTest::newRow("500") << 500;
+}
+
+void TestNaturalLayout::benchmarkLayout()
+{
+    QFETCH(int, count);
+    const QMap<EffectWindow*, QRect> windows = createWindows(count);
+    QBENCHMARK {
+        NaturalLayout layout;
+        layout.layout(windows, s_area);
+    }
+}
+
+void TestNaturalLayout::benchmarkAddWindow_data()
+{
+    benchmarkLayout_data();
+}
+
+void TestNaturalLayout::benchmarkAddWindow()
+{
+    QFETCH(int, count);
+    QMap<EffectWindow*, QRect> windows = createWindows(count);
+    const QMap<EffectWindow*, QRect> initial = windows;
+    windows.insert(window(count), QRect(500, 300, 800, 600));
+    QBENCHMARK {
+        NaturalLayout layout;
+        layout.layout(initial, s_area);
+        layout.layout(windows, s_area);
+    }
+}
+
+QTEST_MAIN(TestNaturalLayout)
+#include "test_natural_layout.moc"
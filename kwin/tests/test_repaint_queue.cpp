@@ -0,0 +1,174 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "../repaintqueue.h"
+
+#include <QtTest/QtTest>
+#include <QThread>
+
+using namespace KWin;
+
+class Producer : public QThread
+{
+public:
+    Producer(RepaintQueue *queue, int row)
+        : m_queue(queue)
+        , m_row(row) {}
+protected:
+    virtual void run() {
+        for (int i = 0; i < 1000; ++i) {
+            m_queue->post(QRect(i, m_row, 1, 1));
+        }
+    }
+private:
+    RepaintQueue *m_queue;
+    int m_row;
+};
+
+class TestRepaintQueue : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testPostAndTake();
+    void testMerge_data();
+    void testMerge();
+    void testMaxRects();
+    void testConcurrentPost();
+    void benchmarkPostAndTake();
+};
+
+void TestRepaintQueue::testPostAndTake()
+{
+    RepaintQueue queue;
+    QVERIFY(queue.isEmpty());
+    QVERIFY(queue.post(QRect(0, 0, 10, 10)));
+    QVERIFY(!queue.post(QRect(100, 100, 10, 10)));
+    QVERIFY(!queue.isEmpty());
+    // empty rects are ignored
+    QVERIFY(!queue.post(QRect()));
+
+    const QVector<QRect> rects = queue.take();
+    QCOMPARE(rects.count(), 2);
+    QCOMPARE(rects.at(0), QRect(0, 0, 10, 10));
+    QCOMPARE(rects.at(1), QRect(100, 100, 10, 10));
+    QVERIFY(queue.isEmpty());
+    QVERIFY(queue.take().isEmpty());
+    QVERIFY(!queue.post(QRect()));
+    QVERIFY(queue.isEmpty());
+    // the next post has to wake up the consumer again
+    QVERIFY(queue.post(QRect(0, 0, 10, 10)));
+    queue.clear();
+    QVERIFY(queue.isEmpty());
+    // also after the posted rects got dropped, e.g. as compositing stopped
+    QVERIFY(queue.post(QRect(0, 0, 10, 10)));
+    queue.clear();
+}
+
+void TestRepaintQueue::testMerge_data()
+{
+    QTest::addColumn<QRect>("first");
+    QTest::addColumn<QRect>("second");
+    QTest::addColumn<int>("count");
+    QTest::addColumn<QRect>("bounds");
+
+    QTest::newRow("contained")  << QRect(0, 0, 100, 100) << QRect(10, 10, 10, 10) << 1 << QRect(0, 0, 100, 100);
+    QTest::newRow("containing") << QRect(10, 10, 10, 10) << QRect(0, 0, 100, 100) << 1 << QRect(0, 0, 100, 100);
+    QTest::newRow("adjacent")   << QRect(0, 0, 10, 10)   << QRect(10, 0, 10, 10)  << 1 << QRect(0, 0, 20, 10);
+    QTest::newRow("disjoint")   << QRect(0, 0, 10, 10)   << QRect(50, 50, 10, 10) << 2 << QRect(0, 0, 60, 60);
+    QTest::newRow("diagonal")   << QRect(0, 0, 10, 10)   << QRect(5, 5, 10, 10)   << 2 << QRect(0, 0, 15, 15);
+}
+
+void TestRepaintQueue::testMerge()
+{
+    QFETCH(QRect, first);
+    QFETCH(QRect, second);
+    QVector<QRect> rects;
+    RepaintQueue::merge(rects, first, RepaintQueue::DefaultMaxRects);
+    RepaintQueue::merge(rects, second, RepaintQueue::DefaultMaxRects);
+    QTEST(rects.count(), "count");
+    QRect bounds;
+    foreach (const QRect &rect, rects) {
+        bounds |= rect;
+    }
+    QTEST(bounds, "bounds");
+}
+
+void TestRepaintQueue::testMaxRects()
+{
+    RepaintQueue queue;
+    QRegion posted;
+    for (int i = 0; i < 100; ++i) {
+        const QRect rect((i % 10) * 100, (i / 10) * 100, 20, 20);
+        queue.post(rect);
+        posted += rect;
+    }
+    const QVector<QRect> rects = queue.take(8);
+    QCOMPARE(rects.count(), 8);
+    // merging may only enlarge the area to repaint
+    QRegion merged;
+    foreach (const QRect &rect, rects) {
+        merged += rect;
+    }
+    QVERIFY((posted - merged).isEmpty());
+}
+
+void TestRepaintQueue::testConcurrentPost()
+{
+    RepaintQueue queue;
+    QList<Producer*> producers;
+    for (int i = 0; i < 4; ++i) {
+        producers << new Producer(&queue, i * 10);
+    }
+    QRegion taken;
+    foreach (Producer *producer, producers) {
+        producer->start();
+    }
+    // take concurrently to the producers
+    bool running = true;
+    while (running) {
+        running = false;
+        foreach (Producer *producer, producers) {
+            running = running || producer->isRunning();
+        }
+        foreach (const QRect &rect, queue.take(1000)) {
+            taken += rect;
+        }
+    }
+    foreach (const QRect &rect, queue.take(1000)) {
+        taken += rect;
+    }
+    qDeleteAll(producers);
+    // nothing got lost
+    for (int i = 0; i < 4; ++i) {
+        QVERIFY((QRegion(0, i * 10, 1000, 1) - taken).isEmpty());
+    }
+}
+
+void TestRepaintQueue::benchmarkPostAndTake()
+{
+    RepaintQueue queue;
+    QBENCHMARK {
+        for (int i = 0; i < 500; ++i) {
+            queue.post(QRect((i * 37) % 1900, (i * 53) % 1000, 24, 24));
+        }
+        queue.take();
+    }
+}
+
+QTEST_MAIN(TestRepaintQueue)
+#include "test_repaint_queue.moc"
@@ -0,0 +1,189 @@
+/********************************************************************
+KWin - the KDE window manager
+This file is part of the KDE project.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*********************************************************************/
+
+#include "../effects/wobblywindows/wobblymodel.h"
+
+#include <QtTest/QtTest>
+
+using namespace KWin;
+
+class TestWobblyModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void testMapAtRest();
+    void testComesToRest();
+    void testFollowsConstraint();
+    void testPaintRateIndependent();
+    void benchmarkAdvance();
+    void benchmarkMap_data();
+    void benchmarkMap();
+private:
+    static WobblyModel::Parameters parameters();
+    static void regularGrid(int tesselation, QVector<float> *x, QVector<float> *y);
+    static const QRectF s_geometry;
+};
+
+const QRectF TestWobblyModel::s_geometry = QRectF(100, 50, 800, 600);
+
+WobblyModel::Parameters TestWobblyModel::parameters()
+{
+    // the default "wobblyness"
+    WobblyModel::Parameters parameters = {0.10, 0.85, 0.10, 0.0, 1000.0, 0.5, 0.0, 1000.0, 0.5};
+    return parameters;
+}
+
+void TestWobblyModel::regularGrid(int tesselation, QVector<float> *x, QVector<float> *y)
+{
+    // the vertices of the quads of WindowQuadList::makeRegularGrid()
+    const qreal width = s_geometry.width() / tesselation;
+    const qreal height = s_geometry.height() / tesselation;
+    for (int j = 0; j < tesselation; ++j) {
+        for (int i = 0; i < tesselation; ++i) {
+            const qreal left = s_geometry.x() + i * width;
+            const qreal top = s_geometry.y() + j * height;
+            *x << left << left + width << left + width << left;
+            *y << top << top << top + height << top + height;
+        }
+    }
+}
+
+void TestWobblyModel::testMapAtRest()
+{
+    // without any displacement the surface is the window itself
+    WobblyModel model;
+    model.reset(s_geometry);
+    QVERIFY(model.advance(s_geometry, 16, parameters(), false));
+    QVector<float> x, y;
+    regularGrid(7, &x, &y);
+    const QVector<float> originalX = x, originalY = y;
+    model.map(x.data(), y.data(), x.count());
+    for (int i = 0; i < x.count(); ++i) {
+        QVERIFY(qAbs(x[i] - originalX[i]) < 0.01);
+        QVERIFY(qAbs(y[i] - originalY[i]) < 0.01);
+    }
+}
+
+void TestWobblyModel::testComesToRest()
+{
+    // the throb of a maximized window
+    WobblyModel model;
+    model.reset(s_geometry);
+    for (int j = 0; j < WobblyModel::GridHeight; ++j) {
+        for (int i = 0; i < WobblyModel::GridWidth; ++i) {
+            const int index = j * WobblyModel::GridWidth + i;
+            model.setVelocity(index, QPointF(i / 3.0 - 0.5, j / 3.0 - 0.5) * 10);
+            model.setConstrained(index, i > 0 && i < 3 && j > 0 && j < 3);
+        }
+    }
+    int time = 0;
+    while (model.advance(s_geometry, 16, parameters(), true)) {
+        time += 16;
+        QVERIFY(time < 60000);
+    }
+    for (int i = 0; i < WobblyModel::PointCount; ++i) {
+        QVERIFY(qAbs(model.position(i).x() - model.origin(i).x()) < 1.0);
+        QVERIFY(qAbs(model.position(i).y() - model.origin(i).y()) < 1.0);
+    }
+}
+
+void TestWobblyModel::testFollowsConstraint()
+{
+    // a window dragged at one point follows the move
+    WobblyModel model;
+    model.reset(s_geometry);
+    model.setConstrained(5, true);
+    QVERIFY(model.isConstrained(5));
+    const QRectF moved = s_geometry.translated(200, 100);
+    for (int i = 0; i < 300; ++i) {
+        model.advance(moved, 16, parameters(), false);
+    }
+    for (int i = 0; i < WobblyModel::PointCount; ++i) {
+        QVERIFY(qAbs(model.position(i).x() - model.origin(i).x()) < 1.0);
+        QVERIFY(qAbs(model.position(i).y() - model.origin(i).y()) < 1.0);
+    }
+    QCOMPARE(model.origin(0), moved.topLeft());
+    QCOMPARE(model.origin(WobblyModel::PointCount - 1), moved.bottomRight());
+}
+
+void TestWobblyModel::testPaintRateIndependent()
+{
+    // the same time passed in frames of 60 and 240 Hz leads to the same state
+    WobblyModel slow, fast;
+    slow.reset(s_geometry);
+    fast.reset(s_geometry);
+    slow.setConstrained(0, true);
+    fast.setConstrained(0, true);
+    const QRectF moved = s_geometry.translated(150, 0);
+    for (int i = 0; i < 25; ++i) {
+        slow.advance(moved, 16, parameters(), false);
+    }
+    for (int i = 0; i < 100; ++i) {
+        fast.advance(moved, 4, parameters(), false);
+    }
+    for (int i = 0; i < WobblyModel::PointCount; ++i) {
+        QCOMPARE(slow.position(i), fast.position(i));
+    }
+    float x[2] = { 500.0, 120.0 };
+    float y[2] = { 300.0, 600.0 };
+    float fx[2] = { 500.0, 120.0 };
+    float fy[2] = { 300.0, 600.0 };
+    slow.map(x, y, 2);
+    fast.map(fx, fy, 2);
+    QCOMPARE(x[0], fx[0]);
+    QCOMPARE(y[1], fy[1]);
+}
+
+void TestWobblyModel::benchmarkAdvance()
+{
+    WobblyModel model;
+    model.reset(s_geometry);
+    model.setConstrained(5, true);
+    const QRectF moved = s_geometry.translated(200, 100);
+    QBENCHMARK {
+        model.advance(moved, WobblyModel::StepTime, parameters(), false);
+    }
+}
+
+void TestWobblyModel::benchmarkMap_data()
+{
+    QTest::addColumn<int>("tesselation");
+
+    QTest::newRow("10x10") << 10;
+    QTest::newRow("20x20") << 20;
+    QTest::newRow("40x40") << 40;
+    QTest::newRow("80x80") << 80;
+}
+
+void TestWobblyModel::benchmarkMap()
+{
+    QFETCH(int, tesselation);
+    WobblyModel model;
+    model.reset(s_geometry);
+    model.setConstrained(5, true);
+    model.advance(s_geometry.translated(50, 20), 50, parameters(), false);
+    QVector<float> x, y;
+    regularGrid(tesselation, &x, &y);
+    QBENCHMARK {
+        QVector<float> mappedX = x, mappedY = y;
+        model.map(mappedX.data(), mappedY.data(), mappedX.count());
+    }
+}
+
+QTEST_MAIN(TestWobblyModel)
+#include "test_wobbly_model.moc"
@@ -44,6 +44,10 @@ private slots:
     void assignmentBeforeRetrieve();
     void assignmentAfterRetrieve();
     void discard();
+    void property();
+    void propertyWrongType();
+    void propertyPipelined();
+    void propertyRoundTrips();
 private:
     void testEmpty(WindowGeometry &geometry);
     void testGeometry(WindowGeometry &geometry, const QRect &rect);
@@ -210,5 +214,131 @@ void TestXcbWrapper::discard()
     delete geometry;
 }
 
+void TestXcbWrapper::property()
+{
+    m_testWindow = createWindow();
+    QVERIFY(m_testWindow != noneWindow());
+    const QByteArray name("foo\0bar", 7);
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, m_testWindow, XCB_ATOM_WM_CLASS,
+                        XCB_ATOM_STRING, 8, name.length(), name.constData());
+
+    Property prop(m_testWindow, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 2048);
+    QCOMPARE(prop.window(), m_testWindow);
+    QVERIFY(!prop.isRetrieved());
+    QCOMPARE(prop.toByteArray(), name);
+    QVERIFY(prop.isRetrieved());
+    uint32_t count = 0;
+    QVERIFY(prop.value(XCB_ATOM_STRING, 8, &count));
+    QCOMPARE(count, uint32_t(7));
+
+    // a property which is not set
+    Property unset(m_testWindow, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 0, 2048);
+    QVERIFY(unset.toByteArray().isNull());
+    QVERIFY(!unset.value(XCB_ATOM_STRING, 8, &count));
+    QCOMPARE(count, uint32_t(0));
+}
+
+void TestXcbWrapper::propertyWrongType()
+{
+    m_testWindow = createWindow();
+    QVERIFY(m_testWindow != noneWindow());
+    const uint32_t values[] = { 1, 2, 3 };
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, m_testWindow, XCB_ATOM_WM_HINTS,
+                        XCB_ATOM_CARDINAL, 32, 3, values);
+
+    // requested with the wrong type the server does not return the value
+    Property wrongType(m_testWindow, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 0, 9);
+    QVERIFY(!wrongType.value(XCB_ATOM_WM_HINTS, 32));
+    Property wrongFormat(m_testWindow, XCB_ATOM_WM_HINTS, XCB_ATOM_CARDINAL, 0, 9);
+    QVERIFY(!wrongFormat.value(XCB_ATOM_CARDINAL, 8));
+    QVERIFY(wrongFormat.toByteArray(XCB_ATOM_CARDINAL).isNull());
+
+    Property prop(m_testWindow, XCB_ATOM_WM_HINTS, XCB_ATOM_CARDINAL, 0, 9);
+    uint32_t count = 0;
+    const uint32_t *data = static_cast<const uint32_t*>(prop.value(XCB_ATOM_CARDINAL, 32, &count));
+    QVERIFY(data);
+    QCOMPARE(count, uint32_t(3));
+    QCOMPARE(data[0], uint32_t(1));
+    QCOMPARE(data[2], uint32_t(3));
+}
+
+void TestXcbWrapper::propertyPipelined()
+{
+    // all requests are sent before any reply is read, like in Client::manage
+    m_testWindow = createWindow();
+    QVERIFY(m_testWindow != noneWindow());
+    const QByteArray name("name");
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, m_testWindow, XCB_ATOM_WM_NAME,
+                        XCB_ATOM_STRING, 8, name.length(), name.constData());
+    const uint32_t hints[] = { 0, 1, 0, 0, 0, 0, 0, 0, 0 };
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, m_testWindow, XCB_ATOM_WM_HINTS,
+                        XCB_ATOM_WM_HINTS, 32, 9, hints);
+
+    QList<Property*> properties;
+    for (int i = 0; i < 10; ++i) {
+        properties << new Property(m_testWindow, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 0, 2048);
+        properties << new Property(m_testWindow, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 0, 9);
+    }
+    // replies read in reverse order
+    for (int i = properties.count() - 1; i >= 0; --i) {
+        QVERIFY(!properties.at(i)->isRetrieved());
+        if (i % 2) {
+            uint32_t count = 0;
+            QVERIFY(properties.at(i)->value(XCB_ATOM_WM_HINTS, 32, &count));
+            QCOMPARE(count, uint32_t(9));
+        } else {
+            QCOMPARE(properties.at(i)->toByteArray(), name);
+        }
+    }
+    qDeleteAll(properties);
+
+    // unread replies get discarded
+    Property *discarded = new Property(m_testWindow, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 0, 2048);
+    delete discarded;
+    Property afterDiscard(m_testWindow, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 0, 2048);
+    QCOMPARE(afterDiscard.toByteArray(), name);
+}
+
+void TestXcbWrapper::propertyRoundTrips()
+{
+    // the properties of a window as requested in Client::manage, each reply is waited
+    // for once when it is read and replies which are never read are not waited for
+    m_testWindow = createWindow();
+    QVERIFY(m_testWindow != noneWindow());
+    const QByteArray name("foo\0bar", 7);
+    xcb_change_property(connection(), XCB_PROP_MODE_REPLACE, m_testWindow, XCB_ATOM_WM_CLASS,
+                        XCB_ATOM_STRING, 8, name.length(), name.constData());
+
+    const quint64 before = roundTrips();
+    {
+        Property wmHints(m_testWindow, XCB_ATOM_WM_HINTS, XCB_ATOM_WM_HINTS, 0, 9);
+        Property classHint(m_testWindow, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 2048);
+        TransientFor transientFor(m_testWindow);
+        Property normalHints(m_testWindow, XCB_ATOM_WM_NORMAL_HINTS, XCB_ATOM_WM_SIZE_HINTS, 0, 18);
+        Property unread(m_testWindow, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 0, 2048);
+        QCOMPARE(roundTrips(), before);
+
+        QCOMPARE(classHint.toByteArray(), name);
+        QCOMPARE(roundTrips(), before + 1);
+        // reading a value again does not wait for another reply
+        QCOMPARE(classHint.toByteArray(), name);
+        QCOMPARE(roundTrips(), before + 1);
+
+        QVERIFY(!wmHints.value(XCB_ATOM_WM_HINTS, 32));
+        xcb_window_t transient = XCB_WINDOW_NONE;
+        QVERIFY(!transientFor.getTransientFor(&transient));
+        QVERIFY(!normalHints.value(XCB_ATOM_WM_SIZE_HINTS, 32));
+        QCOMPARE(roundTrips(), before + 4);
+    }
+    QCOMPARE(roundTrips(), before + 4);
+
+    // a window which is gone is detected before any property is requested
+    xcb_destroy_window(connection(), m_testWindow);
+    WindowAttributes attributes(m_testWindow);
+    m_testWindow = XCB_WINDOW_NONE;
+    QVERIFY(attributes.isNull());
+    QCOMPARE(roundTrips(), before + 5);
+}
+
 KWIN_TEST_MAIN(TestXcbWrapper)
 #include "test_xcb_wrapper.moc"
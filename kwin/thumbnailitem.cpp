@@ -59,7 +59,6 @@ void AbstractThumbnailItem::compositingToggled()
     m_parent.clear();
     if (effects) {
         connect(effects, SIGNAL(windowAdded(KWin::EffectWindow*)), SLOT(effectWindowAdded()));
-        connect(effects, SIGNAL(windowDamaged(KWin::EffectWindow*,QRect)), SLOT(repaint(KWin::EffectWindow*)));
         effectWindowAdded();
     }
 }
@@ -151,10 +150,14 @@ WindowThumbnailItem::WindowThumbnailItem(QDeclarativeItem* parent)
     , m_wId(0)
     , m_client(NULL)
 {
+    ThumbnailService::self()->addWindowItem(this);
 }
 
 WindowThumbnailItem::~WindowThumbnailItem()
 {
+    if (ThumbnailService::self()) {
+        ThumbnailService::self()->removeWindowItem(this, m_wId);
+    }
 }
 
 void WindowThumbnailItem::setWId(qulonglong wId)
@@ -162,7 +165,9 @@ void WindowThumbnailItem::setWId(qulonglong wId)
     if (m_wId == wId) {
         return;
     }
+    ThumbnailService::self()->removeWindowItem(this, m_wId);
     m_wId = wId;
+    ThumbnailService::self()->addWindowItem(this);
     if (m_wId != 0) {
         setClient(Workspace::self()->findClient(WindowMatchPredicate(m_wId)));
     } else if (m_client) {
@@ -203,21 +208,18 @@ void WindowThumbnailItem::paint(QPainter *painter, const QStyleOptionGraphicsIte
                         pixmap);
 }
 
-void WindowThumbnailItem::repaint(KWin::EffectWindow *w)
-{
-    if (static_cast<KWin::EffectWindowImpl*>(w)->window()->window() == m_wId) {
-        update();
-    }
-}
-
 DesktopThumbnailItem::DesktopThumbnailItem(QDeclarativeItem *parent)
     : AbstractThumbnailItem(parent)
     , m_desktop(0)
 {
+    ThumbnailService::self()->addDesktopItem(this);
 }
 
 DesktopThumbnailItem::~DesktopThumbnailItem()
 {
+    if (ThumbnailService::self()) {
+        ThumbnailService::self()->removeDesktopItem(this);
+    }
 }
 
 void DesktopThumbnailItem::setDesktop(int desktop)
@@ -240,11 +242,89 @@ void DesktopThumbnailItem::paint(QPainter *painter, const QStyleOptionGraphicsIt
     // TODO: render icon
 }
 
-void DesktopThumbnailItem::repaint(EffectWindow *w)
+KWIN_SINGLETON_FACTORY(ThumbnailService)
+
+ThumbnailService::ThumbnailService(QObject *parent)
+    : QObject(parent)
+{
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setInterval(UpdateInterval);
+    connect(&m_updateTimer, SIGNAL(timeout()), SLOT(updatePendingItems()));
+    connect(Compositor::self(), SIGNAL(compositingToggled(bool)), SLOT(compositingToggled()));
+    compositingToggled();
+}
+
+ThumbnailService::~ThumbnailService()
+{
+    s_self = NULL;
+}
+
+void ThumbnailService::compositingToggled()
+{
+    // the EffectsHandler is recreated whenever compositing gets started
+    if (effects) {
+        connect(effects, SIGNAL(windowDamaged(KWin::EffectWindow*,QRect)),
+                SLOT(windowDamaged(KWin::EffectWindow*)), Qt::UniqueConnection);
+    }
+}
+
+void ThumbnailService::addWindowItem(WindowThumbnailItem *item)
+{
+    m_windowItems.insert(item->wId(), item);
+}
+
+void ThumbnailService::removeWindowItem(WindowThumbnailItem *item, qulonglong wId)
 {
-    if (w->isOnDesktop(m_desktop)) {
-        update();
+    m_windowItems.remove(wId, item);
+    m_pending.remove(item);
+}
+
+void ThumbnailService::addDesktopItem(DesktopThumbnailItem *item)
+{
+    m_desktopItems << item;
+}
+
+void ThumbnailService::removeDesktopItem(DesktopThumbnailItem *item)
+{
+    m_desktopItems.removeOne(item);
+    m_pending.remove(item);
+}
+
+void ThumbnailService::windowDamaged(EffectWindow *w)
+{
+    const qulonglong wId = static_cast<EffectWindowImpl*>(w)->window()->window();
+    for (QMultiHash<qulonglong, WindowThumbnailItem*>::const_iterator it = m_windowItems.constFind(wId);
+            it != m_windowItems.constEnd() && it.key() == wId;
+            ++it) {
+        scheduleUpdate(it.value());
+    }
+    foreach (DesktopThumbnailItem *item, m_desktopItems) {
+        if (w->isOnDesktop(item->desktop())) {
+            scheduleUpdate(item);
+        }
+    }
+}
+
+void ThumbnailService::scheduleUpdate(AbstractThumbnailItem *item)
+{
+    if (m_updateTimer.isActive()) {
+        m_pending.insert(item);
+        return;
+    }
+    item->update();
+    m_updateTimer.start();
+}
+
+void ThumbnailService::updatePendingItems()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    foreach (AbstractThumbnailItem *item, m_pending) {
+        item->update();
     }
+    m_pending.clear();
+    m_updateTimer.start();
 }
 
 } // namespace KWin
@@ -21,6 +21,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef KWIN_THUMBNAILITEM_H
 #define KWIN_THUMBNAILITEM_H
 
+#include <kwinglobals.h>
+
+#include <QMultiHash>
+#include <QSet>
+#include <QTimer>
 #include <QWeakPointer>
 #include <QtDeclarative/QDeclarativeItem>
 
@@ -28,8 +33,10 @@ namespace KWin
 {
 
 class Client;
+class DesktopThumbnailItem;
 class EffectWindow;
 class EffectWindowImpl;
+class WindowThumbnailItem;
 
 class AbstractThumbnailItem : public QDeclarativeItem
 {
@@ -63,9 +70,6 @@ Q_SIGNALS:
 protected:
     explicit AbstractThumbnailItem(QDeclarativeItem *parent = 0);
 
-protected Q_SLOTS:
-    virtual void repaint(KWin::EffectWindow* w) = 0;
-
 private Q_SLOTS:
     void init();
     void effectWindowAdded();
@@ -99,8 +103,6 @@ public:
 Q_SIGNALS:
     void wIdChanged(qulonglong wid);
     void clientChanged();
-protected Q_SLOTS:
-    virtual void repaint(KWin::EffectWindow* w);
 private:
     qulonglong m_wId;
     Client *m_client;
@@ -121,12 +123,50 @@ public:
     virtual void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
 Q_SIGNALS:
     void desktopChanged(int desktop);
-protected Q_SLOTS:
-    virtual void repaint(KWin::EffectWindow* w);
 private:
     int m_desktop;
 };
 
+/**
+ * @short Updates the thumbnail items when the windows they show get damaged.
+ *
+ * The window thumbnails are indexed by the id of the window they show, so that damage
+ * only reaches the items showing the damaged window instead of every item checking every
+ * damage event. The items are updated at most every UpdateInterval msec. A switcher
+ * showing many windows, some of them damaged every frame, is thus not repainted every
+ * frame just because of its thumbnails.
+ *
+ * This only limits how often the items are updated. Each update still paints the
+ * thumbnailed windows scaled down from their full content.
+ **/
+class ThumbnailService : public QObject
+{
+    Q_OBJECT
+public:
+    enum {
+        UpdateInterval = 100 // in msec
+    };
+    virtual ~ThumbnailService();
+
+    void addWindowItem(WindowThumbnailItem *item);
+    void removeWindowItem(WindowThumbnailItem *item, qulonglong wId);
+    void addDesktopItem(DesktopThumbnailItem *item);
+    void removeDesktopItem(DesktopThumbnailItem *item);
+
+private Q_SLOTS:
+    void compositingToggled();
+    void windowDamaged(KWin::EffectWindow *w);
+    void updatePendingItems();
+
+private:
+    void scheduleUpdate(AbstractThumbnailItem *item);
+    QMultiHash<qulonglong, WindowThumbnailItem*> m_windowItems;
+    QList<DesktopThumbnailItem*> m_desktopItems;
+    QSet<AbstractThumbnailItem*> m_pending;
+    QTimer m_updateTimer;
+    KWIN_SINGLETON(ThumbnailService)
+};
+
 inline
 qreal AbstractThumbnailItem::brightness() const
 {
@@ -148,7 +148,13 @@ QRect Toplevel::visibleRect() const
 
 void Toplevel::getWindowRole()
 {
-    window_role = getStringProperty(window(), atoms->wm_window_role).toLower();
+    Xcb::Property role(window(), atoms->wm_window_role, XCB_ATOM_STRING, 0, 10000);
+    getWindowRole(role);
+}
+
+void Toplevel::getWindowRole(Xcb::Property &role)
+{
+    window_role = role.toByteArray().toLower();
 }
 
 /*!
@@ -193,7 +199,15 @@ Window Toplevel::staticWmClientLeader(WId w)
 
 void Toplevel::getWmClientLeader()
 {
-    wmClientLeaderWin = staticWmClientLeader(window());
+    Xcb::Property leader(window(), atoms->wm_client_leader, XCB_ATOM_WINDOW, 0, 10000);
+    getWmClientLeader(leader);
+}
+
+void Toplevel::getWmClientLeader(Xcb::Property &leader)
+{
+    uint32_t count = 0;
+    const xcb_window_t *data = static_cast<const xcb_window_t*>(leader.value(XCB_ATOM_WINDOW, 32, &count));
+    wmClientLeaderWin = count > 0 ? data[0] : window();
 }
 
 /*!
@@ -255,14 +269,20 @@ Window Toplevel::wmClientLeader() const
 
 void Toplevel::getResourceClass()
 {
-    XClassHint classHint;
-    if (XGetClassHint(display(), window(), &classHint)) {
+    Xcb::Property classHint(window(), XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 2048);
+    getResourceClass(classHint);
+}
+
+void Toplevel::getResourceClass(Xcb::Property &classHint)
+{
+    // WM_CLASS consists of the null terminated instance name followed by the class name
+    const QByteArray data = classHint.toByteArray();
+    if (!data.isNull()) {
+        const int separator = data.indexOf('\0');
         // Qt3.2 and older had this all lowercase, Qt3.3 capitalized resource class.
         // Force lowercase, so that workarounds listing resource classes still work.
-        resource_name = QByteArray(classHint.res_name).toLower();
-        resource_class = QByteArray(classHint.res_class).toLower();
-        XFree(classHint.res_name);
-        XFree(classHint.res_class);
+        resource_name = QByteArray(data.constData()).toLower();
+        resource_class = separator >= 0 ? QByteArray(data.constData() + separator + 1).toLower() : QByteArray();
     } else {
         resource_name = resource_class = QByteArray();
     }
@@ -401,38 +421,26 @@ const Shadow *Toplevel::shadow() const
 
 void Toplevel::getWmOpaqueRegion()
 {
-    const int length=32768;
-    unsigned long bytes_after_return=0;
-    QRegion new_opaque_region;
-    do {
-        unsigned long* data;
-        Atom type;
-        int rformat;
-        unsigned long nitems;
-        if (XGetWindowProperty(display(), client,
-                               atoms->net_wm_opaque_region, 0, length, false, XA_CARDINAL,
-                               &type, &rformat, &nitems, &bytes_after_return,
-                               reinterpret_cast< unsigned char** >(&data)) == Success) {
-            if (type != XA_CARDINAL || rformat != 32 || nitems%4) {
-                // it can happen, that the window does not provide this property
-                XFree(data);
-                break;
-            }
-
-            for (unsigned int i = 0; i < nitems;) {
-                const int x = data[i++];
-                const int y = data[i++];
-                const int w = data[i++];
-                const int h = data[i++];
+    Xcb::Property region(window(), atoms->net_wm_opaque_region, XCB_ATOM_CARDINAL, 0, 32768);
+    getWmOpaqueRegion(region);
+}
 
-                new_opaque_region += QRect(x,y,w,h);
-            }
-            XFree(data);
-        } else {
-            kWarning(1212) << "XGetWindowProperty failed";
-            break;
+void Toplevel::getWmOpaqueRegion(Xcb::Property &region)
+{
+    QRegion new_opaque_region;
+    uint32_t count = 0;
+    const uint32_t *data = static_cast<const uint32_t*>(region.value(XCB_ATOM_CARDINAL, 32, &count));
+    // it can happen, that the window does not provide this property
+    if (data && count % 4 == 0) {
+        for (uint32_t i = 0; i < count;) {
+            const int x = data[i++];
+            const int y = data[i++];
+            const int w = data[i++];
+            const int h = data[i++];
+
+            new_opaque_region += QRect(x, y, w, h);
         }
-    } while (bytes_after_return > 0);
+    }
 
     opaque_region = new_opaque_region;
 }
@@ -353,6 +353,7 @@ protected:
     void discardWindowPixmap();
     void addDamageFull();
     void getWmClientLeader();
+    void getWmClientLeader(Xcb::Property &leader);
     void getWmClientMachine();
     /**
      * @returns Whether there is a compositor and it is active.
@@ -364,9 +365,12 @@ protected:
      * Will only be called on corresponding property changes and for initialization.
      **/
     void getWmOpaqueRegion();
+    void getWmOpaqueRegion(Xcb::Property &region);
 
     void getResourceClass();
+    void getResourceClass(Xcb::Property &classHint);
     void getWindowRole();
+    void getWindowRole(Xcb::Property &role);
     virtual void debug(QDebug& stream) const = 0;
     void copyToDeleted(Toplevel* c);
     void disownDataPassedToDeleted();
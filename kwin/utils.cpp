@@ -44,6 +44,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "atoms.h"
 #include "cursor.h"
 #include "workspace.h"
+#include "xcbutils.h"
 
 #endif
 
@@ -75,17 +76,18 @@ StrutRect::StrutRect(const StrutRect& other)
 void Motif::readFlags(xcb_window_t w, bool& got_noborder, bool& noborder,
                       bool& resize, bool& move, bool& minimize, bool& maximize, bool& close)
 {
-    Atom type;
-    int format;
-    unsigned long length, after;
-    unsigned char* data;
-    MwmHints* hints = 0;
-    if (XGetWindowProperty(display(), w, atoms->motif_wm_hints, 0, 5,
-                          false, atoms->motif_wm_hints, &type, &format,
-                          &length, &after, &data) == Success) {
-        if (data)
-            hints = (MwmHints*) data;
-    }
+    Xcb::Property hints(w, atoms->motif_wm_hints, atoms->motif_wm_hints, 0, 5);
+    readFlags(hints, got_noborder, noborder, resize, move, minimize, maximize, close);
+}
+
+void Motif::readFlags(Xcb::Property &property, bool& got_noborder, bool& noborder,
+                      bool& resize, bool& move, bool& minimize, bool& maximize, bool& close)
+{
+    // The property consists of the 32 bit values flags, functions, decorations, input mode and status
+    uint32_t count = 0;
+    const uint32_t *hints = static_cast<const uint32_t*>(property.value(atoms->motif_wm_hints, 32, &count));
+    if (count < 3)
+        hints = NULL;
     got_noborder = false;
     noborder = false;
     resize = true;
@@ -95,26 +97,28 @@ void Motif::readFlags(xcb_window_t w, bool& got_noborder, bool& noborder,
     close = true;
     if (hints) {
         // To quote from Metacity 'We support those MWM hints deemed non-stupid'
-        if (hints->flags & MWM_HINTS_FUNCTIONS) {
+        const uint32_t flags = hints[0];
+        const uint32_t functions = hints[1];
+        const uint32_t decorations = hints[2];
+        if (flags & MWM_HINTS_FUNCTIONS) {
             // if MWM_FUNC_ALL is set, other flags say what to turn _off_
-            bool set_value = ((hints->functions & MWM_FUNC_ALL) == 0);
+            bool set_value = ((functions & MWM_FUNC_ALL) == 0);
             resize = move = minimize = maximize = close = !set_value;
-            if (hints->functions & MWM_FUNC_RESIZE)
+            if (functions & MWM_FUNC_RESIZE)
                 resize = set_value;
-            if (hints->functions & MWM_FUNC_MOVE)
+            if (functions & MWM_FUNC_MOVE)
                 move = set_value;
-            if (hints->functions & MWM_FUNC_MINIMIZE)
+            if (functions & MWM_FUNC_MINIMIZE)
                 minimize = set_value;
-            if (hints->functions & MWM_FUNC_MAXIMIZE)
+            if (functions & MWM_FUNC_MAXIMIZE)
                 maximize = set_value;
-            if (hints->functions & MWM_FUNC_CLOSE)
+            if (functions & MWM_FUNC_CLOSE)
                 close = set_value;
         }
-        if (hints->flags & MWM_HINTS_DECORATIONS) {
+        if (flags & MWM_HINTS_DECORATIONS) {
             got_noborder = true;
-            noborder = !hints->decorations;
+            noborder = !decorations;
         }
-        XFree(data);
     }
 }
 
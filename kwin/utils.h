@@ -159,6 +159,11 @@ enum HiddenPreviews {
     HiddenPreviewsAlways
 };
 
+namespace Xcb
+{
+class Property;
+}
+
 class Motif
 {
 public:
@@ -169,6 +174,10 @@ public:
     static void readFlags(xcb_window_t w, bool& got_noborder, bool& noborder,
                           bool& resize, bool& move, bool& minimize, bool& maximize,
                           bool& close);
+    // Same as above, but for the already requested property
+    static void readFlags(Xcb::Property &hints, bool& got_noborder, bool& noborder,
+                          bool& resize, bool& move, bool& minimize, bool& maximize,
+                          bool& close);
     struct MwmHints {
         ulong flags;
         ulong functions;
@@ -40,6 +40,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "effects.h"
 #include "focuschain.h"
 #include "group.h"
+#include "iconcache.h"
 #include "killwindow.h"
 #include "netinfo.h"
 #include "outline.h"
@@ -55,6 +56,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifdef KWIN_BUILD_TABBOX
 #include "tabbox.h"
 #endif
+#include "thumbnailitem.h"
 #include "unmanaged.h"
 #include "useractions.h"
 #include "virtualdesktops.h"
@@ -211,6 +213,7 @@ Workspace::Workspace(bool restore)
 #endif
 
     m_compositor = Compositor::create(this);
+    ThumbnailService::create(this);
     connect(this, SIGNAL(currentDesktopChanged(int,KWin::Client*)), m_compositor, SLOT(addRepaintFull()));
     connect(m_compositor, SIGNAL(compositingToggled(bool)), decorationPlugin(), SLOT(resetCompositing()));
 
@@ -233,6 +236,7 @@ Workspace::Workspace(bool restore)
     client_keys = new KActionCollection(this);
 
     Outline::create(this);
+    IconCache::create(this);
 
     initShortcuts();
 
@@ -440,6 +444,7 @@ Workspace::~Workspace()
     }
     for (UnmanagedList::iterator it = unmanaged.begin(), end = unmanaged.end(); it != end; ++it)
         (*it)->release(true);
+    m_windowIds.clear();
     XDeleteProperty(display(), rootWindow(), atoms->kwin_running);
 
     delete RuleBook::self();
@@ -502,6 +507,12 @@ void Workspace::addClient(Client* c)
 
     emit clientAdded(c);
 
+    addWindowId(c->window(), c, ClientWindowId);
+    addWindowId(c->wrapperId(), c, WrapperWindowId);
+    addWindowId(c->frameId(), c, FrameWindowId);
+    if (c->inputId() != XCB_WINDOW_NONE)
+        addWindowId(c->inputId(), c, InputWindowId);
+
     if (grp != NULL)
         grp->gotLeader(c);
 
@@ -545,6 +556,7 @@ void Workspace::addClient(Client* c)
 void Workspace::addUnmanaged(Unmanaged* c)
 {
     unmanaged.append(c);
+    addWindowId(c->window(), c, UnmanagedWindowId);
     x_stacking_dirty = true;
 }
 
@@ -580,6 +592,11 @@ void Workspace::removeClient(Client* c)
     // TODO: if marked client is removed, notify the marked list
     clients.removeAll(c);
     desktops.removeAll(c);
+    removeWindowId(c->window(), c);
+    removeWindowId(c->wrapperId(), c);
+    removeWindowId(c->frameId(), c);
+    if (c->inputId() != XCB_WINDOW_NONE)
+        removeWindowId(c->inputId(), c);
     x_stacking_dirty = true;
     attention_chain.removeAll(c);
     showing_desktop_clients.removeAll(c);
@@ -612,9 +629,43 @@ void Workspace::removeUnmanaged(Unmanaged* c)
 {
     assert(unmanaged.contains(c));
     unmanaged.removeAll(c);
+    removeWindowId(c->window(), c);
     x_stacking_dirty = true;
 }
 
+void Workspace::addWindowId(xcb_window_t w, Toplevel *t, WindowIdRole role)
+{
+    WindowIdEntry entry;
+    entry.toplevel = t;
+    entry.role = role;
+    m_windowIds.insert(w, entry);
+}
+
+void Workspace::removeWindowId(xcb_window_t w, Toplevel *t)
+{
+    QHash<xcb_window_t, WindowIdEntry>::iterator it = m_windowIds.find(w);
+    if (it != m_windowIds.end() && it->toplevel == t)
+        m_windowIds.erase(it);
+}
+
+Client *Workspace::findClientByWindowId(xcb_window_t w, WindowIdRole *role) const
+{
+    QHash<xcb_window_t, WindowIdEntry>::const_iterator it = m_windowIds.constFind(w);
+    if (it == m_windowIds.constEnd() || it->role == UnmanagedWindowId)
+        return NULL;
+    if (role)
+        *role = it->role;
+    return static_cast<Client*>(it->toplevel);
+}
+
+Unmanaged *Workspace::findUnmanagedByWindowId(xcb_window_t w) const
+{
+    QHash<xcb_window_t, WindowIdEntry>::const_iterator it = m_windowIds.constFind(w);
+    if (it == m_windowIds.constEnd() || it->role != UnmanagedWindowId)
+        return NULL;
+    return static_cast<Unmanaged*>(it->toplevel);
+}
+
 void Workspace::addDeleted(Deleted* c, Toplevel *orig)
 {
     assert(!deleted.contains(c));
@@ -28,6 +28,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "sm.h"
 #include "utils.h"
 // Qt
+#include <QHash>
 #include <QTimer>
 #include <QVector>
 // X
@@ -80,6 +81,37 @@ public:
     template<typename T1, typename T2> void forEachUnmanaged(T1 procedure, T2 predicate);
     template<typename T> void forEachUnmanaged(T procedure);
 
+    /**
+     * The role an X window plays for the Toplevel it belongs to.
+     **/
+    enum WindowIdRole {
+        ClientWindowId,
+        WrapperWindowId,
+        FrameWindowId,
+        InputWindowId,
+        UnmanagedWindowId
+    };
+    /**
+     * Finds the Client owning the X window @p w in constant time. The window can be the client
+     * window, the wrapper, the frame or the decoration input window of the Client. If @p role is
+     * not null it is set to the role of the window.
+     **/
+    Client *findClientByWindowId(xcb_window_t w, WindowIdRole *role = NULL) const;
+    /**
+     * Finds the Unmanaged for the X window @p w in constant time.
+     **/
+    Unmanaged *findUnmanagedByWindowId(xcb_window_t w) const;
+    /**
+     * Registers the X window @p w as belonging to @p t in the given @p role.
+     * Called whenever a Client or Unmanaged gets added and when a Client creates its input window.
+     **/
+    void addWindowId(xcb_window_t w, Toplevel *t, WindowIdRole role);
+    /**
+     * Unregisters the X window @p w, unless it has been registered for another Toplevel than @p t
+     * in the meantime.
+     **/
+    void removeWindowId(xcb_window_t w, Toplevel *t);
+
     QRect clientArea(clientAreaOption, const QPoint& p, int desktop) const;
     QRect clientArea(clientAreaOption, const Client* c) const;
     QRect clientArea(clientAreaOption, int screen, int desktop) const;
@@ -481,6 +513,13 @@ private:
     UnmanagedList unmanaged;
     DeletedList deleted;
 
+    struct WindowIdEntry {
+        Toplevel *toplevel;
+        WindowIdRole role;
+    };
+    // All X windows of clients and unmanaged, used for dispatching the X events
+    QHash<xcb_window_t, WindowIdEntry> m_windowIds;
+
     ToplevelList unconstrained_stacking_order; // Topmost last
     ToplevelList stacking_order; // Topmost last
     bool force_restacking;
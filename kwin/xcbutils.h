@@ -42,6 +42,16 @@ static void setInputFocus(xcb_window_t window, uint8_t revertTo = XCB_INPUT_FOCU
 static void moveWindow(xcb_window_t window, const QPoint &pos);
 static void moveWindow(xcb_window_t window, uint32_t x, uint32_t y);
 
+/**
+ * The number of replies waited for through the Wrapper classes, that is the number of
+ * round trips to the X server. Only used for statistics.
+ **/
+inline quint64 &roundTrips()
+{
+    static quint64 s_roundTrips = 0;
+    return s_roundTrips;
+}
+
 template <typename Reply,
     typename Cookie,
     Reply *(*replyFunc)(xcb_connection_t*, Cookie, xcb_generic_error_t**),
@@ -126,12 +136,24 @@ public:
     }
 
 protected:
+    /**
+     * Takes over the already issued request identified by @p cookie. Used by wrappers for
+     * requests which need more arguments than just the window.
+     **/
+    Wrapper(WindowId window, Cookie cookie)
+        : m_retrieved(false)
+        , m_cookie(cookie)
+        , m_window(window)
+        , m_reply(NULL)
+    {
+    }
     void getReply() {
         if (m_retrieved || !m_cookie.sequence) {
             return;
         }
         m_reply = replyFunc(connection(), m_cookie, NULL);
         m_retrieved = true;
+        ++roundTrips();
     }
 
 private:
@@ -235,6 +257,63 @@ public:
     }
 };
 
+/**
+ * Request function for Property, which is never used as Property issues the request itself.
+ **/
+inline xcb_get_property_cookie_t get_property_invalid(xcb_connection_t *c, xcb_window_t window)
+{
+    Q_UNUSED(c)
+    Q_UNUSED(window)
+    xcb_get_property_cookie_t cookie;
+    cookie.sequence = 0;
+    return cookie;
+}
+
+/**
+ * @brief Wrapper for an arbitrary window property.
+ *
+ * The request is sent in the constructor, so several properties can be requested at once
+ * and the replies are only waited for when the values are accessed.
+ **/
+class Property : public Wrapper<xcb_get_property_reply_t, xcb_get_property_cookie_t, &xcb_get_property_reply, &get_property_invalid>
+{
+public:
+    Property(WindowId window, xcb_atom_t property, xcb_atom_t type, uint32_t offset, uint32_t length)
+        : Wrapper<xcb_get_property_reply_t, xcb_get_property_cookie_t, &xcb_get_property_reply, &get_property_invalid>(window,
+              xcb_get_property_unchecked(connection(), false, window, property, type, offset, length))
+    {
+    }
+
+    /**
+     * @returns The value of the property if it is of the given @p type and @p format, otherwise @c null.
+     * @param count Set to the number of items in the value, that is 0 if the value is @c null.
+     **/
+    inline const void *value(xcb_atom_t type, uint8_t format, uint32_t *count = NULL) {
+        const xcb_get_property_reply_t *reply = data();
+        if (!reply || reply->type != type || reply->format != format) {
+            if (count) {
+                *count = 0;
+            }
+            return NULL;
+        }
+        if (count) {
+            *count = reply->value_len;
+        }
+        return xcb_get_property_value(reply);
+    }
+    /**
+     * @returns The value of a property of 8 bit format and given @p type, empty if the property is not set.
+     **/
+    inline QByteArray toByteArray(xcb_atom_t type = XCB_ATOM_STRING) {
+        uint32_t count = 0;
+        const char *data = static_cast<const char*>(value(type, 8, &count));
+        if (!data) {
+            return QByteArray();
+        }
+        return QByteArray(data, count);
+    }
+};
+
 class ExtensionData
 {
 public:
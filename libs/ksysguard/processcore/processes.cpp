@@ -105,7 +105,8 @@ Processes::Processes(const QString &host, QObject *parent) : QObject(parent), d(
         connect(remote, SIGNAL(runCommand(QString,int)), this, SIGNAL(runCommand(QString,int)));
     }
     d->mIsLocalHost = host.isEmpty();
-    connect( d->mAbstractProcesses, SIGNAL(processesUpdated()), SLOT(processesUpdated()));
+    //The local backend emits this from within updateAllProcesses(), which may be called from another thread than the one we live in
+    connect( d->mAbstractProcesses, SIGNAL(processesUpdated()), SLOT(processesUpdated()), Qt::DirectConnection);
 }
 Processes::~Processes()
 {
@@ -484,7 +485,7 @@ void Processes::useCurrentData()
     if(d->mUsingHistoricalData) {
         delete d->mHistoricProcesses;
         d->mHistoricProcesses = NULL;
-        connect( d->mAbstractProcesses, SIGNAL(processesUpdated()), SLOT(processesUpdated()));
+        connect( d->mAbstractProcesses, SIGNAL(processesUpdated()), SLOT(processesUpdated()), Qt::DirectConnection);
         d->mUsingHistoricalData = false;
     }
 }
@@ -65,7 +65,10 @@ namespace KSysGuard
         enum UpdateFlag {
             StandardInformation = 1,
             IOStatistics = 2,
-            XMemory = 4
+            XMemory = 4,
+            /** Only the name, command line and user of the processes are needed, so the backend
+             *  may skip reading anything else.  Only the local Linux backend makes use of this */
+            MinimalInformation = 8
         };
         Q_DECLARE_FLAGS(UpdateFlags, UpdateFlag)
 
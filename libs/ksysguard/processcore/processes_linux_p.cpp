@@ -498,6 +498,12 @@ bool ProcessesLocal::updateProcessInfo( long pid, Process *process)
 {
     bool success = true;
     QString dir = "/proc/" + QString::number(pid) + '/';
+    if(mUpdateFlags.testFlag(Processes::MinimalInformation)) {
+        //Just enough to identify the process, which skips most of the files and system calls
+        if(!d->readProcStatus(dir, process)) success = false;
+        if(!d->readProcCmdline(dir, process)) success = false;
+        return success;
+    }
     if(!d->readProcStat(dir, process)) success = false;
     if(!d->readProcStatus(dir, process)) success = false;
     if(!d->readProcStatm(dir, process)) success = false;
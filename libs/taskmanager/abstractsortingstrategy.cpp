@@ -41,11 +41,27 @@ class AbstractSortingStrategy::Private
 {
 public:
     Private()
-        : type(GroupManager::NoSorting) {
+        : type(GroupManager::NoSorting),
+          lessThan(0) {
     }
 
+    // adapts AbstractSortingStrategy::lessThan() to the sorting algorithms
+    struct Compare {
+        Compare(const AbstractSortingStrategy *strategy)
+            : strategy(strategy) {
+        }
+
+        bool operator()(const AbstractGroupableItem *left, const AbstractGroupableItem *right) const {
+            return strategy->lessThan(left, right);
+        }
+
+        const AbstractSortingStrategy *strategy;
+    };
+
     QList<TaskGroup*> managedGroups;
     GroupManager::TaskSortingStrategy type;
+    // set by the strategies which sort incrementally
+    LessThan lessThan;
 };
 
 
@@ -71,6 +87,11 @@ void AbstractSortingStrategy::setType(GroupManager::TaskSortingStrategy type)
     d->type = type;
 }
 
+void AbstractSortingStrategy::setLessThan(LessThan lessThan)
+{
+    d->lessThan = lessThan;
+}
+
 void AbstractSortingStrategy::handleGroup(TaskGroup *group)
 {
     //kDebug();
@@ -89,6 +110,29 @@ void AbstractSortingStrategy::handleGroup(TaskGroup *group)
     }
 }
 
+void AbstractSortingStrategy::sortGroup(TaskGroup *group)
+{
+    if (!group) {
+        return;
+    }
+
+    ItemList members = group->members();
+    ItemList sortedList = members;
+    sortItems(sortedList);
+    for (int i = 0; i < sortedList.count(); ++i) {
+        AbstractGroupableItem *item = sortedList.at(i);
+        const int oldIndex = members.indexOf(item);
+        if (oldIndex != i) {
+            group->moveItem(oldIndex, i);
+            members.move(oldIndex, i);
+        }
+
+        if (item->itemType() == GroupItemType) {
+            sortGroup(static_cast<TaskGroup *>(item));
+        }
+    }
+}
+
 void AbstractSortingStrategy::removeGroup()
 {
     TaskGroup *group = dynamic_cast<TaskGroup*>(sender());
@@ -139,11 +183,35 @@ void AbstractSortingStrategy::check(AbstractGroupableItem *itemToCheck)
         return;
     }
 
-    ItemList sortedList = item->parentGroup()->members();
-    sortItems(sortedList);
+    const ItemList members = item->parentGroup()->members();
+    const int oldIndex = members.indexOf(item);
+    int newIndex = oldIndex;
+
+    if (d->lessThan) {
+        // all other members are in order already; the item stays where it is
+        // if that is a valid place, like it would with a stable sort
+        const bool afterPrevious = oldIndex == 0 || !lessThan(item, members.at(oldIndex - 1));
+        const bool beforeNext = oldIndex == members.count() - 1 || !lessThan(members.at(oldIndex + 1), item);
+        if (!afterPrevious || !beforeNext) {
+            // binary search for the place after all members which are not greater
+            int low = 0;
+            int high = members.count() - 1;
+            while (low < high) {
+                const int middle = (low + high) / 2;
+                if (lessThan(item, members.at(middle < oldIndex ? middle : middle + 1))) {
+                    high = middle;
+                } else {
+                    low = middle + 1;
+                }
+            }
+            newIndex = low;
+        }
+    } else {
+        ItemList sortedList = members;
+        sortItems(sortedList);
+        newIndex = sortedList.indexOf(item);
+    }
 
-    int oldIndex = item->parentGroup()->members().indexOf(item);
-    int newIndex = sortedList.indexOf(item);
     if (oldIndex != newIndex) {
         item->parentGroup()->moveItem(oldIndex, newIndex);
     }
@@ -151,7 +219,14 @@ void AbstractSortingStrategy::check(AbstractGroupableItem *itemToCheck)
 
 void AbstractSortingStrategy::sortItems(ItemList &items)
 {
-    Q_UNUSED(items)
+    if (d->lessThan) {
+        qStableSort(items.begin(), items.end(), Private::Compare(this));
+    }
+}
+
+bool AbstractSortingStrategy::lessThan(const AbstractGroupableItem *left, const AbstractGroupableItem *right) const
+{
+    return d->lessThan && d->lessThan(this, left, right);
 }
 
 bool AbstractSortingStrategy::manualSortingRequest(AbstractGroupableItem *item, int newIndex)
@@ -49,6 +49,11 @@ public:
 
     /** Adds group under control of sorting strategy. all added subgroups are automatically added to this sortingStrategy*/
     void handleGroup(TaskGroup *);
+    /**
+     * Sorts the members of a handled group and of its subgroups again, e.g. after
+     * they changed while the group was not shown.
+     */
+    void sortGroup(TaskGroup *group);
 
     /** Moves Item to new index*/
     bool moveItem(AbstractGroupableItem *, int);
@@ -67,10 +72,28 @@ protected Q_SLOTS:
 protected:
     void setType(GroupManager::TaskSortingStrategy strategy);
 
+    /**
+     * Returns true if @p left has to be placed before @p right by @p strategy.
+     */
+    typedef bool (*LessThan)(const AbstractSortingStrategy *strategy,
+                             const AbstractGroupableItem *left, const AbstractGroupableItem *right);
+    /**
+     * Strategies which define their order by comparing two items pass the
+     * comparison here instead of reimplementing sortItems(). A changed item
+     * is then moved to its place by a binary search instead of sorting its
+     * whole group again.
+     */
+    void setLessThan(LessThan lessThan);
+    /**
+     * Compares two items with the function passed to setLessThan().
+     */
+    bool lessThan(const AbstractGroupableItem *left, const AbstractGroupableItem *right) const;
+
 private:
     /**
      * Sorts list of items according to startegy.
-     * Has to be reimplemented by every SortingStrategy.
+     * Has to be reimplemented by every SortingStrategy which does not
+     * call setLessThan().
      *
      * @param items the items that are to be sorted; the list is passed
      *        in by value and should be in the proprer sorting order when
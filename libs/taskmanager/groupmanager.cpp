@@ -74,13 +74,16 @@ public:
           readingLauncherConfig(false),
           separateLaunchers(true),
           forceGrouping(false),
-          launchersLocked(false)
+          launchersLocked(false),
+          reloadAll(false)
     {
     }
 
-    /** reload all tasks from TaskManager */
-    void reloadTasks();
+    /** reload all tasks from TaskManager, only applying the changed filters unless @p all is set */
+    void reloadTasks(bool all = false);
     void actuallyReloadTasks();
+    /** add all tasks from TaskManager again, e.g. to group them anew */
+    void reloadAllTasks();
 
     /**
     * Keep track of changes in Taskmanager
@@ -93,6 +96,8 @@ public:
     void startupItemDestroyed(AbstractGroupableItem *);
     void checkIfFull();
     void actuallyCheckIfFull();
+    bool isTaskShown(::TaskManager::Task *);
+    void placeItem(TaskItem *, ::TaskManager::Task *);
     bool addTask(::TaskManager::Task *);
     void removeTask(::TaskManager::Task *);
     void addStartup(::TaskManager::Startup *);
@@ -141,6 +146,7 @@ public:
     bool separateLaunchers : 1;
     bool forceGrouping : 1;
     bool launchersLocked : 1;
+    bool reloadAll : 1;
 };
 
 
@@ -185,14 +191,77 @@ TaskGroup *GroupManagerPrivate::currentRootGroup()
     return rootGroups[currentActivity][currentDesktop];
 }
 
-void GroupManagerPrivate::reloadTasks()
+void GroupManagerPrivate::reloadTasks(bool all)
 {
+    reloadAll = reloadAll || all;
     reloadTimer.start();
 }
 
 void GroupManagerPrivate::actuallyReloadTasks()
 {
+    if (reloadAll) {
+        reloadAllTasks();
+        return;
+    }
+
     //kDebug() << "number of tasks available " << TaskManager::self()->tasks().size();
+    // collect the items in the current root group at once, looking up
+    // each task in the group would make the reload quadratic
+    QHash<WId, TaskItem *> shownItems;
+    QStack<TaskGroup *> groups;
+    groups.push(currentRootGroup());
+    while (!groups.isEmpty()) {
+        TaskGroup *group = groups.pop();
+
+        foreach (AbstractGroupableItem * item, group->members()) {
+            if (item->itemType() == GroupItemType) {
+                groups.push(static_cast<TaskGroup *>(item));
+            } else if (item->itemType() == TaskItemType) {
+                TaskItem *taskItem = static_cast<TaskItem *>(item);
+                if (taskItem->task()) {
+                    shownItems.insert(taskItem->task()->window(), taskItem);
+                }
+            }
+        }
+    }
+
+    // only add the tasks which enter and remove the tasks which leave the
+    // filters, the tasks which are already shown keep their items
+    QList<Task *> enteringTasks;
+    QHashIterator<WId, Task *> it(TaskManager::self()->tasks());
+    while (it.hasNext()) {
+        it.next();
+
+        TaskItem *item = shownItems.value(it.value()->window());
+        if (isTaskShown(it.value())) {
+            if (item) {
+                // the task may have changed while this root group was not the
+                // current one, so it is grouped again like on a full reload
+                placeItem(item, it.value());
+            } else {
+                enteringTasks << it.value();
+            }
+        } else if (item) {
+            removeTask(it.value());
+        }
+    }
+
+    // the order of the kept items may be stale as well, it is restored at once
+    // so that the entering tasks can be sorted into it one by one
+    if (abstractSortingStrategy && !shownItems.isEmpty()) {
+        abstractSortingStrategy->sortGroup(currentRootGroup());
+    }
+
+    foreach (Task *task, enteringTasks) {
+        addTask(task);
+    }
+
+    emit q->reload();
+}
+
+void GroupManagerPrivate::reloadAllTasks()
+{
+    reloadAll = false;
     QHash<WId, Task *> taskList = TaskManager::self()->tasks();
     QMutableHashIterator<WId, Task *> it(taskList);
 
@@ -243,19 +312,8 @@ void GroupManagerPrivate::removeStartup(::TaskManager::Startup *task)
     item->setTaskPointer(0);
 }
 
-bool GroupManagerPrivate::addTask(::TaskManager::Task *task)
+bool GroupManagerPrivate::isTaskShown(::TaskManager::Task *task)
 {
-    if (!task) {
-        return false;
-    }
-
-    //kDebug();
-    /* kDebug() << task->visibleName()
-             << task->visibleNameWithState()
-             << task->name()
-             << task->className()
-             << task->classClass(); */
-
     bool skip = false;
     if (!task->showInTaskbar()) {
         //kDebug() << "Do not show in taskbar";
@@ -310,6 +368,39 @@ bool GroupManagerPrivate::addTask(::TaskManager::Task *task)
         */
     }
 
+    return !skip;
+}
+
+void GroupManagerPrivate::placeItem(TaskItem *item, ::TaskManager::Task *task)
+{
+    //Find a fitting group for the task with GroupingStrategies
+    if (abstractGroupingStrategy && (forceGrouping || !task->demandsAttention())) { //do not group attention tasks
+        abstractGroupingStrategy->handleItem(item);
+    } else {
+        currentRootGroup()->add(item);
+
+        if (abstractSortingStrategy) {
+            abstractSortingStrategy->handleItem(item);
+            abstractSortingStrategy->check(item);
+        }
+    }
+}
+
+bool GroupManagerPrivate::addTask(::TaskManager::Task *task)
+{
+    if (!task) {
+        return false;
+    }
+
+    //kDebug();
+    /* kDebug() << task->visibleName()
+             << task->visibleNameWithState()
+             << task->name()
+             << task->className()
+             << task->classClass(); */
+
+    const bool skip = !isTaskShown(task);
+
     //Ok the Task should be displayed
     TaskItem *item = qobject_cast<TaskItem*>(currentRootGroup()->getMemberByWId(task->window()));
     if (!item || skip) {
@@ -350,17 +441,7 @@ bool GroupManagerPrivate::addTask(::TaskManager::Task *task)
         }
     }
 
-    //Find a fitting group for the task with GroupingStrategies
-    if (abstractGroupingStrategy && (forceGrouping || !task->demandsAttention())) { //do not group attention tasks
-        abstractGroupingStrategy->handleItem(item);
-    } else {
-        currentRootGroup()->add(item);
-
-        if (abstractSortingStrategy) {
-            abstractSortingStrategy->handleItem(item);
-            abstractSortingStrategy->check(item);
-        }
-    }
+    placeItem(item, task);
 
     if (showOnlyCurrentScreen) {
         geometryTasks.insert(task);
@@ -650,7 +731,7 @@ void GroupManager::reconnect()
         d->geometryTasks.clear();
     }
 
-    d->reloadTasks();
+    d->reloadTasks(true);
 }
 
 KConfigGroup GroupManager::config() const
@@ -1388,7 +1469,7 @@ void GroupManager::setGroupingStrategy(TaskGroupingStrategy strategy)
 
     d->groupingStrategy = strategy;
 
-    d->actuallyReloadTasks();
+    d->reloadAllTasks();
 
     if (d->onlyGroupWhenFull) {
         connect(d->currentRootGroup(), SIGNAL(itemAdded(AbstractGroupableItem*)), this, SLOT(checkIfFull()));
@@ -0,0 +1,214 @@
+/*****************************************************************
+
+Copyright 2012 The KDE Team
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+// Own
+#include "iconcache.h"
+
+// Qt
+#include <QCache>
+#include <QCryptographicHash>
+#include <QHash>
+
+// KDE
+#include <KGlobal>
+#include <KWindowSystem>
+#include <NETWinInfo>
+
+#ifdef Q_WS_X11
+#include <QX11Info>
+#endif
+
+namespace TaskManager
+{
+
+// Enough for the common icon sizes of about 100 different applications
+static const int s_cacheBudget = 8 * 1024 * 1024; // in bytes
+
+class IconCacheSingleton
+{
+public:
+    IconCache self;
+};
+
+K_GLOBAL_STATIC(IconCacheSingleton, privateIconCacheSelf)
+
+IconCache *IconCache::self()
+{
+    return &privateIconCacheSelf->self;
+}
+
+// identifies the content of an icon independently from the window
+struct IconKey {
+    bool isValid() const {
+        return size.isValid();
+    }
+
+    // a digest of the whole data, a plain hash could make two applications share an icon
+    QByteArray digest;
+    QSize size;
+};
+
+// the icon of a window, the data are only decoded on request
+struct WindowIcon {
+    WindowIcon()
+        : info(0) {
+    }
+
+    NETWinInfo *info;
+    IconKey key;
+};
+
+// a decoded icon in one of the requested sizes
+struct IconEntry {
+    bool operator==(const IconEntry &other) const {
+        return key.digest == other.key.digest && key.size == other.key.size &&
+               width == other.width && height == other.height &&
+               allowResize == other.allowResize;
+    }
+
+    IconKey key;
+    int width;
+    int height;
+    bool allowResize;
+};
+
+uint qHash(const IconEntry &entry)
+{
+    return qHash(entry.key.digest) ^ (entry.width << 16) ^ entry.height ^ entry.allowResize;
+}
+
+class IconCache::Private
+{
+public:
+    Private()
+        : cache(s_cacheBudget) {
+    }
+
+    ~Private() {
+        foreach (const WindowIcon &icon, windows) {
+            delete icon.info;
+        }
+    }
+
+    WindowIcon &windowIcon(WId window);
+
+    QHash<WId, WindowIcon> windows;
+    QCache<IconEntry, QPixmap> cache;
+};
+
+WindowIcon &IconCache::Private::windowIcon(WId window)
+{
+    WindowIcon &icon = windows[window];
+#ifdef Q_WS_X11
+    if (!icon.info) {
+        // the data of all sizes are read at once, they are only decoded when
+        // an icon is requested in a specific size
+        icon.info = new NETWinInfo(QX11Info::display(), window, QX11Info::appRootWindow(), NET::WMIcon);
+
+        // the largest icon is a good fingerprint of all of them
+        const NETIcon largest = icon.info->icon();
+        if (largest.data && largest.size.width > 0 && largest.size.height > 0) {
+            // the icon data are 32 bit ARGB values
+            icon.key.digest = QCryptographicHash::hash(QByteArray::fromRawData(reinterpret_cast<const char *>(largest.data),
+                                                                               largest.size.width * largest.size.height * 4),
+                                                       QCryptographicHash::Sha1);
+            icon.key.size = QSize(largest.size.width, largest.size.height);
+        }
+    }
+#endif
+
+    return icon;
+}
+
+IconCache::IconCache()
+    : QObject(),
+      d(new Private)
+{
+    connect(KWindowSystem::self(), SIGNAL(windowChanged(WId, const ulong*)),
+            this, SLOT(windowChanged(WId, const ulong*)));
+    connect(KWindowSystem::self(), SIGNAL(windowRemoved(WId)),
+            this, SLOT(windowRemoved(WId)));
+}
+
+IconCache::~IconCache()
+{
+    delete d;
+}
+
+QPixmap IconCache::icon(WId window, int width, int height, bool allowResize)
+{
+#ifdef Q_WS_X11
+    const WindowIcon &windowIcon = d->windowIcon(window);
+    if (!windowIcon.key.isValid()) {
+        // no _NET_WM_ICON, fall back to the other default sources of KWindowSystem::icon()
+        return KWindowSystem::icon(window, width, height, allowResize,
+                                   KWindowSystem::WMHints | KWindowSystem::ClassHint | KWindowSystem::XApp);
+    }
+
+    IconEntry entry;
+    entry.key = windowIcon.key;
+    entry.width = width;
+    entry.height = height;
+    entry.allowResize = allowResize;
+    if (QPixmap *pixmap = d->cache.object(entry)) {
+        return *pixmap;
+    }
+
+    // same as KWindowSystem::icon(): use the best matching size and scale it if requested
+    const NETIcon netIcon = windowIcon.info->icon(width, height);
+    QImage image(netIcon.data, netIcon.size.width, netIcon.size.height, QImage::Format_ARGB32);
+    if (allowResize && width > 0 && height > 0 && image.size() != QSize(width, height)) {
+        image = image.scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    const QPixmap pixmap = QPixmap::fromImage(image);
+    d->cache.insert(entry, new QPixmap(pixmap), pixmap.width() * pixmap.height() * 4);
+    return pixmap;
+#else
+    return KWindowSystem::icon(window, width, height, allowResize);
+#endif
+}
+
+void IconCache::windowChanged(WId window, const unsigned long *properties)
+{
+    if (!(properties[NETWinInfo::PROTOCOLS] & NET::WMIcon)) {
+        return;
+    }
+
+    // the icon is read again when it is requested the next time, the pixmaps
+    // of the old icon stay cached for the other windows sharing it
+    windowRemoved(window);
+}
+
+void IconCache::windowRemoved(WId window)
+{
+    QHash<WId, WindowIcon>::iterator it = d->windows.find(window);
+    if (it != d->windows.end()) {
+        delete it->info;
+        d->windows.erase(it);
+    }
+}
+
+} // TaskManager namespace
+
+#include "iconcache.moc"
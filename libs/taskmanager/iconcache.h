@@ -0,0 +1,74 @@
+/*****************************************************************
+
+Copyright 2012 The KDE Team
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef TASKMANAGER_ICONCACHE_H
+#define TASKMANAGER_ICONCACHE_H
+
+#include <QtCore/QObject>
+#include <QtGui/QPixmap>
+
+#include <taskmanager/taskmanager_export.h>
+
+namespace TaskManager
+{
+
+/**
+ * A process wide cache of the icons of windows, shared by the tasks and
+ * by all applets showing window icons.
+ *
+ * The _NET_WM_ICON property of a window is read once when its icon is
+ * requested first and again only after it changed. The icon is decoded and
+ * scaled lazily for each requested size, and windows providing the same icon
+ * data, e.g. the windows of one application, share the resulting pixmaps.
+ */
+class TASKMANAGER_EXPORT IconCache : public QObject
+{
+    Q_OBJECT
+public:
+    IconCache();
+    ~IconCache();
+
+    static IconCache *self();
+
+    /**
+     * Returns the icon of @p window like KWindowSystem::icon() does.
+     *
+     * @param width the desired width, or -1 for the largest available icon
+     * @param height the desired height, or -1 for the largest available icon
+     * @param allowResize whether the best matching icon is scaled to the
+     *        desired size if no icon of that size is available
+     */
+    QPixmap icon(WId window, int width = -1, int height = -1, bool allowResize = false);
+
+private Q_SLOTS:
+    void windowChanged(WId window, const unsigned long *properties);
+    void windowRemoved(WId window);
+
+private:
+    class Private;
+    Private * const d;
+};
+
+} // TaskManager namespace
+
+#endif
@@ -23,12 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "alphasortingstrategy.h"
 
-#include <QMap>
 #include <QString>
-#include <QtAlgorithms>
-#include <QList>
-
-#include <KDebug>
 
 #include "taskitem.h"
 #include "taskgroup.h"
@@ -38,60 +33,40 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace TaskManager
 {
 
-AlphaSortingStrategy::AlphaSortingStrategy(QObject *parent)
-    : AbstractSortingStrategy(parent)
-{
-    setType(GroupManager::AlphaSorting);
-}
-
-void AlphaSortingStrategy::sortItems(ItemList &items)
+static QString sortingName(const AbstractGroupableItem *item)
 {
-    GroupManager *gm = qobject_cast<GroupManager *>(parent());
-    bool         separateLaunchers = !gm || gm->separateLaunchers();
-
-    //kDebug();
-    QMap<QString, AbstractGroupableItem*> map;
-    QMap<QString, AbstractGroupableItem*> launcherMap;
-
-    foreach (AbstractGroupableItem * groupable, items) {
-        if (!groupable) {
-            continue;
+    if (item->itemType() == TaskItemType) {
+        const TaskItem *taskItem = static_cast<const TaskItem *>(item);
+        if (taskItem->task()) {
+            //sort by programname not windowname
+            return taskItem->taskName().toLower();
         }
-        
-        if (groupable->itemType() == GroupItemType) {
-            map.insertMulti(groupable->name().toLower(), groupable);
-            continue;
-        } else if (groupable->itemType() == LauncherItemType) {
-            if (separateLaunchers) {
-                launcherMap.insertMulti(groupable->name().toLower(), groupable);
-            } else {
-                map.insertMulti(groupable->name().toLower(), groupable);
-            }
-            continue;
-        }
-
+    }
 
-        TaskItem *item = qobject_cast<TaskItem*>(groupable);
-        if (!item)  {
-            kDebug() << "Wrong object type";
-            continue;
-        }
+    return item->name().toLower();
+}
 
-        if (!item->task()) {
-            kDebug() << "Null Pointer";
-            continue;
+static bool alphaLessThan(const AbstractSortingStrategy *strategy,
+                          const AbstractGroupableItem *left, const AbstractGroupableItem *right)
+{
+    GroupManager *gm = qobject_cast<GroupManager *>(strategy->parent());
+    if (!gm || gm->separateLaunchers()) {
+        // launchers are kept in front of all other items
+        const bool leftIsLauncher = left->itemType() == LauncherItemType;
+        const bool rightIsLauncher = right->itemType() == LauncherItemType;
+        if (leftIsLauncher != rightIsLauncher) {
+            return leftIsLauncher;
         }
-
-        //sort by programname not windowname
-        //kDebug() << "inserting multi item" <<  item->task()->classClass();
-        map.insertMulti(item->taskName().toLower(), groupable);
     }
 
-    items.clear();
-    if (separateLaunchers) {
-        items << launcherMap.values();
-    }
-    items << map.values();
+    return sortingName(left) < sortingName(right);
+}
+
+AlphaSortingStrategy::AlphaSortingStrategy(QObject *parent)
+    : AbstractSortingStrategy(parent)
+{
+    setType(GroupManager::AlphaSorting);
+    setLessThan(alphaLessThan);
 }
 
 } //namespace
@@ -37,10 +37,6 @@ class AlphaSortingStrategy : public AbstractSortingStrategy
     Q_OBJECT
 public:
     AlphaSortingStrategy(QObject *parent);
-
-private:
-    /** Sorts list of items according to strategy*/
-    void sortItems(ItemList&);
 };
 
 } // TaskManager namespace
@@ -23,10 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "desktopsortingstrategy.h"
 
-#include <QMap>
 #include <QString>
-#include <QtAlgorithms>
-#include <QList>
 
 #include <KDebug>
 
@@ -45,20 +42,6 @@ static QString agiName(const AbstractGroupableItem *i)
     }
 }
 
-DesktopSortingStrategy::DesktopSortingStrategy(QObject *parent)
-    : AbstractSortingStrategy(parent)
-{
-    setType(GroupManager::DesktopSorting);
-}
-
-void DesktopSortingStrategy::sortItems(ItemList &items)
-{
-    GroupManager *gm = qobject_cast<GroupManager *>(parent());
-    qStableSort(items.begin(), items.end(), (gm && gm->separateLaunchers()) ?
-                                                DesktopSortingStrategy::lessThanSeperateLaunchers :
-                                                DesktopSortingStrategy::lessThan);
-}
-
 /*
  * Sorting strategy is as follows:
  * For two items being compared
@@ -66,7 +49,7 @@ void DesktopSortingStrategy::sortItems(ItemList &items)
  *   - If both are not startup tasks first compare items by desktop number,
  *     and then for items which belong to the same desktop sort by their NAME.
  */
-bool DesktopSortingStrategy::lessThan(const AbstractGroupableItem *left, const AbstractGroupableItem *right)
+static bool desktopLessThan(const AbstractGroupableItem *left, const AbstractGroupableItem *right)
 {
     const int leftDesktop = left->desktop();
     const int rightDesktop = right->desktop();
@@ -77,7 +60,7 @@ bool DesktopSortingStrategy::lessThan(const AbstractGroupableItem *left, const A
     return leftDesktop < rightDesktop;
 }
 
-bool DesktopSortingStrategy::lessThanSeperateLaunchers(const AbstractGroupableItem *left, const AbstractGroupableItem *right)
+static bool lessThanSeperateLaunchers(const AbstractGroupableItem *left, const AbstractGroupableItem *right)
 {
     if (left->isStartupItem()) {
         if (right->isStartupItem()) {
@@ -101,7 +84,25 @@ bool DesktopSortingStrategy::lessThanSeperateLaunchers(const AbstractGroupableIt
         return false;
     }
 
-    return lessThan(left, right);
+    return desktopLessThan(left, right);
+}
+
+static bool strategyLessThan(const AbstractSortingStrategy *strategy,
+                             const AbstractGroupableItem *left, const AbstractGroupableItem *right)
+{
+    GroupManager *gm = qobject_cast<GroupManager *>(strategy->parent());
+    if (gm && gm->separateLaunchers()) {
+        return lessThanSeperateLaunchers(left, right);
+    }
+
+    return desktopLessThan(left, right);
+}
+
+DesktopSortingStrategy::DesktopSortingStrategy(QObject *parent)
+    : AbstractSortingStrategy(parent)
+{
+    setType(GroupManager::DesktopSorting);
+    setLessThan(strategyLessThan);
 }
 
 void DesktopSortingStrategy::handleItem(AbstractGroupableItem *item)
@@ -40,11 +40,6 @@ public:
 protected Q_SLOTS:
     /** Handles a new item*/
     virtual void handleItem(AbstractGroupableItem *);
-private:
-    /** Sorts list of items according to strategy*/
-    void sortItems(ItemList&);
-    static bool lessThan(const AbstractGroupableItem *left, const AbstractGroupableItem *right);
-    static bool lessThanSeperateLaunchers(const AbstractGroupableItem *left, const AbstractGroupableItem *right);
 };
 
 
@@ -37,6 +37,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <KIconLoader>
 #include <KLocale>
 
+#include "iconcache.h"
 #include "taskmanager.h"
 
 namespace TaskManager
@@ -58,23 +59,15 @@ Task::~Task()
     delete d;
 }
 
-void Task::timerEvent(QTimerEvent *)
+void Task::timerEvent(QTimerEvent *event)
 {
-    if (d->cachedChanges.netWindowInfoProperties || d->cachedChanges.netWindowInfoProperties2) {
-        d->lastUpdate = QTime();
-        refresh(d->cachedChanges);
-        d->cachedChanges.netWindowInfoProperties = 0;
-        d->cachedChanges.netWindowInfoProperties2 = 0;
-    }
-
-    killTimer(d->cachedChangesTimerId);
-    d->cachedChangesTimerId = 0;
+    QObject::timerEvent(event);
 }
 
 void Task::refreshIcon()
 {
     // try to load icon via net_wm
-    d->pixmap = KWindowSystem::icon(d->win, 16, 16, true);
+    d->pixmap = IconCache::self()->icon(d->win, 16, 16, true);
 
     // try to guess the icon from the classhint
     if (d->pixmap.isNull()) {
@@ -90,41 +83,33 @@ void Task::refreshIcon()
         }
     }
 
-    d->lastIcon = QPixmap();
     d->icon = QIcon();
     emit changed(IconChanged);
 }
 
 ::TaskManager::TaskChanges Task::refresh(WindowProperties dirty)
 {
-    if (!d->lastUpdate.isNull() && d->lastUpdate.elapsed() < 200) {
-        d->cachedChanges.netWindowInfoProperties |= dirty.netWindowInfoProperties;
-        d->cachedChanges.netWindowInfoProperties2 |= dirty.netWindowInfoProperties2;
+    // changes are already coalesced per frame by the TaskManager, so only
+    // fetch the window info again if one of its properties is dirty
+    TaskChanges changes = TaskUnchanged;
+    if ((dirty.netWindowInfoProperties & (windowInfoFlags | NET::WMName)) ||
+        (dirty.netWindowInfoProperties2 & windowInfoFlags2)) {
+        KWindowInfo info = KWindowSystem::windowInfo(d->win, windowInfoFlags, windowInfoFlags2);
 
-        if (!d->cachedChangesTimerId) {
-            d->cachedChangesTimerId = startTimer(200 - d->lastUpdate.elapsed());
+        if (d->info.windowClassClass() != info.windowClassClass() ||
+            d->info.windowClassName() != info.windowClassName()) {
+            changes |= ClassChanged;
         }
 
-        return TaskUnchanged;
-    }
-
-    d->lastUpdate.restart();
-    KWindowInfo info = KWindowSystem::windowInfo(d->win, windowInfoFlags, windowInfoFlags2);
-    TaskChanges changes = TaskUnchanged;
-
-    if (d->info.windowClassClass() != info.windowClassClass() ||
-        d->info.windowClassName() != info.windowClassName()) {
-        changes |= ClassChanged;
-    }
+        if (d->info.visibleName() != info.visibleName() ||
+            d->info.visibleNameWithState() != info.visibleNameWithState() ||
+            d->info.name() != info.name()) {
+            changes |= NameChanged;
+        }
 
-    if (d->info.visibleName() != info.visibleName() ||
-        d->info.visibleNameWithState() != info.visibleNameWithState() ||
-        d->info.name() != info.name()) {
-        changes |= NameChanged;
+        d->info = info;
     }
 
-    d->info = info;
-
     if (dirty.netWindowInfoProperties & NET::WMState || dirty.netWindowInfoProperties & NET::XAWMState) {
         changes |= StateChanged;
         if (demandsAttention() != d->demandedAttention) {
@@ -360,31 +345,17 @@ QString Task::name() const
 
 QPixmap Task::icon(int width, int height, bool allowResize)
 {
-    if (width == d->lastWidth &&
-            height == d->lastHeight &&
-            allowResize == d->lastResize &&
-            !d->lastIcon.isNull()) {
-        return d->lastIcon;
-    }
-
-    QPixmap newIcon = KWindowSystem::icon(d->win, width, height, allowResize);
-    if (!newIcon.isNull()) {
-        d->lastIcon = newIcon;
-        d->lastWidth = width;
-        d->lastHeight = height;
-        d->lastResize = allowResize;
-    }
-
-    return newIcon;
+    return IconCache::self()->icon(d->win, width, height, allowResize);
 }
 
 QIcon Task::icon()
 {
     if (d->icon.isNull()) {
-        d->icon.addPixmap(KWindowSystem::icon(d->win, KIconLoader::SizeSmall, KIconLoader::SizeSmall, false));
-        d->icon.addPixmap(KWindowSystem::icon(d->win, KIconLoader::SizeSmallMedium, KIconLoader::SizeSmallMedium, false));
-        d->icon.addPixmap(KWindowSystem::icon(d->win, KIconLoader::SizeMedium, KIconLoader::SizeMedium, false));
-        d->icon.addPixmap(KWindowSystem::icon(d->win, KIconLoader::SizeLarge, KIconLoader::SizeLarge, false));
+        IconCache *cache = IconCache::self();
+        d->icon.addPixmap(cache->icon(d->win, KIconLoader::SizeSmall, KIconLoader::SizeSmall, false));
+        d->icon.addPixmap(cache->icon(d->win, KIconLoader::SizeSmallMedium, KIconLoader::SizeSmallMedium, false));
+        d->icon.addPixmap(cache->icon(d->win, KIconLoader::SizeMedium, KIconLoader::SizeMedium, false));
+        d->icon.addPixmap(cache->icon(d->win, KIconLoader::SizeLarge, KIconLoader::SizeLarge, false));
     }
 
     return d->icon;
@@ -595,7 +566,6 @@ void Task::toggleShaded()
 
 void Task::clearPixmapData()
 {
-    d->lastIcon = QPixmap();
     d->pixmap = QPixmap();
     d->icon = QIcon();
 }
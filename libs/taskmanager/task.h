@@ -136,9 +136,8 @@ public:
      * is no icon that matches then it will either resize the closest available
      * icon or return a null pixmap depending on the value of allowResize.
      *
-     * Note that the last icon is cached, so a sequence of calls with the same
-     * parameters will only query the NET properties if the icon has changed or
-     * none was found.
+     * Note that the icons are cached by the IconCache, so the NET properties
+     * are only queried again if the icon has changed.
      */
     QPixmap icon(int width, int height, bool allowResize = false);
 
@@ -437,6 +436,7 @@ Q_SIGNALS:
 
 protected:
     void findWindowFrameId();
+    // kept for binary compatibility, the changes are no longer cached per task
     void timerEvent(QTimerEvent *event);
     //* @internal */
     void refreshIcon();
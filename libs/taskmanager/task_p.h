@@ -27,7 +27,6 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "task.h"
 
-#include <QTime>
 #include <NETWinInfo>
 
 namespace TaskManager
@@ -45,12 +44,7 @@ public:
         : win(w),
           frameId(w),
           info(KWindowSystem::windowInfo(w, windowInfoFlags, windowInfoFlags2)),
-          lastWidth(0),
-          lastHeight(0),
-          cachedChanges(0, 0),
-          cachedChangesTimerId(0),
           active(false),
-          lastResize(false),
           demandedAttention(false) {
     }
 
@@ -61,19 +55,12 @@ public:
     WindowList transientsDemandingAttention;
     QStringList activities;
 
-    int lastWidth;
-    int lastHeight;
     QIcon icon;
 
     QRect iconGeometry;
 
-    QTime lastUpdate;
-    Task::WindowProperties cachedChanges;
-    int cachedChangesTimerId;
     QPixmap pixmap;
-    QPixmap lastIcon;
     bool active : 1;
-    bool lastResize : 1;
     bool demandedAttention : 1;
 };
 }
@@ -23,6 +23,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 ******************************************************************/
 
 #include "task_p.h"
+#include "windowstatemirror.h"
 
 #include <QX11Info>
 
@@ -34,8 +35,7 @@ bool Task::updateDemandsAttentionState(WId w)
     const bool empty = d->transientsDemandingAttention.isEmpty();
     if (window() != w) {
         // 'w' is a transient for this task
-        NETWinInfo i(QX11Info::display(), w, QX11Info::appRootWindow(), NET::WMState);
-        if (i.state() & NET::DemandsAttention) {
+        if (WindowStateMirror::self()->state(w).state & NET::DemandsAttention) {
             if (!d->transientsDemandingAttention.contains(w)) {
                 d->transientsDemandingAttention.insert(w);
             }
@@ -58,31 +58,17 @@ void Task::addTransient(WId w, const KWindowInfo &info)
 
 QString Task::className() const
 {
-    XClassHint hint;
-    if (XGetClassHint(QX11Info::display(), d->win, &hint)) {
-        QString nh(hint.res_name);
-        XFree(hint.res_name);
-        XFree(hint.res_class);
-        return nh;
-    }
-    return QString();
+    return WindowStateMirror::self()->state(d->win).className;
 }
 
 QString Task::classClass() const
 {
-    XClassHint hint;
-    if (XGetClassHint(QX11Info::display(), d->win, &hint)) {
-        QString ch(hint.res_class);
-        XFree(hint.res_name);
-        XFree(hint.res_class);
-        return ch;
-    }
-    return QString();
+    return WindowStateMirror::self()->state(d->win).classClass;
 }
 
 int Task::pid() const
 {
-    return NETWinInfo(QX11Info::display(), d->win, QX11Info::appRootWindow(), NET::WMPid).pid();
+    return WindowStateMirror::self()->state(d->win).pid;
 }
 
 void Task::move()
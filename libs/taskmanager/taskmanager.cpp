@@ -42,6 +42,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #ifdef Q_WS_X11
 #include <QX11Info>
+#include "windowstatemirror.h"
 #endif
 
 #ifdef Q_WS_WIN
@@ -53,6 +54,9 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 namespace TaskManager
 {
 
+// window changes are collected for one frame before they are processed
+static const int s_changesInterval = 16;
+
 class TaskManagerSingleton
 {
 public:
@@ -74,6 +78,8 @@ public:
           active(0),
           startupInfo(0),
           watcher(0) {
+        pendingChangesTimer.setSingleShot(true);
+        pendingChangesTimer.setInterval(s_changesInterval);
     }
 
     void onAppExitCleanup() {
@@ -92,6 +98,21 @@ public:
         }
     }
 
+    void processPendingChanges();
+#ifdef Q_WS_X11
+    void processChanges(WId w, unsigned long properties, unsigned long properties2);
+#endif
+
+    struct PendingChanges {
+        PendingChanges()
+            : properties(0),
+              properties2(0) {
+        }
+
+        unsigned long properties;
+        unsigned long properties2;
+    };
+
     TaskManager *q;
     Task *active;
     KStartupInfo* startupInfo;
@@ -101,8 +122,76 @@ public:
     WindowList skiptaskbarWindows;
     QSet<QUuid> trackGeometryTokens;
     KActivities::Consumer activityConsumer;
+    QHash<WId, PendingChanges> pendingChanges;
+    QTimer pendingChangesTimer;
 };
 
+void TaskManager::Private::processPendingChanges()
+{
+#ifdef Q_WS_X11
+    const QHash<WId, PendingChanges> changes = pendingChanges;
+    pendingChanges.clear();
+
+    // fetch the dirty properties of all changed windows in one go
+    WindowStateMirror::self()->update(changes.keys());
+
+    QHash<WId, PendingChanges>::const_iterator end = changes.constEnd();
+    for (QHash<WId, PendingChanges>::const_iterator it = changes.constBegin(); it != end; ++it) {
+        processChanges(it.key(), it->properties, it->properties2);
+    }
+#endif
+}
+
+#ifdef Q_WS_X11
+void TaskManager::Private::processChanges(WId w, unsigned long properties, unsigned long properties2)
+{
+    if (properties & NET::WMState) {
+        const WindowStateMirror::WindowState &state = WindowStateMirror::self()->state(w);
+
+        if (state.state & NET::SkipTaskbar) {
+            q->windowRemoved(w);
+            skiptaskbarWindows.insert(w);
+            return;
+        } else {
+            skiptaskbarWindows.remove(w);
+            if (state.mappingState != NET::Withdrawn && !q->findTask(w)) {
+                // skipTaskBar state was removed and the window is still
+                // mapped, so add this window
+                q->windowAdded(w);
+            }
+        }
+    }
+
+    // check if any state we are interested in is marked dirty
+    if (!(properties & (NET::WMVisibleName | NET::WMName |
+                        NET::WMState | NET::WMIcon |
+                        NET::XAWMState | NET::WMDesktop) ||
+            (q->trackGeometry() && properties & NET::WMGeometry) ||
+            (properties2 & NET::WM2Activities))) {
+        return;
+    }
+
+    // find task
+    Task *t = q->findTask(w);
+    if (!t) {
+        return;
+    }
+
+    //kDebug() << "TaskManager::windowChanged " << w << " " << properties << properties2;
+
+    unsigned long propagatedChanges = 0;
+    if ((properties & NET::WMState) && t->updateDemandsAttentionState(w)) {
+        propagatedChanges = NET::WMState;
+    }
+
+    //kDebug() << "got changes, but will we refresh?" << properties << properties2;
+    if (properties || properties2) {
+        // only refresh this stuff if we have other changes besides icons
+        t->refresh(Task::WindowProperties(properties | propagatedChanges, properties2));
+    }
+}
+#endif
+
 TaskManager::TaskManager()
     : QObject(),
       d(new Private(this))
@@ -120,6 +209,8 @@ TaskManager::TaskManager()
             this,       SLOT(windowChanged(WId, const ulong*)));
     connect(&d->activityConsumer, SIGNAL(currentActivityChanged(QString)),
             this,       SIGNAL(activityChanged(QString)));
+    connect(&d->pendingChangesTimer, SIGNAL(timeout()),
+            this,       SLOT(processPendingChanges()));
     if (QCoreApplication::instance()) {
         connect(QCoreApplication::instance(), SIGNAL(aboutToQuit()), this, SLOT(onAppExitCleanup()));
     }
@@ -128,6 +219,9 @@ TaskManager::TaskManager()
 
     // register existing windows
     const QList<WId> windows = KWindowSystem::windows();
+#ifdef Q_WS_X11
+    WindowStateMirror::self()->update(windows);
+#endif
     QList<WId>::ConstIterator end(windows.end());
     for (QList<WId>::ConstIterator it = windows.begin(); it != end; ++it) {
         windowAdded(*it);
@@ -300,6 +394,10 @@ void TaskManager::windowAdded(WId w)
 void TaskManager::windowRemoved(WId w)
 {
     d->skiptaskbarWindows.remove(w);
+    d->pendingChanges.remove(w);
+#ifdef Q_WS_X11
+    WindowStateMirror::self()->remove(w);
+#endif
 
     // find task
     Task *t = findTask(w);
@@ -328,50 +426,15 @@ void TaskManager::windowRemoved(WId w)
 void TaskManager::windowChanged(WId w, const unsigned long *dirty)
 {
 #ifdef Q_WS_X11
-    if (dirty[NETWinInfo::PROTOCOLS] & NET::WMState) {
-        NETWinInfo info(QX11Info::display(), w, QX11Info::appRootWindow(),
-                        NET::WMState | NET::XAWMState);
-
-        if (info.state() & NET::SkipTaskbar) {
-            windowRemoved(w);
-            d->skiptaskbarWindows.insert(w);
-            return;
-        } else {
-            d->skiptaskbarWindows.remove(w);
-            if (info.mappingState() != NET::Withdrawn && !findTask(w)) {
-                // skipTaskBar state was removed and the window is still
-                // mapped, so add this window
-                windowAdded(w);
-            }
-        }
-    }
-
-    // check if any state we are interested in is marked dirty
-    if (!(dirty[NETWinInfo::PROTOCOLS] & (NET::WMVisibleName | NET::WMName |
-                                          NET::WMState | NET::WMIcon |
-                                          NET::XAWMState | NET::WMDesktop) ||
-            (trackGeometry() && dirty[NETWinInfo::PROTOCOLS] & NET::WMGeometry) ||
-            (dirty[NETWinInfo::PROTOCOLS2] & NET::WM2Activities))) {
-        return;
-    }
-
-    // find task
-    Task *t = findTask(w);
-    if (!t) {
-        return;
-    }
-
-    //kDebug() << "TaskManager::windowChanged " << w << " " << dirty[NETWinInfo::PROTOCOLS] << dirty[NETWinInfo::PROTOCOLS2];
-
-    unsigned long propagatedChanges = 0;
-    if ((dirty[NETWinInfo::PROTOCOLS] & NET::WMState) && t->updateDemandsAttentionState(w)) {
-        propagatedChanges = NET::WMState;
-    }
-
-    //kDebug() << "got changes, but will we refresh?" << dirty[NETWinInfo::PROTOCOLS] << dirty[NETWinInfo::PROTOCOLS2];
-    if (dirty[NETWinInfo::PROTOCOLS] || dirty[NETWinInfo::PROTOCOLS2]) {
-        // only refresh this stuff if we have other changes besides icons
-        t->refresh(Task::WindowProperties(dirty[NETWinInfo::PROTOCOLS] | propagatedChanges, dirty[NETWinInfo::PROTOCOLS2]));
+    WindowStateMirror::self()->invalidate(w, dirty[NETWinInfo::PROTOCOLS], dirty[NETWinInfo::PROTOCOLS2]);
+
+    // during window storms a window changes many times per frame, so the
+    // changes are merged and processed together once the frame is over
+    Private::PendingChanges &changes = d->pendingChanges[w];
+    changes.properties |= dirty[NETWinInfo::PROTOCOLS];
+    changes.properties2 |= dirty[NETWinInfo::PROTOCOLS2];
+    if (!d->pendingChangesTimer.isActive()) {
+        d->pendingChangesTimer.start();
     }
 #endif
 }
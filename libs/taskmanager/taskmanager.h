@@ -219,6 +219,7 @@ private:
     Private * const d;
 
     Q_PRIVATE_SLOT(d, void onAppExitCleanup())
+    Q_PRIVATE_SLOT(d, void processPendingChanges())
 };
 
 } // TaskManager namespace
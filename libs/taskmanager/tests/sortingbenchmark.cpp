@@ -0,0 +1,328 @@
+/*****************************************************************
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#include "sortingbenchmark.h"
+
+#include <qtest_kde.h>
+
+#include <QTime>
+#include <QVector>
+#include <QX11Info>
+
+#include <KWindowSystem>
+#include <netwm.h>
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include "groupmanager.h"
+#include "task.h"
+#include "taskgroup.h"
+#include "taskitem.h"
+#include "taskmanager.h"
+
+using namespace TaskManager;
+
+static const int s_taskCount = 300;
+static const int s_desktopCount = 4;
+// how long to wait for the X server and the TaskManager, in msec
+static const int s_timeout = 5000;
+
+static bool keyLessThan(const QString &left, const QString &right)
+{
+    return left < right;
+}
+
+static int initialDesktop(int index)
+{
+    return index % s_desktopCount + 1;
+}
+
+// lets the TaskManager and the GroupManager handle all pending X events
+static void processXEvents()
+{
+    XSync(QX11Info::display(), False);
+    QCoreApplication::processEvents();
+}
+
+void SortingBenchmark::initTestCase()
+{
+    m_rootInfo = 0;
+    m_supportWindow = 0;
+    m_groupManager = 0;
+
+    Display *display = QX11Info::display();
+    const QByteArray wmSelection = QString("WM_S%1").arg(QX11Info::appScreen()).toLatin1();
+    if (XGetSelectionOwner(display, XInternAtom(display, wmSelection.constData(), False)) != None) {
+        QSKIP("The benchmark needs an X server without a window manager", SkipAll);
+    }
+
+    // act as the window manager of the benchmark windows
+    m_supportWindow = XCreateSimpleWindow(display, QX11Info::appRootWindow(), -100, -100, 1, 1, 0, 0, 0);
+    unsigned long properties[5] = {
+        NET::Supported | NET::SupportingWMCheck | NET::ClientList | NET::ClientListStacking |
+        NET::NumberOfDesktops | NET::CurrentDesktop | NET::WMDesktop | NET::WMState | NET::WMWindowType,
+        NET::NormalMask,
+        0,
+        0,
+        0
+    };
+    m_rootInfo = new NETRootInfo(display, m_supportWindow, "SortingBenchmark", properties, 5,
+                                 QX11Info::appScreen());
+    m_rootInfo->setNumberOfDesktops(s_desktopCount);
+    m_rootInfo->setCurrentDesktop(1);
+
+    // a fixed seed keeps the runs comparable
+    qsrand(42);
+    for (int i = 0; i < s_taskCount; ++i) {
+        const WId window = XCreateSimpleWindow(display, QX11Info::appRootWindow(), 0, 0, 100, 100, 0, 0, 0);
+        // several windows of the same program share the class, which the tasks are sorted by
+        QByteArray program = QString("program%1").arg(qrand() % 80).toLatin1();
+        XClassHint classHint;
+        classHint.res_name = program.data();
+        classHint.res_class = program.data();
+        XSetClassHint(display, window, &classHint);
+
+        m_windows << window;
+        m_desktops << 0;
+        setWindowDesktop(i, initialDesktop(i));
+    }
+
+    const QVector<WId> clients = m_windows.toVector();
+    m_rootInfo->setClientList(clients.constData(), clients.count());
+    m_rootInfo->setClientListStacking(clients.constData(), clients.count());
+
+    QTime timer;
+    timer.start();
+    while (TaskManager::TaskManager::self()->tasks().count() < s_taskCount && timer.elapsed() < s_timeout) {
+        processXEvents();
+    }
+    QCOMPARE(TaskManager::TaskManager::self()->tasks().count(), s_taskCount);
+}
+
+void SortingBenchmark::cleanupTestCase()
+{
+    Display *display = QX11Info::display();
+    foreach (WId window, m_windows) {
+        XDestroyWindow(display, window);
+    }
+    m_windows.clear();
+    m_desktops.clear();
+
+    delete m_rootInfo;
+    m_rootInfo = 0;
+    if (m_supportWindow) {
+        XDestroyWindow(display, m_supportWindow);
+        m_supportWindow = 0;
+    }
+    XFlush(display);
+}
+
+void SortingBenchmark::init()
+{
+    for (int i = 0; i < m_windows.count(); ++i) {
+        if (m_desktops.at(i) != initialDesktop(i)) {
+            setWindowDesktop(i, initialDesktop(i));
+        }
+    }
+    showDesktop(1);
+}
+
+void SortingBenchmark::cleanup()
+{
+    delete m_groupManager;
+    m_groupManager = 0;
+}
+
+void SortingBenchmark::createGroupManager()
+{
+    QFETCH(int, strategy);
+    m_groupManager = new GroupManager(this);
+    m_groupManager->setGroupingStrategy(GroupManager::NoGrouping);
+    m_groupManager->setSortingStrategy(GroupManager::TaskSortingStrategy(strategy));
+    m_groupManager->setShowOnlyCurrentDesktop(true);
+    waitForReload();
+}
+
+void SortingBenchmark::setWindowDesktop(int index, int desktop)
+{
+    const WId window = m_windows.at(index);
+    m_desktops[index] = desktop;
+    NETWinInfo info(QX11Info::display(), window, QX11Info::appRootWindow(), NET::WMDesktop, NET::WindowManager);
+    info.setDesktop(desktop);
+
+    // the windows are only tasks once they are in the client list
+    Task *task = TaskManager::TaskManager::self()->findTask(window);
+    if (!task) {
+        return;
+    }
+
+    QTime timer;
+    timer.start();
+    while (task->desktop() != desktop && timer.elapsed() < s_timeout) {
+        processXEvents();
+    }
+    QCOMPARE(task->desktop(), desktop);
+}
+
+void SortingBenchmark::showDesktop(int desktop)
+{
+    // the GroupManager switches its root group when the TaskManager reports the new desktop
+    m_rootInfo->setCurrentDesktop(desktop);
+    QTime timer;
+    timer.start();
+    while (KWindowSystem::currentDesktop() != desktop && timer.elapsed() < s_timeout) {
+        processXEvents();
+    }
+    QCOMPARE(KWindowSystem::currentDesktop(), desktop);
+}
+
+void SortingBenchmark::waitForReload()
+{
+    // a change of the settings reloads the tasks from a timer
+    QSignalSpy spy(m_groupManager, SIGNAL(reload()));
+    QTime timer;
+    timer.start();
+    while (spy.isEmpty() && timer.elapsed() < s_timeout) {
+        processXEvents();
+    }
+    QVERIFY(!spy.isEmpty());
+}
+
+QStringList SortingBenchmark::sortKeys() const
+{
+    QFETCH(int, strategy);
+    QStringList keys;
+    foreach (AbstractGroupableItem *item, m_groupManager->rootGroup()->members()) {
+        const QString name = static_cast<TaskItem *>(item)->taskName().toLower();
+        if (strategy == GroupManager::DesktopSorting) {
+            // the tasks on all desktops have the desktop -1 and come first
+            keys << QString("%1 %2").arg(item->desktop() + 1, 2, 10, QChar('0')).arg(name);
+        } else {
+            keys << name;
+        }
+    }
+    return keys;
+}
+
+void SortingBenchmark::verifyMembers()
+{
+    const int desktop = KWindowSystem::currentDesktop();
+    QList<WId> expected;
+    for (int i = 0; i < m_windows.count(); ++i) {
+        if (m_desktops.at(i) == desktop || m_desktops.at(i) == NET::OnAllDesktops) {
+            expected << m_windows.at(i);
+        }
+    }
+
+    QList<WId> members;
+    foreach (AbstractGroupableItem *item, m_groupManager->rootGroup()->members()) {
+        QCOMPARE(item->itemType(), TaskItemType);
+        members << static_cast<TaskItem *>(item)->task()->window();
+    }
+
+    qSort(expected);
+    qSort(members);
+    QCOMPARE(members, expected);
+}
+
+void SortingBenchmark::verifyOrder()
+{
+    // equal keys may be in any order, so the keys are compared instead of the tasks
+    QStringList sorted = sortKeys();
+    qStableSort(sorted.begin(), sorted.end(), keyLessThan);
+    QCOMPARE(sortKeys(), sorted);
+}
+
+void SortingBenchmark::switchDesktop_data()
+{
+    QTest::addColumn<int>("strategy");
+
+    QTest::newRow("alpha") << int(GroupManager::AlphaSorting);
+    QTest::newRow("desktop") << int(GroupManager::DesktopSorting);
+}
+
+void SortingBenchmark::switchDesktop()
+{
+    createGroupManager();
+    verifyMembers();
+    verifyOrder();
+
+    QBENCHMARK {
+        showDesktop(2);
+        showDesktop(1);
+    }
+
+    verifyMembers();
+    verifyOrder();
+    showDesktop(2);
+    verifyMembers();
+    verifyOrder();
+}
+
+void SortingBenchmark::reloadAll_data()
+{
+    switchDesktop_data();
+}
+
+void SortingBenchmark::reloadAll()
+{
+    createGroupManager();
+
+    QBENCHMARK {
+        // a change of the filters adds all tasks again
+        m_groupManager->reconnect();
+        waitForReload();
+    }
+
+    verifyMembers();
+    verifyOrder();
+}
+
+void SortingBenchmark::revisitDesktop_data()
+{
+    switchDesktop_data();
+}
+
+void SortingBenchmark::revisitDesktop()
+{
+    createGroupManager();
+
+    // a task of desktop 3 is put on all desktops, which moves it in front
+    // of the others with the desktop sorting
+    setWindowDesktop(2, NET::OnAllDesktops);
+    verifyMembers();
+    verifyOrder();
+
+    // the root group of desktop 1 keeps its items while desktop 2 is shown,
+    // meanwhile the task moves to desktop 1 and a task of desktop 4 follows
+    showDesktop(2);
+    verifyMembers();
+    setWindowDesktop(2, 1);
+    setWindowDesktop(3, 1);
+    showDesktop(1);
+    verifyMembers();
+    verifyOrder();
+}
+
+QTEST_KDEMAIN(SortingBenchmark, GUI)
+
+#include "sortingbenchmark.moc"
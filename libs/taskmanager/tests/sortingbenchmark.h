@@ -0,0 +1,80 @@
+/*****************************************************************
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef SORTINGBENCHMARK_H
+#define SORTINGBENCHMARK_H
+
+#include <QtTest>
+#include <QList>
+#include <QStringList>
+
+#include <QtGui/qwindowdefs.h>
+
+class NETRootInfo;
+
+namespace TaskManager
+{
+class GroupManager;
+}
+
+/**
+ * Measures how a GroupManager keeps its root group in order when the shown
+ * tasks change, e.g. on a switch of the virtual desktop.
+ *
+ * The benchmark needs an X server without a window manager. It creates the
+ * windows itself and acts as the window manager for them, so that the
+ * TaskManager picks them up as tasks. After each run the members of the root
+ * group are compared with the windows on the current desktop and their order
+ * with a full sort.
+ */
+class SortingBenchmark : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void switchDesktop_data();
+    void switchDesktop();
+    void reloadAll_data();
+    void reloadAll();
+    void revisitDesktop_data();
+    void revisitDesktop();
+
+private:
+    void createGroupManager();
+    void setWindowDesktop(WId window, int desktop);
+    void showDesktop(int desktop);
+    void waitForReload();
+    QStringList sortKeys() const;
+    void verifyMembers();
+    void verifyOrder();
+
+    NETRootInfo *m_rootInfo;
+    WId m_supportWindow;
+    QList<WId> m_windows;
+    QList<int> m_desktops;
+    TaskManager::GroupManager *m_groupManager;
+};
+
+#endif
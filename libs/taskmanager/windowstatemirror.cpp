@@ -0,0 +1,282 @@
+/*****************************************************************
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+// Own
+#include "windowstatemirror.h"
+
+// Qt
+#include <QVector>
+#include <QX11Info>
+
+// KDE
+#include <KGlobal>
+
+// X11
+#include <X11/Xlib-xcb.h>
+
+#include <stdlib.h>
+
+namespace TaskManager
+{
+
+K_GLOBAL_STATIC(WindowStateMirror, privateWindowStateMirrorSelf)
+
+WindowStateMirror *WindowStateMirror::self()
+{
+    return privateWindowStateMirrorSelf;
+}
+
+WindowStateMirror::WindowState::WindowState()
+    : pid(0),
+      state(0),
+      mappingState(NET::Withdrawn),
+      dirty(AllProperties)
+{
+}
+
+static const struct {
+    const char *name;
+    unsigned long flag;
+} s_stateAtoms[] = {
+    { "_NET_WM_STATE_MODAL", NET::Modal },
+    { "_NET_WM_STATE_STICKY", NET::Sticky },
+    { "_NET_WM_STATE_MAXIMIZED_VERT", NET::MaxVert },
+    { "_NET_WM_STATE_MAXIMIZED_HORZ", NET::MaxHoriz },
+    { "_NET_WM_STATE_SHADED", NET::Shaded },
+    { "_NET_WM_STATE_SKIP_TASKBAR", NET::SkipTaskbar },
+    { "_NET_WM_STATE_SKIP_PAGER", NET::SkipPager },
+    { "_NET_WM_STATE_HIDDEN", NET::Hidden },
+    { "_NET_WM_STATE_FULLSCREEN", NET::FullScreen },
+    { "_NET_WM_STATE_ABOVE", NET::KeepAbove },
+    { "_NET_WM_STATE_BELOW", NET::KeepBelow },
+    { "_NET_WM_STATE_DEMANDS_ATTENTION", NET::DemandsAttention },
+    { "_KDE_NET_WM_STATE_STAYS_ON_TOP", NET::StaysOnTop }
+};
+static const int s_stateAtomCount = sizeof(s_stateAtoms) / sizeof(s_stateAtoms[0]);
+
+struct PropertyRequest {
+    WId window;
+    unsigned long properties;
+    // indexed by the bit of the property
+    xcb_get_property_cookie_t cookies[4];
+};
+
+static xcb_intern_atom_cookie_t internAtom(xcb_connection_t *c, const char *name)
+{
+    return xcb_intern_atom_unchecked(c, false, qstrlen(name), name);
+}
+
+static xcb_atom_t atomReply(xcb_connection_t *c, xcb_intern_atom_cookie_t cookie)
+{
+    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(c, cookie, 0);
+    if (!reply) {
+        return XCB_ATOM_NONE;
+    }
+
+    const xcb_atom_t atom = reply->atom;
+    free(reply);
+    return atom;
+}
+
+static quint32 cardinalValue(xcb_get_property_reply_t *reply, quint32 defaultValue)
+{
+    if (!reply || reply->type != XCB_ATOM_CARDINAL || reply->format != 32 ||
+        xcb_get_property_value_length(reply) < 4) {
+        return defaultValue;
+    }
+
+    return *reinterpret_cast<quint32 *>(xcb_get_property_value(reply));
+}
+
+WindowStateMirror::WindowStateMirror()
+    : m_connection(XGetXCBConnection(QX11Info::display()))
+{
+    // intern all atoms at once, only the replies are waited for
+    xcb_intern_atom_cookie_t stateCookies[s_stateAtomCount];
+    for (int i = 0; i < s_stateAtomCount; ++i) {
+        stateCookies[i] = internAtom(m_connection, s_stateAtoms[i].name);
+    }
+
+    const xcb_intern_atom_cookie_t pidCookie = internAtom(m_connection, "_NET_WM_PID");
+    const xcb_intern_atom_cookie_t stateCookie = internAtom(m_connection, "_NET_WM_STATE");
+    const xcb_intern_atom_cookie_t wmStateCookie = internAtom(m_connection, "WM_STATE");
+
+    for (int i = 0; i < s_stateAtomCount; ++i) {
+        const xcb_atom_t atom = atomReply(m_connection, stateCookies[i]);
+        if (atom != XCB_ATOM_NONE) {
+            m_stateFlags[atom] |= s_stateAtoms[i].flag;
+        }
+    }
+
+    m_pidAtom = atomReply(m_connection, pidCookie);
+    m_stateAtom = atomReply(m_connection, stateCookie);
+    m_wmStateAtom = atomReply(m_connection, wmStateCookie);
+}
+
+void WindowStateMirror::invalidate(WId window, unsigned long properties, unsigned long properties2)
+{
+    QHash<WId, WindowState>::iterator it = m_windows.find(window);
+    if (it == m_windows.end()) {
+        // windows which are not mirrored yet are fetched completely anyway
+        return;
+    }
+
+    if (properties2 & NET::WM2WindowClass) {
+        it->dirty |= ClassProperty;
+    }
+
+    if (properties & NET::WMPid) {
+        it->dirty |= PidProperty;
+    }
+
+    if (properties & NET::WMState) {
+        it->dirty |= StateProperty;
+    }
+
+    if (properties & NET::XAWMState) {
+        it->dirty |= MappingStateProperty;
+    }
+}
+
+void WindowStateMirror::update(const QList<WId> &windows)
+{
+    // send the requests for all windows first ...
+    QVector<PropertyRequest> requests;
+    requests.reserve(windows.count());
+    foreach (WId window, windows) {
+        WindowState &state = m_windows[window];
+        if (!state.dirty) {
+            continue;
+        }
+
+        PropertyRequest request;
+        request.window = window;
+        request.properties = state.dirty;
+        if (request.properties & ClassProperty) {
+            request.cookies[0] = xcb_get_property_unchecked(m_connection, false, window,
+                                                            XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 0, 2048);
+        }
+        if (request.properties & PidProperty) {
+            request.cookies[1] = xcb_get_property_unchecked(m_connection, false, window,
+                                                            m_pidAtom, XCB_ATOM_CARDINAL, 0, 1);
+        }
+        if (request.properties & StateProperty) {
+            request.cookies[2] = xcb_get_property_unchecked(m_connection, false, window,
+                                                            m_stateAtom, XCB_ATOM_ATOM, 0, 2048);
+        }
+        if (request.properties & MappingStateProperty) {
+            request.cookies[3] = xcb_get_property_unchecked(m_connection, false, window,
+                                                            m_wmStateAtom, m_wmStateAtom, 0, 2);
+        }
+        requests.append(request);
+    }
+
+    // ... and only then wait for the replies
+    foreach (const PropertyRequest &request, requests) {
+        WindowState &state = m_windows[request.window];
+        xcb_get_property_reply_t *replies[PropertyCount];
+        for (int i = 0; i < PropertyCount; ++i) {
+            replies[i] = (request.properties & (1 << i))
+                         ? xcb_get_property_reply(m_connection, request.cookies[i], 0) : 0;
+        }
+
+        if (request.properties & ClassProperty) {
+            readClass(state, replies[0]);
+        }
+        if (request.properties & PidProperty) {
+            state.pid = cardinalValue(replies[1], 0);
+        }
+        if (request.properties & StateProperty) {
+            readState(state, replies[2]);
+        }
+        if (request.properties & MappingStateProperty) {
+            state.mappingState = NET::Withdrawn;
+            if (replies[3] && replies[3]->type == m_wmStateAtom && replies[3]->format == 32 &&
+                xcb_get_property_value_length(replies[3]) >= 4) {
+                switch (*reinterpret_cast<quint32 *>(xcb_get_property_value(replies[3]))) {
+                case 1: // NormalState
+                    state.mappingState = NET::Visible;
+                    break;
+                case 3: // IconicState
+                    state.mappingState = NET::Iconic;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        for (int i = 0; i < PropertyCount; ++i) {
+            free(replies[i]);
+        }
+        state.dirty &= ~request.properties;
+    }
+}
+
+const WindowStateMirror::WindowState &WindowStateMirror::state(WId window)
+{
+    WindowState &state = m_windows[window];
+    if (state.dirty) {
+        update(QList<WId>() << window);
+    }
+
+    return state;
+}
+
+void WindowStateMirror::remove(WId window)
+{
+    m_windows.remove(window);
+}
+
+void WindowStateMirror::readClass(WindowState &state, xcb_get_property_reply_t *reply) const
+{
+    state.className.clear();
+    state.classClass.clear();
+    if (!reply || reply->type != XCB_ATOM_STRING || reply->format != 8) {
+        return;
+    }
+
+    // WM_CLASS holds two consecutive null terminated strings, name and class
+    const char *data = reinterpret_cast<const char *>(xcb_get_property_value(reply));
+    const int length = xcb_get_property_value_length(reply);
+    const int nameLength = qstrnlen(data, length);
+    state.className = QString::fromAscii(data, nameLength);
+    if (nameLength + 1 < length) {
+        state.classClass = QString::fromAscii(data + nameLength + 1,
+                                              qstrnlen(data + nameLength + 1, length - nameLength - 1));
+    }
+}
+
+void WindowStateMirror::readState(WindowState &state, xcb_get_property_reply_t *reply) const
+{
+    state.state = 0;
+    if (!reply || reply->type != XCB_ATOM_ATOM || reply->format != 32) {
+        return;
+    }
+
+    const xcb_atom_t *atoms = reinterpret_cast<const xcb_atom_t *>(xcb_get_property_value(reply));
+    const int count = xcb_get_property_value_length(reply) / sizeof(xcb_atom_t);
+    for (int i = 0; i < count; ++i) {
+        state.state |= m_stateFlags.value(atoms[i], 0);
+    }
+}
+
+} // TaskManager namespace
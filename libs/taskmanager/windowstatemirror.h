@@ -0,0 +1,105 @@
+/*****************************************************************
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN
+AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+******************************************************************/
+
+#ifndef WINDOWSTATEMIRROR_H
+#define WINDOWSTATEMIRROR_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include <NETWinInfo>
+
+#include <xcb/xcb.h>
+
+namespace TaskManager
+{
+
+/**
+ * Caches the window properties which are queried most often by the task
+ * manager: the class hint, the pid, the state and the mapping state.
+ *
+ * Properties are only fetched again after they have been invalidated, and
+ * all invalidated properties of a set of windows are requested at once,
+ * so that updating them costs a single round trip.
+ *
+ * @internal
+ */
+class WindowStateMirror
+{
+public:
+    struct WindowState {
+        WindowState();
+
+        QString className;
+        QString classClass;
+        int pid;
+        unsigned long state;
+        NET::MappingState mappingState;
+        // the properties which have to be fetched before the state can be used
+        unsigned long dirty;
+    };
+
+    WindowStateMirror();
+
+    static WindowStateMirror *self();
+
+    /**
+     * Marks the properties of @p window given as NET::Property and
+     * NET::Property2 flags to be fetched again.
+     */
+    void invalidate(WId window, unsigned long properties, unsigned long properties2);
+    /**
+     * Fetches the invalidated properties of all @p windows.
+     */
+    void update(const QList<WId> &windows);
+    /**
+     * @returns the cached state of @p window, fetching it first if required.
+     */
+    const WindowState &state(WId window);
+    void remove(WId window);
+
+private:
+    enum Property {
+        ClassProperty = 1 << 0,
+        PidProperty = 1 << 1,
+        StateProperty = 1 << 2,
+        MappingStateProperty = 1 << 3,
+        AllProperties = (1 << 4) - 1
+    };
+    enum {
+        PropertyCount = 4
+    };
+
+    void readClass(WindowState &state, xcb_get_property_reply_t *reply) const;
+    void readState(WindowState &state, xcb_get_property_reply_t *reply) const;
+
+    xcb_connection_t *m_connection;
+    xcb_atom_t m_pidAtom;
+    xcb_atom_t m_stateAtom;
+    xcb_atom_t m_wmStateAtom;
+    QHash<xcb_atom_t, unsigned long> m_stateFlags;
+    QHash<WId, WindowState> m_windows;
+};
+
+} // TaskManager namespace
+
+#endif
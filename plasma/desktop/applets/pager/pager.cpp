@@ -50,6 +50,7 @@
 
 #include <KActivities/Consumer>
 
+#include <taskmanager/iconcache.h>
 #include <taskmanager/task.h>
 
 const int FAST_UPDATE_DELAY = 100;
@@ -607,7 +608,7 @@ void Pager::recalculateWindowRects()
             int windowIconSize = KIconLoader::global()->currentSize(KIconLoader::Small);
             int windowRectSize = qMin(windowRect.width(), windowRect.height());
             windowIconSize = qMax(windowIconSize, windowRectSize / 2);
-            QPixmap icon = KWindowSystem::icon(info.win(), windowIconSize, windowIconSize, true);
+            QPixmap icon = TaskManager::IconCache::self()->icon(info.win(), windowIconSize, windowIconSize, true);
             m_pagerModel->appendWindowRect(i, window, windowRect, active, icon, info.visibleName());
         }
     }
@@ -850,7 +851,7 @@ void Pager::updateToolTip(int hoverDesktopId)
             // prefer to use the System Settings specified Small icon (usually 16x16)
             // TODO: should we actually be using Small for this? or Panel, Toolbar, etc?
             int iconSize = KIconLoader::global()->currentSize(KIconLoader::Small);
-            QPixmap icon = KWindowSystem::icon(id, iconSize, iconSize, true);
+            QPixmap icon = TaskManager::IconCache::self()->icon(id, iconSize, iconSize, true);
             if (icon.isNull()) {
                  subtext += "<br />&bull;" + Qt::escape(visibleName);
             } else {
@@ -31,6 +31,7 @@
 #include <Plasma/IconWidget>
 #include <Plasma/ToolTipManager>
 
+#include <taskmanager/iconcache.h>
 #include <taskmanager/taskitem.h>
 #include <taskmanager/taskactions.h>
 #include <taskmanager/taskmanager.h>
@@ -220,7 +221,7 @@ void WindowList::showMenu(bool onlyCurrentDesktop)
 
         ++amount;
 
-        QAction *action = new QAction(QIcon(KWindowSystem::icon(windows.at(i))), window.visibleName(), this);
+        QAction *action = new QAction(QIcon(TaskManager::IconCache::self()->icon(windows.at(i))), window.visibleName(), this);
         action->setData((unsigned long long) windows.at(i));
 
         QString window_title = QString(action->text());
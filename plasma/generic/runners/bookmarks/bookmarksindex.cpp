@@ -0,0 +1,172 @@
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "bookmarksindex.h"
+#include <QDataStream>
+#include <QFile>
+#include <KDebug>
+#include <KSaveFile>
+#include "bookmarksrunner_defs.h"
+
+// increase whenever the layout of the stored index changes
+static const quint32 s_indexVersion = 1;
+
+QDataStream &operator<<(QDataStream &stream, const BookmarksIndex::Bookmark &bookmark)
+{
+    return stream << bookmark.title << bookmark.url << bookmark.description;
+}
+
+QDataStream &operator>>(QDataStream &stream, BookmarksIndex::Bookmark &bookmark)
+{
+    return stream >> bookmark.title >> bookmark.url >> bookmark.description;
+}
+
+static QString foldField(const QString &field)
+{
+    // blank fields never match
+    return field.simplified().isEmpty() ? QString() : field.toCaseFolded();
+}
+
+BookmarksIndex::BookmarksIndex(const QString &fileName)
+    : m_fileName(fileName), m_changed(false)
+{
+    load();
+}
+
+BookmarksIndex::~BookmarksIndex()
+{
+}
+
+bool BookmarksIndex::isOutdated(const QString &source, const QDateTime &modified) const
+{
+    QHash<QString, Source>::const_iterator it = m_sources.constFind(source);
+    return it == m_sources.constEnd() || it->modified != modified;
+}
+
+void BookmarksIndex::update(const QString &source, const QDateTime &modified, const QList<Bookmark> &bookmarks)
+{
+    Source &entry = m_sources[source];
+    entry.modified = modified;
+    entry.bookmarks = bookmarks;
+    fold(entry);
+    m_changed = true;
+}
+
+void BookmarksIndex::remove(const QString &source)
+{
+    if (m_sources.remove(source)) {
+        m_changed = true;
+    }
+}
+
+void BookmarksIndex::match(const QString &source, const QString &term, bool addEverything,
+                           Favicon *favicon, QList<BookmarkMatch> &results) const
+{
+    QHash<QString, Source>::const_iterator it = m_sources.constFind(source);
+    if (it == m_sources.constEnd()) {
+        return;
+    }
+
+    // the same rule as BookmarkMatch::addTo, but on the folded fields
+    const QString foldedTerm = term.toCaseFolded();
+    const QList<QString> &folded = it->foldedFields;
+    for (int i = 0; i < it->bookmarks.count(); ++i) {
+        if (!addEverything) {
+            const QString &title = folded.at(3 * i);
+            const QString &url = folded.at(3 * i + 1);
+            const QString &description = folded.at(3 * i + 2);
+            if (!(!title.isEmpty() && title.contains(foldedTerm)) &&
+                !(!description.isEmpty() && description.contains(foldedTerm)) &&
+                !(!url.isEmpty() && url.contains(foldedTerm))) {
+                continue;
+            }
+        }
+
+        const Bookmark &bookmark = it->bookmarks.at(i);
+        results << BookmarkMatch(favicon, term, bookmark.title, bookmark.url, bookmark.description);
+    }
+}
+
+void BookmarksIndex::save()
+{
+    if (!m_changed || m_fileName.isEmpty()) {
+        return;
+    }
+
+    KSaveFile file(m_fileName);
+    if (!file.open()) {
+        kDebug(kdbg_code) << "Could not write the bookmarks index" << m_fileName << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << s_indexVersion << quint32(m_sources.count());
+    QHash<QString, Source>::const_iterator it = m_sources.constBegin();
+    for (; it != m_sources.constEnd(); ++it) {
+        stream << it.key() << it->modified << it->bookmarks;
+    }
+
+    if (file.finalize()) {
+        m_changed = false;
+    }
+}
+
+void BookmarksIndex::load()
+{
+    if (m_fileName.isEmpty()) {
+        return;
+    }
+
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    QDataStream stream(&file);
+    quint32 version;
+    quint32 count;
+    stream >> version >> count;
+    if (version != s_indexVersion) {
+        kDebug(kdbg_code) << "Ignoring the bookmarks index of version" << version;
+        return;
+    }
+
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString path;
+        Source source;
+        stream >> path >> source.modified >> source.bookmarks;
+        fold(source);
+        m_sources.insert(path, source);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        // everything is read again from the browsers
+        kDebug(kdbg_code) << "The bookmarks index" << m_fileName << "is corrupt";
+        m_sources.clear();
+    }
+}
+
+void BookmarksIndex::fold(Source &source)
+{
+    source.foldedFields.clear();
+    source.foldedFields.reserve(3 * source.bookmarks.count());
+    foreach (const Bookmark &bookmark, source.bookmarks) {
+        source.foldedFields << foldField(bookmark.title)
+                            << foldField(bookmark.url)
+                            << foldField(bookmark.description);
+    }
+}
@@ -0,0 +1,88 @@
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License as
+ *   published by the Free Software Foundation; either version 2, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef BOOKMARKSINDEX_H
+#define BOOKMARKSINDEX_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include "bookmarkmatch.h"
+
+class Favicon;
+
+/**
+ * Keeps the bookmarks read from the files of all browsers and profiles, so
+ * that a source only has to be parsed again after it has been modified.
+ *
+ * A source is identified by the path of the file the bookmarks are read
+ * from. The index is stored in @p fileName between sessions, an index
+ * without a file name only lives in memory.
+ */
+class BookmarksIndex
+{
+public:
+    struct Bookmark {
+        QString title;
+        QString url;
+        QString description;
+    };
+
+    explicit BookmarksIndex(const QString &fileName = QString());
+    ~BookmarksIndex();
+
+    /**
+     * @returns true if @p source has not been read yet or was read before
+     * it has been @p modified last.
+     */
+    bool isOutdated(const QString &source, const QDateTime &modified) const;
+    /**
+     * Replaces the bookmarks of @p source by @p bookmarks read at @p modified.
+     */
+    void update(const QString &source, const QDateTime &modified, const QList<Bookmark> &bookmarks);
+    void remove(const QString &source);
+
+    /**
+     * Adds the bookmarks of @p source matching @p term to @p results, or all
+     * of them if @p addEverything is set.
+     */
+    void match(const QString &source, const QString &term, bool addEverything,
+               Favicon *favicon, QList<BookmarkMatch> &results) const;
+
+    /**
+     * Writes the index to its file if it has been changed.
+     */
+    void save();
+
+private:
+    struct Source {
+        QDateTime modified;
+        QList<Bookmark> bookmarks;
+        // case folded title, url and description of each bookmark, empty if blank
+        QList<QString> foldedFields;
+    };
+
+    void load();
+    static void fold(Source &source);
+
+    QString const m_fileName;
+    QHash<QString, Source> m_sources;
+    bool m_changed;
+};
+
+#endif // BOOKMARKSINDEX_H
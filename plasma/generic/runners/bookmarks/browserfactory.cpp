@@ -20,11 +20,13 @@
 
 #include "browserfactory.h"
 #include "browser.h"
+#include "bookmarksindex.h"
 #include "browsers/kdebrowser.h"
 #include "browsers/firefox.h"
 #include "browsers/opera.h"
 #include "browsers/chromefindprofile.h"
 #include "browsers/chrome.h"
+#include <KStandardDirs>
 
 Browser *BrowserFactory::find(const QString& browserName, QObject* parent)
 {
@@ -34,14 +36,14 @@ Browser *BrowserFactory::find(const QString& browserName, QObject* parent)
     delete m_previousBrowser;
     m_previousBrowserName = browserName;
     if (browserName.contains("firefox", Qt::CaseInsensitive)) {
-        m_previousBrowser = new Firefox(parent);
+        m_previousBrowser = new Firefox(parent, m_index);
     } else if (browserName.contains("opera", Qt::CaseInsensitive)) {
-        m_previousBrowser = new Opera(parent);
+        m_previousBrowser = new Opera(parent, m_index);
 #ifdef HAVE_QJSON
     } else if (browserName.contains("chrome", Qt::CaseInsensitive)) {
-        m_previousBrowser = new Chrome(new FindChromeProfile("google-chrome", QDir::homePath(), parent), parent);
+        m_previousBrowser = new Chrome(new FindChromeProfile("google-chrome", QDir::homePath(), parent), parent, m_index);
     } else if (browserName.contains("chromium", Qt::CaseInsensitive)) {
-        m_previousBrowser = new Chrome(new FindChromeProfile("chromium", QDir::homePath(), parent), parent);
+        m_previousBrowser = new Chrome(new FindChromeProfile("chromium", QDir::homePath(), parent), parent, m_index);
 #endif // HAVE_QJSON
     } else {
         m_previousBrowser = new KDEBrowser(parent);
@@ -52,7 +54,13 @@ Browser *BrowserFactory::find(const QString& browserName, QObject* parent)
 
 
 BrowserFactory::BrowserFactory(QObject *parent)
-    : QObject(parent), m_previousBrowser(0), m_previousBrowserName("invalid")
+    : QObject(parent), m_previousBrowser(0), m_previousBrowserName("invalid"),
+      m_index(new BookmarksIndex(KStandardDirs::locateLocal("cache", "krunner-bookmarks-index")))
 {
 }
 
+BrowserFactory::~BrowserFactory()
+{
+    delete m_index;
+}
+
@@ -24,15 +24,19 @@
 #include <QString>
 
 class Browser;
+class BookmarksIndex;
 class BrowserFactory : public QObject
 {
     Q_OBJECT
 public:
     BrowserFactory(QObject *parent =0);
+    ~BrowserFactory();
     Browser *find(const QString &browserName, QObject *parent = 0);
 private:
   Browser *m_previousBrowser;
   QString m_previousBrowserName;
+  // shared by all browsers and kept between sessions
+  BookmarksIndex * const m_index;
 };
 
 #endif // BROWSERFACTORY_H
@@ -31,18 +31,18 @@
 
 class ProfileBookmarks {
 public:
-    ProfileBookmarks(Profile &profile) : m_profile(profile) {}
-    inline QList<QVariantMap> bookmarks() { return m_bookmarks; }
+    ProfileBookmarks(Profile &profile) : m_profile(profile), m_prepared(false) {}
     inline Profile profile() { return m_profile; }
-    void tearDown() { m_profile.favicon()->teardown(); m_bookmarks.clear(); }
-    void add(QVariantMap &bookmarkEntry) { m_bookmarks << bookmarkEntry; }
+    inline bool isPrepared() const { return m_prepared; }
+    void setPrepared() { m_prepared = true; }
+    void tearDown() { m_profile.favicon()->teardown(); m_prepared = false; }
 private:
     Profile m_profile;
-    QList<QVariantMap> m_bookmarks;
+    bool m_prepared;
 };
 
-Chrome::Chrome( FindProfile* findProfile, QObject* parent )
-    : QObject(parent)
+Chrome::Chrome( FindProfile* findProfile, QObject* parent, BookmarksIndex *index )
+    : QObject(parent), m_index(index ? index : new BookmarksIndex), m_ownsIndex(!index)
 {
     foreach(Profile profile, findProfile->find()) {
         m_profileBookmarks << new ProfileBookmarks(profile);
@@ -54,6 +54,9 @@ Chrome::~Chrome()
     foreach(ProfileBookmarks *profileBookmark, m_profileBookmarks) {
         delete profileBookmark;
     }
+    if (m_ownsIndex) {
+        delete m_index;
+    }
 }
 
 QList<BookmarkMatch> Chrome::match(const QString &term, bool addEveryThing)
@@ -68,11 +71,9 @@ QList<BookmarkMatch> Chrome::match(const QString &term, bool addEveryThing)
 QList<BookmarkMatch> Chrome::match(const QString &term, bool addEveryThing, ProfileBookmarks *profileBookmarks)
 {
     QList<BookmarkMatch> results;
-    foreach(QVariantMap bookmark, profileBookmarks->bookmarks()) {
-        QString url = bookmark.value("url").toString();
-
-        BookmarkMatch bookmarkMatch(profileBookmarks->profile().favicon(), term, bookmark.value("name").toString(), url);
-        bookmarkMatch.addTo(results, addEveryThing);
+    if (profileBookmarks->isPrepared()) {
+        Profile profile = profileBookmarks->profile();
+        m_index->match(profile.path(), term, addEveryThing, profile.favicon(), results);
     }
     return results;
 }
@@ -83,17 +84,26 @@ void Chrome::prepare()
     bool ok;
     foreach(ProfileBookmarks *profileBookmarks, m_profileBookmarks) {
         Profile profile = profileBookmarks->profile();
-        QFile bookmarksFile(profile.path());
-        QVariant result = parser.parse(&bookmarksFile, &ok);
-        if(!ok || !result.toMap().contains("roots")) {
-            return;
-        }
-        QVariantMap entries = result.toMap().value("roots").toMap();
-        foreach(QVariant folder, entries.values()) {
-            parseFolder(folder.toMap(), profileBookmarks);
+        // the profile is only parsed again after it has been changed
+        const QDateTime modified = QFileInfo(profile.path()).lastModified();
+        if (m_index->isOutdated(profile.path(), modified)) {
+            QFile bookmarksFile(profile.path());
+            QVariant result = parser.parse(&bookmarksFile, &ok);
+            if(!ok || !result.toMap().contains("roots")) {
+                m_index->remove(profile.path());
+                continue;
+            }
+            QList<BookmarksIndex::Bookmark> bookmarks;
+            QVariantMap entries = result.toMap().value("roots").toMap();
+            foreach(QVariant folder, entries.values()) {
+                parseFolder(folder.toMap(), bookmarks);
+            }
+            m_index->update(profile.path(), modified, bookmarks);
         }
+        profileBookmarks->setPrepared();
         profile.favicon()->prepare();
     }
+    m_index->save();
 }
 
 void Chrome::teardown()
@@ -103,15 +113,18 @@ void Chrome::teardown()
     }
 }
 
-void Chrome::parseFolder(const QVariantMap &entry, ProfileBookmarks *profile)
+void Chrome::parseFolder(const QVariantMap &entry, QList<BookmarksIndex::Bookmark> &bookmarks)
 {
     QVariantList children = entry.value("children").toList();
     foreach(QVariant child, children) {
         QVariantMap entry = child.toMap();
         if(entry.value("type").toString() == "folder")
-            parseFolder(entry, profile);
+            parseFolder(entry, bookmarks);
         else {
-            profile->add(entry);
+            BookmarksIndex::Bookmark bookmark;
+            bookmark.title = entry.value("name").toString();
+            bookmark.url = entry.value("url").toString();
+            bookmarks << bookmark;
         }
     }
 }
@@ -23,6 +23,7 @@
 #define CHROME_H
 
 #include "browser.h"
+#include "bookmarksindex.h"
 #include "findprofile.h"
 #include <QMap>
 #include <QList>
@@ -34,16 +35,22 @@ class Chrome : public QObject, public Browser
 {
   Q_OBJECT
 public:
-    Chrome(FindProfile *findProfile, QObject* parent = 0);
+    /**
+      * @param index keeps the bookmarks of the profiles between sessions,
+      * if none is given they are only kept until the browser is deleted
+      */
+    Chrome(FindProfile *findProfile, QObject* parent = 0, BookmarksIndex *index = 0);
     ~Chrome();
     virtual QList<BookmarkMatch> match(const QString &term, bool addEveryThing);
 public slots:
     virtual void prepare();
     virtual void teardown();
 private:
-    void parseFolder(const QVariantMap &entry, ProfileBookmarks *profile);
+    void parseFolder(const QVariantMap &entry, QList<BookmarksIndex::Bookmark> &bookmarks);
     virtual QList<BookmarkMatch> match(const QString &term, bool addEveryThing, ProfileBookmarks *profileBookmarks);
     QList<ProfileBookmarks*> m_profileBookmarks;
+    BookmarksIndex *m_index;
+    bool const m_ownsIndex;
 };
 
 #endif // CHROME_H
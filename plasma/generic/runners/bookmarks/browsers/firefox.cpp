@@ -24,6 +24,7 @@
 #include <KDebug>
 #include "bookmarksrunner_defs.h"
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
 #include <KConfigGroup>
 #include <KSharedConfig>
@@ -32,10 +33,12 @@
 #include "fetchsqlite.h"
 #include "faviconfromblob.h"
 
-Firefox::Firefox(QObject *parent) :
+Firefox::Firefox(QObject *parent, BookmarksIndex *index) :
     QObject(parent),
     m_favicon(new FallbackFavicon(this)),
-    m_fetchsqlite(0)
+    m_fetchsqlite(0),
+    m_index(index ? index : new BookmarksIndex),
+    m_ownsIndex(!index)
 {
   reloadConfiguration();
   kDebug(kdbg_code) << "Loading Firefox Bookmarks Browser";
@@ -50,6 +53,9 @@ Firefox::~Firefox()
             kDebug(kdbg_code) << "Cache file was removed: " << db_CacheFile.remove();
         }
     }
+    if (m_ownsIndex) {
+        delete m_index;
+    }
     kDebug(kdbg_code) << "Deleted Firefox Bookmarks Browser";
 }
 
@@ -66,34 +72,29 @@ void Firefox::prepare()
         m_favicon = 0;
 
         m_favicon = FaviconFromBlob::firefox(m_fetchsqlite, this);
+
+        updateIndex();
     }
 }
 
-QList< BookmarkMatch > Firefox::match(const QString& term, bool addEverything)
+void Firefox::updateIndex()
 {
-    QList< BookmarkMatch > matches;
-    if (!m_fetchsqlite) {
-        return matches;
+    // Firefox writes to the write-ahead log first, it is merged into the database later
+    QDateTime modified = QFileInfo(m_dbFile).lastModified();
+    const QDateTime walModified = QFileInfo(m_dbFile + "-wal").lastModified();
+    if (walModified.isValid() && walModified > modified) {
+        modified = walModified;
     }
-    kDebug(kdbg_code) << "Firefox bookmark: match " << term;
 
-    QString tmpTerm = term;
-    QString query;
-    if (addEverything) {
-        query = QString("SELECT moz_bookmarks.fk, moz_bookmarks.title, moz_places.url," \
-                    "moz_places.favicon_id FROM moz_bookmarks, moz_places WHERE " \
-                    "moz_bookmarks.type = 1 AND moz_bookmarks.fk = moz_places.id");
-    } else {
-        const QString escapedTerm = tmpTerm.replace('\'', "\\'");
-        query = QString("SELECT moz_bookmarks.fk, moz_bookmarks.title, moz_places.url," \
-                        "moz_places.favicon_id FROM moz_bookmarks, moz_places WHERE " \
-                        "moz_bookmarks.type = 1 AND moz_bookmarks.fk = moz_places.id AND " \
-                        "(moz_bookmarks.title LIKE  '%" + escapedTerm + "%' or moz_places.url LIKE '%"
-                        + escapedTerm + "%')");
+    if (!m_index->isOutdated(m_dbFile, modified)) {
+        return;
     }
-    QList<QVariantMap> results = m_fetchsqlite->query(query, QMap<QString, QVariant>());
-    foreach(QVariantMap result, results) {
-        const QString title = result.value("title").toString();
+
+    const QString query("SELECT moz_bookmarks.fk, moz_bookmarks.title, moz_places.url," \
+                        "moz_places.favicon_id FROM moz_bookmarks, moz_places WHERE " \
+                        "moz_bookmarks.type = 1 AND moz_bookmarks.fk = moz_places.id");
+    QList<BookmarksIndex::Bookmark> bookmarks;
+    foreach(QVariantMap result, m_fetchsqlite->query(query, QMap<QString, QVariant>())) {
         const QUrl url = result.value("url").toUrl();
         if (url.scheme().contains("place")) {
             //Don't use bookmarks with empty title, url or Firefox intern url
@@ -101,10 +102,25 @@ QList< BookmarkMatch > Firefox::match(const QString& term, bool addEverything)
             continue;
         }
 
-        BookmarkMatch bookmarkMatch( m_favicon, term, title, url.toString());
-        bookmarkMatch.addTo(matches, addEverything);
+        BookmarksIndex::Bookmark bookmark;
+        bookmark.title = result.value("title").toString();
+        bookmark.url = url.toString();
+        bookmarks << bookmark;
     }
 
+    m_index->update(m_dbFile, modified, bookmarks);
+    m_index->save();
+}
+
+QList< BookmarkMatch > Firefox::match(const QString& term, bool addEverything)
+{
+    QList< BookmarkMatch > matches;
+    if (!m_fetchsqlite) {
+        return matches;
+    }
+    kDebug(kdbg_code) << "Firefox bookmark: match " << term;
+
+    m_index->match(m_dbFile, term, addEverything, m_favicon, matches);
     return matches;
 }
 
@@ -23,6 +23,7 @@
 
 #include <QSqlDatabase>
 #include "browser.h"
+#include "bookmarksindex.h"
 
 class KJob;
 class Favicon;
@@ -31,7 +32,7 @@ class Firefox : public QObject, public Browser
 {
     Q_OBJECT
 public:
-    explicit Firefox(QObject *parent = 0);
+    explicit Firefox(QObject *parent = 0, BookmarksIndex *index = 0);
     virtual ~Firefox();
     virtual QList<BookmarkMatch> match(const QString& term, bool addEverything);
 public slots:
@@ -39,10 +40,13 @@ public slots:
     virtual void prepare();
 private:
     virtual void reloadConfiguration();
+    void updateIndex();
     QString m_dbFile;
     QString m_dbCacheFile;
     Favicon * m_favicon;
     FetchSqlite *m_fetchsqlite;
+    BookmarksIndex *m_index;
+    bool const m_ownsIndex;
 };
 
 #endif // FIREFOX_H
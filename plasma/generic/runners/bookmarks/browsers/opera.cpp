@@ -23,46 +23,33 @@
 #include "bookmarksrunner_defs.h"
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QStringList>
 #include "favicon.h"
 
 
-Opera::Opera(QObject* parent): QObject(parent), m_favicon(new FallbackFavicon(this))
+Opera::Opera(QObject* parent, BookmarksIndex *index)
+    : QObject(parent),
+      m_operaBookmarksFilePath(QDir::homePath() + "/.opera/bookmarks.adr"),
+      m_favicon(new FallbackFavicon(this)),
+      m_index(index ? index : new BookmarksIndex),
+      m_ownsIndex(!index),
+      m_prepared(false)
 {
 }
 
+Opera::~Opera()
+{
+    if (m_ownsIndex) {
+        delete m_index;
+    }
+}
+
 QList<BookmarkMatch> Opera::match( const QString& term, bool addEverything )
 {
     QList<BookmarkMatch> matches;
-
-    QLatin1String nameStart("\tNAME=");
-    QLatin1String urlStart("\tURL=");
-    QLatin1String descriptionStart("\tDESCRIPTION=");
-
-    // search
-    foreach (const QString & entry, m_operaBookmarkEntries) {
-        QStringList entryLines = entry.split("\n");
-        if (!entryLines.first().startsWith(QString("#URL"))) {
-            continue; // skip folder entries
-        }
-        entryLines.pop_front();
-
-        QString name;
-        QString url;
-        QString description;
-
-        foreach (const QString & line, entryLines) {
-            if (line.startsWith(nameStart)) {
-                name = line.mid( QString(nameStart).length() ).simplified();
-            } else if (line.startsWith(urlStart)) {
-                url = line.mid( QString(urlStart).length() ).simplified();
-            } else if (line.startsWith(descriptionStart)) {
-                description = line.mid(QString(descriptionStart).length())
-                              .simplified();
-            }
-        }
-        
-        BookmarkMatch bookmarkMatch(m_favicon, term, name, url, description);
-        bookmarkMatch.addTo(matches, addEverything);
+    if (m_prepared) {
+        m_index->match(m_operaBookmarksFilePath, term, addEverything, m_favicon, matches);
     }
     return matches;
 }
@@ -70,11 +57,18 @@ QList<BookmarkMatch> Opera::match( const QString& term, bool addEverything )
 
 void Opera::prepare()
 {
-          // open bookmarks file
-        QString operaBookmarksFilePath = QDir::homePath() + "/.opera/bookmarks.adr";
-        QFile operaBookmarksFile(operaBookmarksFilePath);
+        // the file is only read again after it has been changed
+        const QDateTime modified = QFileInfo(m_operaBookmarksFilePath).lastModified();
+        if (!m_index->isOutdated(m_operaBookmarksFilePath, modified)) {
+            m_prepared = true;
+            return;
+        }
+
+        // open bookmarks file
+        QFile operaBookmarksFile(m_operaBookmarksFilePath);
         if (!operaBookmarksFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            kDebug(kdbg_code) << "Could not open Operas Bookmark File " + operaBookmarksFilePath;
+            kDebug(kdbg_code) << "Could not open Operas Bookmark File " + m_operaBookmarksFilePath;
+            m_index->remove(m_operaBookmarksFilePath);
             return;
         }
 
@@ -88,14 +82,45 @@ void Opera::prepare()
 
         // load contents
         QString contents = operaBookmarksFile.readAll();
-        m_operaBookmarkEntries = contents.split("\n\n", QString::SkipEmptyParts);
+        QStringList operaBookmarkEntries = contents.split("\n\n", QString::SkipEmptyParts);
 
         // close file
         operaBookmarksFile.close();
+
+        QLatin1String nameStart("\tNAME=");
+        QLatin1String urlStart("\tURL=");
+        QLatin1String descriptionStart("\tDESCRIPTION=");
+
+        // parse
+        QList<BookmarksIndex::Bookmark> bookmarks;
+        foreach (const QString & entry, operaBookmarkEntries) {
+            QStringList entryLines = entry.split("\n");
+            if (!entryLines.first().startsWith(QString("#URL"))) {
+                continue; // skip folder entries
+            }
+            entryLines.pop_front();
+
+            BookmarksIndex::Bookmark bookmark;
+            foreach (const QString & line, entryLines) {
+                if (line.startsWith(nameStart)) {
+                    bookmark.title = line.mid( QString(nameStart).length() ).simplified();
+                } else if (line.startsWith(urlStart)) {
+                    bookmark.url = line.mid( QString(urlStart).length() ).simplified();
+                } else if (line.startsWith(descriptionStart)) {
+                    bookmark.description = line.mid(QString(descriptionStart).length())
+                                           .simplified();
+                }
+            }
+            bookmarks << bookmark;
+        }
+
+        m_index->update(m_operaBookmarksFilePath, modified, bookmarks);
+        m_index->save();
+        m_prepared = true;
 }
 
 void Opera::teardown()
 {
-  m_operaBookmarkEntries.clear();
+  m_prepared = false;
 }
 
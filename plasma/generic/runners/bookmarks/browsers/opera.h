@@ -24,7 +24,7 @@
 #define OPERA_H
 
 #include "browser.h"
-#include <QStringList>
+#include "bookmarksindex.h"
 
 class Favicon;
 
@@ -32,14 +32,18 @@ class Opera : public QObject, public Browser
 {
 Q_OBJECT
 public:
-    Opera(QObject* parent = 0);
+    Opera(QObject* parent = 0, BookmarksIndex *index = 0);
+    ~Opera();
     virtual QList<BookmarkMatch> match(const QString& term, bool addEverything);
 public slots:
     virtual void prepare();
     virtual void teardown();
 private:
-    QStringList m_operaBookmarkEntries;
+    QString const m_operaBookmarksFilePath;
     Favicon * const m_favicon;
+    BookmarksIndex *m_index;
+    bool const m_ownsIndex;
+    bool m_prepared;
 };
 
 #endif // OPERA_H
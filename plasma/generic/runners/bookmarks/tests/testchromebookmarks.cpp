@@ -21,9 +21,11 @@
 #include "testchromebookmarks.h"
 #include <QTest>
 #include <QDir>
+#include <QFileInfo>
 #include "browsers/chrome.h"
 #include "browsers/chromefindprofile.h"
 #include "favicon.h"
+#include "bookmarksindex.h"
 
 using namespace Plasma;
 
@@ -120,6 +122,32 @@ void TestChromeBookmarks::itShouldFindBookmarksFromAllProfiles()
     verifyMatch(matches[3], "bookmark in secondProfile", "http://secondprofile.com/", 0.18, QueryMatch::PossibleMatch);
 }
 
+void TestChromeBookmarks::itShouldKeepBookmarksOfUnchangedProfilesInTheIndex()
+{
+    const QString indexFile("bookmarks-index-test");
+    const QString profile("chrome-config-home/Chrome-Bookmarks-Sample.json");
+    QFile::remove(indexFile);
+
+    BookmarksIndex *index = new BookmarksIndex(indexFile);
+    Chrome *chrome = new Chrome(&findBookmarksInCurrentDirectory, this, index);
+    chrome->prepare();
+    QCOMPARE(chrome->match("any", true).size(), 3);
+    delete chrome;
+    delete index;
+
+    BookmarksIndex storedIndex(indexFile);
+    QVERIFY(!storedIndex.isOutdated(profile, QFileInfo(profile).lastModified()));
+    QVERIFY(storedIndex.isOutdated(profile, QFileInfo(profile).lastModified().addSecs(1)));
+
+    QList<BookmarkMatch> matches;
+    storedIndex.match(profile, "other", false, 0, matches);
+    QCOMPARE(matches.size(), 1);
+    storedIndex.match(profile, "any", true, 0, matches);
+    QCOMPARE(matches.size(), 4);
+
+    QFile::remove(indexFile);
+}
+
 #include "testchromebookmarks.moc"
 
 QTEST_MAIN(TestChromeBookmarks);
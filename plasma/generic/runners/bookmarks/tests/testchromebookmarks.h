@@ -47,6 +47,7 @@ private slots:
   void itShouldFindOnlyMatches();
   void itShouldClearResultAfterCallingTeardown();
   void itShouldFindBookmarksFromAllProfiles();
+  void itShouldKeepBookmarksOfUnchangedProfilesInTheIndex();
 
 };
 
@@ -0,0 +1,599 @@
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "calculatorevaluator.h"
+
+#include <QRegExp>
+#include <QScriptContext>
+#include <QScriptEngine>
+#include <QScriptValue>
+#include <QVarLengthArray>
+
+#include <math.h>
+
+// the cache is dropped as a whole once it is full
+static const int s_maxCachedResults = 256;
+
+enum Function {
+    Abs,
+    Acos,
+    Asin,
+    Atan,
+    Atan2,
+    Ceil,
+    Cos,
+    Exp,
+    Floor,
+    Log,
+    Max,
+    Min,
+    Pow,
+    Round,
+    Sin,
+    Sqrt,
+    Tan
+};
+
+static const struct {
+    const char *name;
+    // -1 for any number of arguments
+    int argumentCount;
+} s_functions[] = {
+    { "abs", 1 },
+    { "acos", 1 },
+    { "asin", 1 },
+    { "atan", 1 },
+    { "atan2", 2 },
+    { "ceil", 1 },
+    { "cos", 1 },
+    { "exp", 1 },
+    { "floor", 1 },
+    { "log", 1 },
+    { "max", -1 },
+    { "min", -1 },
+    { "pow", 2 },
+    { "round", 1 },
+    { "sin", 1 },
+    { "sqrt", 1 },
+    { "tan", 1 }
+};
+static const int s_functionCount = sizeof(s_functions) / sizeof(s_functions[0]);
+
+static double jsRound(double value)
+{
+    // Math.round rounds halves up, also for negative numbers
+    const double lower = floor(value);
+    return value - lower >= 0.5 ? lower + 1 : lower;
+}
+
+static double jsPow(double base, double exponent)
+{
+    // the C library gives 1 where ECMAScript wants NaN
+    if (qIsNaN(exponent) || (qIsInf(exponent) && fabs(base) == 1)) {
+        return qQNaN();
+    }
+    return pow(base, exponent);
+}
+
+static qint32 toInt32(double value)
+{
+    if (qIsNaN(value) || qIsInf(value)) {
+        return 0;
+    }
+
+    double truncated = fmod(value < 0 ? ceil(value) : floor(value), 4294967296.0);
+    if (truncated < 0) {
+        truncated += 4294967296.0;
+    }
+    return qint32(quint32(truncated));
+}
+
+/**
+ * Recursive descent parser for the supported subset of ECMAScript, giving up
+ * on anything it does not know.
+ */
+class CalculatorEvaluator::Compiler
+{
+    public:
+        Compiler(const QString &expression, Program &program)
+            : m_expression(expression), m_position(0), m_program(program)
+        {
+        }
+
+        bool compile()
+        {
+            return bitwiseOr() && atEnd();
+        }
+
+    private:
+        bool atEnd() const
+        {
+            return m_position >= m_expression.length();
+        }
+
+        QChar current() const
+        {
+            return atEnd() ? QChar() : m_expression.at(m_position);
+        }
+
+        QChar next() const
+        {
+            return m_position + 1 < m_expression.length() ? m_expression.at(m_position + 1) : QChar();
+        }
+
+        void append(Instruction::Operation operation, double value = 0, int function = 0, int argumentCount = 0)
+        {
+            Instruction instruction;
+            instruction.operation = operation;
+            instruction.value = value;
+            instruction.function = function;
+            instruction.argumentCount = argumentCount;
+            m_program.append(instruction);
+        }
+
+        bool bitwiseOr()
+        {
+            if (!bitwiseXor()) {
+                return false;
+            }
+
+            while (current() == '|') {
+                // || is a logical operator
+                if (next() == '|') {
+                    return false;
+                }
+                ++m_position;
+                if (!bitwiseXor()) {
+                    return false;
+                }
+                append(Instruction::Or);
+            }
+            return true;
+        }
+
+        bool bitwiseXor()
+        {
+            if (!bitwiseAnd()) {
+                return false;
+            }
+
+            while (current() == '^') {
+                ++m_position;
+                if (!bitwiseAnd()) {
+                    return false;
+                }
+                append(Instruction::Xor);
+            }
+            return true;
+        }
+
+        bool bitwiseAnd()
+        {
+            if (!additive()) {
+                return false;
+            }
+
+            while (current() == '&') {
+                if (next() == '&') {
+                    return false;
+                }
+                ++m_position;
+                if (!additive()) {
+                    return false;
+                }
+                append(Instruction::And);
+            }
+            return true;
+        }
+
+        bool additive()
+        {
+            if (!multiplicative()) {
+                return false;
+            }
+
+            while (current() == '+' || current() == '-') {
+                const QChar operation = current();
+                // ++ and -- are increments, which are not supported
+                if (next() == operation) {
+                    return false;
+                }
+                ++m_position;
+                if (!multiplicative()) {
+                    return false;
+                }
+                append(operation == '+' ? Instruction::Add : Instruction::Subtract);
+            }
+            return true;
+        }
+
+        bool multiplicative()
+        {
+            if (!unary()) {
+                return false;
+            }
+
+            while (current() == '*' || current() == '/' || current() == '%') {
+                const QChar operation = current();
+                ++m_position;
+                if (!unary()) {
+                    return false;
+                }
+                append(operation == '*' ? Instruction::Multiply :
+                       operation == '/' ? Instruction::Divide : Instruction::Modulo);
+            }
+            return true;
+        }
+
+        bool unary()
+        {
+            if (current() == '+' || current() == '-') {
+                const QChar operation = current();
+                if (next() == operation) {
+                    return false;
+                }
+                ++m_position;
+                if (!unary()) {
+                    return false;
+                }
+                // unary plus converts to a number, which all values already are
+                if (operation == '-') {
+                    append(Instruction::Negate);
+                }
+                return true;
+            }
+
+            return primary();
+        }
+
+        bool primary()
+        {
+            const QChar c = current();
+            if (c == '(') {
+                ++m_position;
+                if (!bitwiseOr() || current() != ')') {
+                    return false;
+                }
+                ++m_position;
+                return true;
+            }
+
+            if (isDigit(c) || c == '.') {
+                return number();
+            }
+
+            if (isLetter(c)) {
+                return name();
+            }
+
+            return false;
+        }
+
+        bool number()
+        {
+            const int start = m_position;
+            // octal literals are left to the script engine
+            if (current() == '0' && isDigit(next())) {
+                return false;
+            }
+
+            while (isDigit(current())) {
+                ++m_position;
+            }
+            if (current() == '.') {
+                ++m_position;
+                while (isDigit(current())) {
+                    ++m_position;
+                }
+            }
+
+            // exponents and anything glued to the number
+            if (isLetter(current()) || isDigit(current()) || current() == '.') {
+                return false;
+            }
+
+            bool ok = false;
+            const double value = m_expression.mid(start, m_position - start).toDouble(&ok);
+            if (!ok) {
+                return false;
+            }
+
+            append(Instruction::Push, value);
+            return true;
+        }
+
+        bool name()
+        {
+            const int start = m_position;
+            while (isLetter(current()) || isDigit(current())) {
+                ++m_position;
+            }
+            const QString identifier = m_expression.mid(start, m_position - start);
+
+            if (current() != '(') {
+                if (identifier == "PI") {
+                    append(Instruction::Push, M_PI);
+                    return true;
+                } else if (identifier == "E") {
+                    append(Instruction::Push, M_E);
+                    return true;
+                }
+                return false;
+            }
+
+            int function = 0;
+            while (function < s_functionCount && identifier != QLatin1String(s_functions[function].name)) {
+                ++function;
+            }
+            if (function == s_functionCount) {
+                return false;
+            }
+
+            ++m_position;
+            int argumentCount = 0;
+            if (current() != ')') {
+                forever {
+                    if (!bitwiseOr()) {
+                        return false;
+                    }
+                    ++argumentCount;
+                    if (current() != ',') {
+                        break;
+                    }
+                    ++m_position;
+                }
+            }
+            if (current() != ')') {
+                return false;
+            }
+            ++m_position;
+
+            // missing and additional arguments are left to the script engine
+            if (s_functions[function].argumentCount == -1 ? argumentCount == 0
+                                                           : argumentCount != s_functions[function].argumentCount) {
+                return false;
+            }
+
+            append(Instruction::Call, 0, function, argumentCount);
+            return true;
+        }
+
+        static bool isDigit(const QChar &c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        static bool isLetter(const QChar &c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        }
+
+        const QString &m_expression;
+        int m_position;
+        Program &m_program;
+};
+
+/**
+ * The script engine of one thread. It is deleted when the thread finishes,
+ * or with the evaluator if that goes away first.
+ */
+class CalculatorEvaluator::ThreadEngine
+{
+    public:
+        explicit ThreadEngine(CalculatorEvaluator *evaluator)
+            : evaluator(evaluator)
+        {
+            QMutexLocker lock(&evaluator->m_enginesMutex);
+            evaluator->m_threadEngines << this;
+        }
+
+        ~ThreadEngine()
+        {
+            if (evaluator) {
+                QMutexLocker lock(&evaluator->m_enginesMutex);
+                evaluator->m_threadEngines.removeOne(this);
+            }
+        }
+
+        QScriptEngine engine;
+        CalculatorEvaluator *evaluator;
+};
+
+CalculatorEvaluator::CalculatorEvaluator()
+{
+}
+
+CalculatorEvaluator::~CalculatorEvaluator()
+{
+    // QThreadStorage does not delete the data of the other threads itself,
+    // and no longer does so when they finish
+    QList<ThreadEngine *> engines;
+    {
+        QMutexLocker lock(&m_enginesMutex);
+        engines = m_threadEngines;
+        m_threadEngines.clear();
+    }
+
+    foreach (ThreadEngine *engine, engines) {
+        engine->evaluator = 0;
+        delete engine;
+    }
+}
+
+QString CalculatorEvaluator::evaluate(const QString &expression)
+{
+    {
+        QMutexLocker lock(&m_resultsMutex);
+        QHash<QString, QString>::const_iterator it = m_results.constFind(expression);
+        if (it != m_results.constEnd()) {
+            return it.value();
+        }
+    }
+
+    QString resultString;
+    Program program;
+    if (compile(expression, program)) {
+        const double result = run(program);
+        resultString = QScriptValue(result).toString();
+
+        //ECMAScript has issues with the last digit in simple rational computations
+        //This rounds off the last digit the same way the script did; see bug 167986
+        if (resultString.contains('.')) {
+            const double exponent = 14 - (1 + floor(log(fabs(result)) / log(10.0)));
+            const double order = pow(10.0, exponent);
+            resultString = QScriptValue(order > 0 ? jsRound(result * order) / order : 0).toString();
+        }
+    } else {
+        resultString = evaluateScript(expression);
+    }
+
+    QMutexLocker lock(&m_resultsMutex);
+    if (m_results.count() >= s_maxCachedResults) {
+        m_results.clear();
+    }
+    m_results.insert(expression, resultString);
+    return resultString;
+}
+
+QString CalculatorEvaluator::evaluateScript(const QString &expression)
+{
+    // matches run in several threads, an engine must only be used by one of them
+    if (!m_engines.hasLocalData()) {
+        m_engines.setLocalData(new ThreadEngine(this));
+    }
+    QScriptEngine *eng = &m_engines.localData()->engine;
+
+    QString term = expression;
+    term.replace(QRegExp("([a-zA-Z]+)"), "Math.\\1"); //needed for accessing math funktions like sin(),....
+
+    // The engine is kept for the next expressions, so each one is evaluated in a
+    // context of its own. Assignments like "sin=5" go to a Math object which only
+    // lives as long as the context and falls back to the real one for all reads.
+    QScriptContext *context = eng->pushContext();
+    QScriptValue math = eng->newObject();
+    math.setPrototype(eng->globalObject().property("Math"));
+    context->activationObject().setProperty("Math", math);
+
+    QString resultString = eng->evaluate(" var result ="+term+"; result").toString();
+    if (eng->hasUncaughtException()) {
+        resultString.clear();
+    } else if (resultString.contains('.')) {
+        //ECMAScript has issues with the last digit in simple rational computations
+        //This script rounds off the last digit; see bug 167986
+        resultString = eng->evaluate("var exponent = 14-(1+Math.floor(Math.log(Math.abs(result))/Math.log(10)));\
+                                      var order=Math.pow(10,exponent);\
+                                      (order > 0? Math.round(result*order)/order : 0)").toString();
+    }
+
+    eng->popContext();
+    return resultString;
+}
+
+bool CalculatorEvaluator::compile(const QString &expression, Program &program)
+{
+    Compiler compiler(expression, program);
+    return compiler.compile();
+}
+
+double CalculatorEvaluator::run(const Program &program)
+{
+    QVarLengthArray<double, 32> stack;
+    foreach (const Instruction &instruction, program) {
+        const int top = stack.count() - 1;
+        switch (instruction.operation) {
+        case Instruction::Push:
+            stack.append(instruction.value);
+            break;
+        case Instruction::Negate:
+            stack[top] = -stack[top];
+            break;
+        case Instruction::Add:
+            stack[top - 1] += stack[top];
+            stack.resize(top);
+            break;
+        case Instruction::Subtract:
+            stack[top - 1] -= stack[top];
+            stack.resize(top);
+            break;
+        case Instruction::Multiply:
+            stack[top - 1] *= stack[top];
+            stack.resize(top);
+            break;
+        case Instruction::Divide:
+            stack[top - 1] /= stack[top];
+            stack.resize(top);
+            break;
+        case Instruction::Modulo:
+            stack[top - 1] = fmod(stack[top - 1], stack[top]);
+            stack.resize(top);
+            break;
+        case Instruction::And:
+            stack[top - 1] = toInt32(stack[top - 1]) & toInt32(stack[top]);
+            stack.resize(top);
+            break;
+        case Instruction::Or:
+            stack[top - 1] = toInt32(stack[top - 1]) | toInt32(stack[top]);
+            stack.resize(top);
+            break;
+        case Instruction::Xor:
+            stack[top - 1] = toInt32(stack[top - 1]) ^ toInt32(stack[top]);
+            stack.resize(top);
+            break;
+        case Instruction::Call: {
+            const int first = stack.count() - instruction.argumentCount;
+            double value = stack[first];
+            switch (instruction.function) {
+            case Abs: value = fabs(value); break;
+            case Acos: value = acos(value); break;
+            case Asin: value = asin(value); break;
+            case Atan: value = atan(value); break;
+            case Atan2: value = atan2(value, stack[first + 1]); break;
+            case Ceil: value = ceil(value); break;
+            case Cos: value = cos(value); break;
+            case Exp: value = exp(value); break;
+            case Floor: value = floor(value); break;
+            case Log: value = log(value); break;
+            case Max:
+            case Min:
+                for (int i = first + 1; i < stack.count() && !qIsNaN(value); ++i) {
+                    const double argument = stack[i];
+                    if (qIsNaN(argument)) {
+                        value = argument;
+                    } else if (argument == 0 && value == 0) {
+                        // +0 is larger than -0, the sign only shows in the inverse
+                        if (instruction.function == Max ? 1 / argument > 0 : 1 / argument < 0) {
+                            value = argument;
+                        }
+                    } else if (instruction.function == Max ? argument > value : argument < value) {
+                        value = argument;
+                    }
+                }
+                break;
+            case Pow: value = jsPow(value, stack[first + 1]); break;
+            case Round: value = jsRound(value); break;
+            case Sin: value = sin(value); break;
+            case Sqrt: value = sqrt(value); break;
+            case Tan: value = tan(value); break;
+            }
+            stack.resize(first + 1);
+            stack[first] = value;
+            break;
+        }
+        }
+    }
+
+    return stack[0];
+}
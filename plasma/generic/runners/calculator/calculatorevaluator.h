@@ -0,0 +1,93 @@
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef CALCULATOREVALUATOR_H
+#define CALCULATOREVALUATOR_H
+
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThreadStorage>
+#include <QVector>
+
+class QScriptEngine;
+
+/**
+ * Evaluates the expressions of the calculator runner as ECMAScript would.
+ *
+ * Arithmetic, the bitwise operators and the functions of the Math object are
+ * compiled into a small stack program and computed directly. Everything else
+ * is handed to a script engine, which is kept for each thread. The results are
+ * cached by expression, as the same expressions come back while typing.
+ */
+class CalculatorEvaluator
+{
+    public:
+        CalculatorEvaluator();
+        ~CalculatorEvaluator();
+
+        /**
+         * @returns the value of @p expression with the last digits rounded
+         * off, using '.' as decimal symbol, or an empty string if
+         * @p expression is not valid. Functions and constants are given
+         * without the "Math." prefix.
+         */
+        QString evaluate(const QString &expression);
+
+        /**
+         * @returns the value of @p expression computed by the script engine only
+         */
+        QString evaluateScript(const QString &expression);
+
+    private:
+        struct Instruction {
+            enum Operation {
+                Push,
+                Negate,
+                Add,
+                Subtract,
+                Multiply,
+                Divide,
+                Modulo,
+                And,
+                Or,
+                Xor,
+                Call
+            };
+
+            Operation operation;
+            double value;
+            int function;
+            int argumentCount;
+        };
+        typedef QVector<Instruction> Program;
+
+        class Compiler;
+        class ThreadEngine;
+
+        static bool compile(const QString &expression, Program &program);
+        static double run(const Program &program);
+
+        QMutex m_resultsMutex;
+        QHash<QString, QString> m_results;
+        QMutex m_enginesMutex;
+        // the engines of all threads, deleted with the evaluator if the threads outlive it
+        QList<ThreadEngine *> m_threadEngines;
+        QThreadStorage<ThreadEngine *> m_engines;
+};
+
+#endif
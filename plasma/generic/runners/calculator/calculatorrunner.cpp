@@ -24,7 +24,7 @@
 #ifdef ENABLE_QALCULATE
 #include "qalculate_engine.h"
 #else
-#include <QScriptEngine>
+#include "calculatorevaluator.h"
 #endif
 
 #include <KIcon>
@@ -41,6 +41,8 @@ CalculatorRunner::CalculatorRunner( QObject* parent, const QVariantList &args )
     #ifdef ENABLE_QALCULATE
     m_engine = new QalculateEngine;
     setSpeed(SlowSpeed);
+    #else
+    m_evaluator = new CalculatorEvaluator;
     #endif
 
     setObjectName( QLatin1String("Calculator" ));
@@ -59,6 +61,8 @@ CalculatorRunner::~CalculatorRunner()
 {
     #ifdef ENABLE_QALCULATE
     delete m_engine;
+    #else
+    delete m_evaluator;
     #endif
 }
 
@@ -240,9 +244,6 @@ void CalculatorRunner::match(Plasma::RunnerContext &context)
     }
 
     userFriendlySubstitutions(cmd);
-    #ifndef ENABLE_QALCULATE
-    cmd.replace(QRegExp("([a-zA-Z]+)"), "Math.\\1"); //needed for accessing math funktions like sin(),....
-    #endif
 
     QString result = calculate(cmd);
     if (!result.isEmpty() && result != cmd) {
@@ -274,31 +275,8 @@ QString CalculatorRunner::calculate(const QString& term)
     return result.replace('.', KGlobal::locale()->decimalSymbol(), Qt::CaseInsensitive);
     #else
     //kDebug() << "calculating" << term;
-    QScriptEngine eng;
-    QScriptValue result = eng.evaluate(" var result ="+term+"; result");
-
-    if (result.isError()) {
-        return QString();
-    }
-
-    const QString resultString = result.toString();
-    if (resultString.isEmpty()) {
-        return QString();
-    }
-
-    if (!resultString.contains('.')) {
-        return resultString;
-    }
-
-    //ECMAScript has issues with the last digit in simple rational computations
-    //This script rounds off the last digit; see bug 167986
-    QString roundedResultString = eng.evaluate("var exponent = 14-(1+Math.floor(Math.log(Math.abs(result))/Math.log(10)));\
-                                                var order=Math.pow(10,exponent);\
-                                                (order > 0? Math.round(result*order)/order : 0)").toString();
-
-    roundedResultString.replace('.', KGlobal::locale()->decimalSymbol(), Qt::CaseInsensitive);
-
-    return roundedResultString;
+    QString result = m_evaluator->evaluate(term);
+    return result.replace('.', KGlobal::locale()->decimalSymbol(), Qt::CaseInsensitive);
     #endif
 }
 
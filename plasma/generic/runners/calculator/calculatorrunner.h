@@ -25,6 +25,8 @@
 
 #ifdef ENABLE_QALCULATE
 class QalculateEngine;
+#else
+class CalculatorEvaluator;
 #endif
 
 #include <Plasma/AbstractRunner>
@@ -55,6 +57,8 @@ class CalculatorRunner : public Plasma::AbstractRunner
 
         #ifdef ENABLE_QALCULATE
         QalculateEngine* m_engine;
+        #else
+        CalculatorEvaluator* m_evaluator;
         #endif
 };
 
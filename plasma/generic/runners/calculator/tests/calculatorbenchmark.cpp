@@ -0,0 +1,127 @@
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "calculatorbenchmark.h"
+
+#include <QTest>
+
+#include "calculatorevaluator.h"
+
+void CalculatorBenchmark::sameResultsAsScriptEngine_data()
+{
+    QTest::addColumn<QString>("expression");
+
+    QTest::newRow("precedence") << "2*(3+4)*5-6/7";
+    QTest::newRow("rounding") << "0.1+0.2";
+    QTest::newRow("modulo") << "-5.5%2";
+    QTest::newRow("unary") << "5+-3";
+    QTest::newRow("division by zero") << "-1/0";
+    QTest::newRow("not a number") << "0/0";
+    QTest::newRow("bitwise") << "1|2^3&4";
+    QTest::newRow("int32") << "3000000000|0";
+    QTest::newRow("pow") << "pow(2,0.5)";
+    QTest::newRow("functions") << "sin(PI/2)+max(1,2,3)+round(-2.5)";
+    QTest::newRow("octal") << "010+1";
+    QTest::newRow("decrement") << "5--3";
+    QTest::newRow("incomplete") << "12+";
+    QTest::newRow("missing argument") << "abs()";
+}
+
+void CalculatorBenchmark::sameResultsAsScriptEngine()
+{
+    QFETCH(QString, expression);
+
+    CalculatorEvaluator evaluator;
+    QCOMPARE(evaluator.evaluate(expression), evaluator.evaluateScript(expression));
+}
+
+void CalculatorBenchmark::scriptEngineKeepsMath()
+{
+    // the engine of the thread is used for all expressions, assignments must not stick
+    CalculatorEvaluator evaluator;
+    QCOMPARE(evaluator.evaluateScript("sin=5"), QString("5"));
+    QCOMPARE(evaluator.evaluateScript("sin(0)"), QString("0"));
+    QCOMPARE(evaluator.evaluateScript("x=3"), QString("3"));
+    QCOMPARE(evaluator.evaluateScript("x"), QString("undefined"));
+    QCOMPARE(evaluator.evaluateScript("result"), QString("undefined"));
+}
+
+void CalculatorBenchmark::typingData()
+{
+    QTest::addColumn<QString>("expression");
+
+    QTest::newRow("arithmetic") << "12+34*5-6/7";
+    QTest::newRow("decimals") << "(1.5+2.25)*4/3";
+    QTest::newRow("functions") << "pow(2,10)-sqrt(16)";
+    QTest::newRow("bitwise") << "255&15|64";
+}
+
+void CalculatorBenchmark::typingScriptEngine_data()
+{
+    typingData();
+}
+
+void CalculatorBenchmark::typingScriptEngine()
+{
+    QFETCH(QString, expression);
+
+    QBENCHMARK {
+        // a new engine for every keystroke
+        for (int i = 1; i <= expression.length(); ++i) {
+            CalculatorEvaluator evaluator;
+            evaluator.evaluateScript(expression.left(i));
+        }
+    }
+}
+
+void CalculatorBenchmark::typingEvaluator_data()
+{
+    typingData();
+}
+
+void CalculatorBenchmark::typingEvaluator()
+{
+    QFETCH(QString, expression);
+
+    QBENCHMARK {
+        // nothing is cached yet, incomplete prefixes fall back to the engine
+        CalculatorEvaluator evaluator;
+        for (int i = 1; i <= expression.length(); ++i) {
+            evaluator.evaluate(expression.left(i));
+        }
+    }
+}
+
+void CalculatorBenchmark::typingCachedEvaluator_data()
+{
+    typingData();
+}
+
+void CalculatorBenchmark::typingCachedEvaluator()
+{
+    QFETCH(QString, expression);
+
+    CalculatorEvaluator evaluator;
+    QBENCHMARK {
+        for (int i = 1; i <= expression.length(); ++i) {
+            evaluator.evaluate(expression.left(i));
+        }
+    }
+}
+
+QTEST_MAIN(CalculatorBenchmark)
+
+#include "calculatorbenchmark.moc"
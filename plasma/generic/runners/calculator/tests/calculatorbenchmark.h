@@ -0,0 +1,45 @@
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef CALCULATORBENCHMARK_H
+#define CALCULATORBENCHMARK_H
+
+#include <QObject>
+
+/**
+ * Measures the latency of the calculator per keystroke: every expression is
+ * evaluated once for each prefix, as the runner sees it while it is typed.
+ */
+class CalculatorBenchmark : public QObject
+{
+    Q_OBJECT
+private slots:
+    void sameResultsAsScriptEngine_data();
+    void sameResultsAsScriptEngine();
+    void scriptEngineKeepsMath();
+
+    void typingScriptEngine_data();
+    void typingScriptEngine();
+    void typingEvaluator_data();
+    void typingEvaluator();
+    void typingCachedEvaluator_data();
+    void typingCachedEvaluator();
+
+private:
+    void typingData();
+};
+
+#endif
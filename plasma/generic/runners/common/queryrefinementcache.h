@@ -0,0 +1,140 @@
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef QUERYREFINEMENTCACHE_H
+#define QUERYREFINEMENTCACHE_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+/**
+ * Remembers the candidates a runner found for its last queries, so that a
+ * query which extends one of them only has to filter those candidates again
+ * instead of scanning everything.
+ *
+ * This only works for runners whose candidates for a query are a superset
+ * of the candidates of every longer query starting with it, e.g. when they
+ * match substrings. Runners pass the query in the form they compare it,
+ * e.g. case folded.
+ *
+ * The cache has to be invalidated whenever the data the candidates were
+ * taken from changes. As runners match in several threads, candidates are
+ * only looked up and inserted if no invalidation happened since the
+ * generation() the caller took its data in.
+ */
+template <typename Candidate>
+class QueryRefinementCache
+{
+public:
+    explicit QueryRefinementCache(int size = 8)
+        : m_size(size),
+          m_generation(0)
+    {
+    }
+
+    /**
+     * @returns the generation to pass to insert(), to be read before the
+     * data of the runner is accessed
+     */
+    int generation() const
+    {
+        QMutexLocker lock(&m_mutex);
+        return m_generation;
+    }
+
+    /**
+     * Looks up the candidates of the longest cached query which @p query
+     * starts with, or of @p query itself.
+     * @returns false if there is none, or if the cache has been invalidated
+     * since @p generation, and everything has to be scanned
+     */
+    bool refine(const QString &query, QList<Candidate> &candidates, int generation) const
+    {
+        QMutexLocker lock(&m_mutex);
+        // newer candidates might not be valid for the data the caller has
+        if (generation != m_generation) {
+            return false;
+        }
+
+        int best = -1;
+        for (int i = 0; i < m_entries.count(); ++i) {
+            const QString &cached = m_entries.at(i).query;
+            if (query.startsWith(cached) &&
+                (best == -1 || cached.length() > m_entries.at(best).query.length())) {
+                best = i;
+            }
+        }
+
+        if (best == -1) {
+            return false;
+        }
+
+        candidates = m_entries.at(best).candidates;
+        return true;
+    }
+
+    /**
+     * Remembers the @p candidates found for @p query, unless the cache has
+     * been invalidated since @p generation.
+     */
+    void insert(const QString &query, const QList<Candidate> &candidates, int generation)
+    {
+        QMutexLocker lock(&m_mutex);
+        if (generation != m_generation) {
+            return;
+        }
+
+        for (int i = 0; i < m_entries.count(); ++i) {
+            if (m_entries.at(i).query == query) {
+                m_entries.removeAt(i);
+                break;
+            }
+        }
+
+        Entry entry;
+        entry.query = query;
+        entry.candidates = candidates;
+        m_entries.prepend(entry);
+        while (m_entries.count() > m_size) {
+            m_entries.removeLast();
+        }
+    }
+
+    /**
+     * Drops all candidates, to be called when the data of the runner changes.
+     */
+    void invalidate()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_entries.clear();
+        ++m_generation;
+    }
+
+private:
+    struct Entry {
+        QString query;
+        QList<Candidate> candidates;
+    };
+
+    mutable QMutex m_mutex;
+    // the most recently inserted first
+    QList<Entry> m_entries;
+    int const m_size;
+    int m_generation;
+};
+
+#endif
@@ -20,6 +20,8 @@
 #include "killrunner.h"
 
 #include <QAction>
+#include <QHash>
+#include <QRunnable>
 
 #include <KDebug>
 #include <KIcon>
@@ -32,9 +34,32 @@
 
 #include "killrunner_config.h"
 
+/** the processes are not read more often than this, in milliseconds */
+static const int s_snapshotInterval = 2000;
+
+class ProcessSnapshotTask : public QRunnable
+{
+public:
+    ProcessSnapshotTask(KillRunner *runner, int updateFlags)
+        : m_runner(runner),
+          m_updateFlags(updateFlags)
+    {
+    }
+
+    void run()
+    {
+        m_runner->takeSnapshot(m_updateFlags);
+    }
+
+private:
+    KillRunner *m_runner;
+    int m_updateFlags;
+};
+
 KillRunner::KillRunner(QObject *parent, const QVariantList& args)
         : Plasma::AbstractRunner(parent, args),
-          m_processes(0)
+          m_processes(0),
+          m_snapshotPending(false)
 {
     Q_UNUSED(args);
     setObjectName( QLatin1String("Kill Runner") );
@@ -46,10 +71,14 @@ KillRunner::KillRunner(QObject *parent, const QVariantList& args)
     m_delayedCleanupTimer.setInterval(50);
     m_delayedCleanupTimer.setSingleShot(true);
     connect(&m_delayedCleanupTimer, SIGNAL(timeout()), this, SLOT(cleanup()));
+
+    m_snapshotPool.setMaxThreadCount(1);
 }
 
 KillRunner::~KillRunner()
 {
+    m_snapshotPool.waitForDone();
+    delete m_processes;
 }
 
 
@@ -71,22 +100,75 @@ void KillRunner::reloadConfiguration()
 void KillRunner::prep()
 {
     m_delayedCleanupTimer.stop();
+
+    // the processes are read in the background while the user starts typing
+    QMutexLocker lock(&m_snapshotMutex);
+    if (!m_processes) {
+        m_processes = new KSysGuard::Processes();
+    }
+    requestSnapshot();
 }
 
 void KillRunner::cleanup()
 {
+    QMutexLocker lock(&m_snapshotMutex);
     if (!m_processes) {
         return;
     }
 
-    if (m_prepLock.tryLockForWrite()) {
-        delete m_processes;
-        m_processes = 0;
+    if (m_snapshotPending) {
+        // the task still uses m_processes, try again later
+        m_delayedCleanupTimer.start();
+        return;
+    }
 
-        m_prepLock.unlock();
-    } else {
-        m_delayedCleanupTimer.stop();
+    delete m_processes;
+    m_processes = 0;
+    m_snapshot.clear();
+    m_snapshotTime = QTime();
+}
+
+void KillRunner::requestSnapshot()
+{
+    if (!m_processes || m_snapshotPending) {
+        return;
+    }
+
+    if (m_snapshotTime.isValid() && m_snapshotTime.elapsed() < s_snapshotInterval) {
+        return;
+    }
+
+    // the cpu usage is only needed to sort by it
+    const int updateFlags = m_sorting == KillRunnerConfig::NONE ? KSysGuard::Processes::MinimalInformation : 0;
+    m_snapshotPending = true;
+    m_snapshotPool.start(new ProcessSnapshotTask(this, updateFlags));
+}
+
+void KillRunner::takeSnapshot(int updateFlags)
+{
+    // m_processes is not touched by anyone else while the snapshot is pending
+    m_processes->updateAllProcesses(0, KSysGuard::Processes::UpdateFlags(updateFlags));
+
+    QList<KillableProcess> snapshot;
+    QHash<qlonglong, QString> users;
+    foreach (const KSysGuard::Process *process, m_processes->getAllProcesses()) {
+        KillableProcess killable;
+        killable.pid = process->pid;
+        killable.name = process->name;
+        killable.nameKey = process->name.toCaseFolded();
+        if (!users.contains(process->uid)) {
+            users.insert(process->uid, getUserName(process->uid));
+        }
+        killable.user = users.value(process->uid);
+        killable.cpuUsage = process->userUsage + process->sysUsage;
+        snapshot << killable;
     }
+
+    QMutexLocker lock(&m_snapshotMutex);
+    m_snapshot = snapshot;
+    m_snapshotTime.start();
+    m_snapshotPending = false;
+    m_snapshotTaken.wakeAll();
 }
 
 void KillRunner::match(Plasma::RunnerContext &context)
@@ -97,41 +179,36 @@ void KillRunner::match(Plasma::RunnerContext &context)
         return;
     }
 
-    m_prepLock.lockForRead();
-    if (!m_processes) {
-        m_prepLock.unlock();
-        m_prepLock.lockForWrite();
-        if (!m_processes) {
-            suspendMatching(true);
-            m_processes = new KSysGuard::Processes();
-            m_processes->updateAllProcesses();
-            suspendMatching(false);
-        }
-    }
-    m_prepLock.unlock();
-
     term = term.right(term.length() - m_triggerWord.length());
 
     if (term.length() < 2)  {
         return;
     }
 
+    m_snapshotMutex.lock();
+    requestSnapshot();
+    // only the first snapshot of a session is waited for, later ones replace it when done
+    while (!m_snapshotTime.isValid() && m_snapshotPending && context.isValid()) {
+        m_snapshotTaken.wait(&m_snapshotMutex, 100);
+    }
+    const QList<KillableProcess> processlist = m_snapshot;
+    m_snapshotMutex.unlock();
+
+    const QString foldedTerm = term.toCaseFolded();
     QList<Plasma::QueryMatch> matches;
-    const QList<KSysGuard::Process *> processlist = m_processes->getAllProcesses();
-    foreach (const KSysGuard::Process *process, processlist) {
+    foreach (const KillableProcess &process, processlist) {
         if (!context.isValid()) {
             return;
         }
 
-        const QString name = process->name;
-        if (!name.contains(term, Qt::CaseInsensitive)) {
+        const QString name = process.name;
+        if (!process.nameKey.contains(foldedTerm)) {
             //Process doesn't match the search term
             continue;
         }
 
-        const quint64 pid = process->pid;
-        const qlonglong uid = process->uid;
-        const QString user = getUserName(uid);
+        const quint64 pid = process.pid;
+        const QString user = process.user;
 
         QVariantList data;
         data << pid << user;
@@ -146,13 +223,13 @@ void KillRunner::match(Plasma::RunnerContext &context)
         // Set the relevance
         switch (m_sorting) {
         case KillRunnerConfig::CPU:
-            match.setRelevance((process->userUsage + process->sysUsage) / 100);
+            match.setRelevance(process.cpuUsage / 100);
             break;
         case KillRunnerConfig::CPUI:
-            match.setRelevance(1 - (process->userUsage + process->sysUsage) / 100);
+            match.setRelevance(1 - process.cpuUsage / 100);
             break;
         case KillRunnerConfig::NONE:
-            match.setRelevance(name.compare(term, Qt::CaseInsensitive) == 0 ? 1 : 9);
+            match.setRelevance(process.nameKey == foldedTerm ? 1 : 9);
             break;
         }
 
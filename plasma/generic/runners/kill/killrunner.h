@@ -20,8 +20,11 @@
 #ifndef KILLRUNNER_H
 #define KILLRUNNER_H
 
-#include <QReadWriteLock>
+#include <QMutex>
+#include <QThreadPool>
+#include <QTime>
 #include <QTimer>
+#include <QWaitCondition>
 
 #include <Plasma/AbstractRunner>
 
@@ -34,6 +37,8 @@ namespace KSysGuard
     class Process;
 }
 
+class ProcessSnapshotTask;
+
 class KillRunner : public Plasma::AbstractRunner
 {
     Q_OBJECT
@@ -52,10 +57,30 @@ private Q_SLOTS:
     void cleanup();
 
 private:
+    friend class ProcessSnapshotTask;
+
+    /** What is matched of a process */
+    struct KillableProcess {
+        quint64 pid;
+        QString name;
+        /** the case folded name */
+        QString nameKey;
+        QString user;
+        qreal cpuUsage;
+    };
+
+    /** Starts a new snapshot unless one is pending or the last one is recent,
+      * to be called with m_snapshotMutex locked
+      */
+    void requestSnapshot();
+
+    /** Reads the processes, called in the thread of m_snapshotPool */
+    void takeSnapshot(int updateFlags);
+
     /** @param uid the uid of the user
       * @return the username of the user with the UID uid
       */
-    QString getUserName(qlonglong uid);
+    static QString getUserName(qlonglong uid);
 
     /** The trigger word */
     QString m_triggerWord;
@@ -63,11 +88,26 @@ private:
     /** How to sort */
     KillRunnerConfig::Sort m_sorting;
 
-    /** process lister */
+    /** process lister, only used by the snapshot task while one is pending */
     KSysGuard::Processes *m_processes;
 
-    /** lock for initializing m_processes */
-    QReadWriteLock m_prepLock;
+    /** runs the snapshot task, one at a time */
+    QThreadPool m_snapshotPool;
+
+    /** lock for the members below */
+    QMutex m_snapshotMutex;
+
+    /** woken up whenever a snapshot has been taken */
+    QWaitCondition m_snapshotTaken;
+
+    /** the processes found by the last snapshot */
+    QList<KillableProcess> m_snapshot;
+
+    /** when the last snapshot was taken, invalid if there is none */
+    QTime m_snapshotTime;
+
+    /** whether a snapshot task has been started and not finished yet */
+    bool m_snapshotPending;
 
     /** timer for retrying the cleanup due to lock contention */
     QTimer m_delayedCleanupTimer;
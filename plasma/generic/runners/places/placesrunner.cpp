@@ -70,6 +70,17 @@ PlacesRunnerHelper::PlacesRunnerHelper(PlacesRunner *runner)
     connect(runner, SIGNAL(doMatch(Plasma::RunnerContext*)),
             this, SLOT(match(Plasma::RunnerContext*)),
             Qt::BlockingQueuedConnection);
+
+    connect(&m_places, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(placesChanged()));
+    connect(&m_places, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(placesChanged()));
+    connect(&m_places, SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(placesChanged()));
+    connect(&m_places, SIGNAL(layoutChanged()), this, SLOT(placesChanged()));
+    connect(&m_places, SIGNAL(modelReset()), this, SLOT(placesChanged()));
+}
+
+void PlacesRunnerHelper::placesChanged()
+{
+    m_matchingRows.invalidate();
 }
 
 void PlacesRunnerHelper::match(Plasma::RunnerContext *c)
@@ -87,7 +98,20 @@ void PlacesRunnerHelper::match(Plasma::RunnerContext *c)
 
     QList<Plasma::QueryMatch> matches;
     const bool all = term.compare(i18n("places"), Qt::CaseInsensitive) == 0;
-    for (int i = 0; i <= m_places.rowCount(); i++) {
+
+    // listing all places is not a refinement of the shorter queries
+    const QString key = term.toCaseFolded();
+    const int generation = m_matchingRows.generation();
+    QList<int> rows;
+    if (all || !m_matchingRows.refine(key, rows, generation)) {
+        rows.clear();
+        for (int i = 0; i <= m_places.rowCount(); i++) {
+            rows << i;
+        }
+    }
+
+    QList<int> matchingRows;
+    foreach (int i, rows) {
         QModelIndex current_index = m_places.index(i, 0);
         Plasma::QueryMatch::Type type = Plasma::QueryMatch::NoMatch;
         qreal relevance = 0;
@@ -102,6 +126,7 @@ void PlacesRunnerHelper::match(Plasma::RunnerContext *c)
         }
 
         if (type != Plasma::QueryMatch::NoMatch) {
+            matchingRows << i;
             Plasma::QueryMatch match(static_cast<PlacesRunner *>(parent()));
             match.setType(type);
             match.setRelevance(relevance);
@@ -122,6 +147,10 @@ void PlacesRunnerHelper::match(Plasma::RunnerContext *c)
         }
     }
 
+    if (!all) {
+        m_matchingRows.insert(key, matchingRows, generation);
+    }
+
     context.addMatches(term, matches);
 }
 
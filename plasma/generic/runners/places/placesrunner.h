@@ -24,6 +24,8 @@
 #include <plasma/abstractrunner.h>
 #include <kfileplacesmodel.h>
 
+#include "queryrefinementcache.h"
+
 class PlacesRunner;
 
 class PlacesRunnerHelper : public QObject
@@ -36,8 +38,13 @@ public:
 public Q_SLOTS:
     void match(Plasma::RunnerContext *context);
 
+private Q_SLOTS:
+    void placesChanged();
+
 private:
     KFilePlacesModel m_places;
+    // rows of m_places matching the last queries
+    QueryRefinementCache<int> m_matchingRows;
 };
 
 class PlacesRunner : public Plasma::AbstractRunner
@@ -19,6 +19,8 @@
 
 #include "recentdocuments.h"
 
+#include <QDir>
+#include <QFile>
 #include <QMimeData>
 
 #include <KConfig>
@@ -28,6 +30,7 @@
 #include <KIcon>
 #include <KRun>
 #include <KRecentDocument>
+#include <KUrl>
 
 
 RecentDocuments::RecentDocuments(QObject *parent, const QVariantList& args)
@@ -53,36 +56,78 @@ RecentDocuments::~RecentDocuments()
 void RecentDocuments::loadRecentDocuments()
 {
     //kDebug() << "Refreshing recent documents.";
-    m_recentdocuments = KRecentDocument::recentDocuments();
+    QHash<QString, Document> previous;
+    {
+        QMutexLocker lock(&m_documentsMutex);
+        foreach (const Document &document, m_documents) {
+            previous.insert(document.path, document);
+        }
+    }
+
+    // the same files as KRecentDocument::recentDocuments(), but only the
+    // ones which have been changed are parsed again
+    QDir dir(KRecentDocument::recentDocumentDirectory(), "*.desktop", QDir::Time,
+             QDir::Files | QDir::Readable | QDir::Hidden);
+    QList<Document> documents;
+    foreach (const QFileInfo &info, dir.entryInfoList()) {
+        const QString path = info.absoluteFilePath();
+        const QDateTime modified = info.lastModified();
+        QHash<QString, Document>::const_iterator it = previous.constFind(path);
+        if (it != previous.constEnd() && it->modified == modified) {
+            documents << *it;
+            continue;
+        }
+
+        KConfig _config( path, KConfig::SimpleConfig );
+        KConfigGroup config(&_config, "Desktop Entry" );
+        const KUrl url(config.readPathEntry("URL", QString()));
+        if (url.isLocalFile() && !QFile::exists(url.toLocalFile())) {
+            // the document is gone, drop the entry like KRecentDocument does
+            // so that it is not parsed again on the next refresh
+            QFile::remove(path);
+            continue;
+        }
+
+        Document document;
+        document.path = path;
+        document.name = config.readEntry("Name");
+        document.icon = config.readEntry("Icon");
+        document.key = path.toCaseFolded();
+        document.modified = modified;
+        documents << document;
+    }
+
+    QMutexLocker lock(&m_documentsMutex);
+    m_documents = documents;
 }
 
 
 void RecentDocuments::match(Plasma::RunnerContext &context)
 {
-    if (m_recentdocuments.isEmpty()) {
-        return;
-    }
-
     const QString term = context.query();
     if (term.length() < 3) {
         return;
     }
 
-    foreach (const QString &document, m_recentdocuments) {
+    QList<Document> documents;
+    {
+        QMutexLocker lock(&m_documentsMutex);
+        documents = m_documents;
+    }
+
+    const QString key = term.toCaseFolded();
+    foreach (const Document &document, documents) {
         if (!context.isValid()) {
             return;
         }
 
-        if (document.contains(term, Qt::CaseInsensitive)) {
-            KConfig _config( document, KConfig::SimpleConfig );
-            KConfigGroup config(&_config, "Desktop Entry" );
-            QString niceName =  config.readEntry( "Name" );
+        if (document.key.contains(key)) {
             Plasma::QueryMatch match(this);
             match.setType(Plasma::QueryMatch::PossibleMatch);
             match.setRelevance(1.0);
-            match.setIcon(KIcon(config.readEntry("Icon")));
-            match.setData(document); // TODO: Read URL[$e], or can we just pass the path to the .desktop file?
-            match.setText(niceName);
+            match.setIcon(KIcon(document.icon));
+            match.setData(document.path); // TODO: Read URL[$e], or can we just pass the path to the .desktop file?
+            match.setText(document.name);
             match.setSubtext(i18n("Recent Document"));
             context.addMatch(term, match);
         }
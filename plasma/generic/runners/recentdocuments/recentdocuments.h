@@ -20,6 +20,9 @@
 #ifndef RECENTDOCUMENTS_H
 #define RECENTDOCUMENTS_H
 
+#include <QDateTime>
+#include <QMutex>
+
 #include <Plasma/AbstractRunner>
 
 #include <KIcon>
@@ -41,8 +44,19 @@ class RecentDocuments : public Plasma::AbstractRunner {
         void loadRecentDocuments();
 
     private:
+        struct Document {
+            QString path;
+            QString name;
+            QString icon;
+            // the case folded path, which is matched against
+            QString key;
+            QDateTime modified;
+        };
+
         KIcon m_icon;
-        QStringList m_recentdocuments;
+        QMutex m_documentsMutex;
+        // parsed when the recent documents change, not while typing
+        QList<Document> m_documents;
 };
 
 K_EXPORT_PLASMA_RUNNER(recentdocuments, RecentDocuments)
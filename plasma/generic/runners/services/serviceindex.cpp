@@ -0,0 +1,231 @@
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#include "serviceindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include <KServiceTypeTrader>
+
+#include <Plasma/RunnerContext>
+
+static quint64 trigram(const QChar *c)
+{
+    return (quint64(c[0].unicode()) << 32) | (quint64(c[1].unicode()) << 16) | quint64(c[2].unicode());
+}
+
+static void addTrigrams(QHash<quint64, QVector<int> > &postings, const QString &text, int index)
+{
+    const QChar *c = text.constData();
+    for (int i = 0; i + 3 <= text.length(); ++i) {
+        QVector<int> &posting = postings[trigram(c + i)];
+        // entries are added in index order, so the postings stay sorted
+        if (posting.isEmpty() || posting.last() != index) {
+            posting.append(index);
+        }
+    }
+}
+
+static bool lessBySize(const QVector<int> *left, const QVector<int> *right)
+{
+    return left->count() < right->count();
+}
+
+static QVector<int> intersectPostings(const QHash<quint64, QVector<int> > &postings,
+                                      const QString &foldedTerm,
+                                      const Plasma::RunnerContext &context)
+{
+    QVector<const QVector<int> *> lists;
+    const QChar *c = foldedTerm.constData();
+    for (int i = 0; i + 3 <= foldedTerm.length(); ++i) {
+        QHash<quint64, QVector<int> >::const_iterator it = postings.constFind(trigram(c + i));
+        if (it == postings.constEnd()) {
+            return QVector<int>();
+        }
+        lists.append(&it.value());
+    }
+
+    // starting with the shortest posting keeps the intermediate results small
+    qSort(lists.begin(), lists.end(), lessBySize);
+
+    QVector<int> result = *lists.first();
+    for (int i = 1; i < lists.count() && !result.isEmpty(); ++i) {
+        if (!context.isValid()) {
+            return QVector<int>();
+        }
+
+        QVector<int> intersection;
+        std::set_intersection(result.constBegin(), result.constEnd(),
+                              lists.at(i)->constBegin(), lists.at(i)->constEnd(),
+                              std::back_inserter(intersection));
+        result = intersection;
+    }
+
+    return result;
+}
+
+static bool containsFolded(const ServiceIndex::Entry &entry, const QString &foldedTerm, ServiceIndex::Fields fields)
+{
+    if ((fields & ServiceIndex::NameField) && entry.name.contains(foldedTerm)) {
+        return true;
+    }
+
+    if ((fields & ServiceIndex::GenericNameField) && entry.genericName.contains(foldedTerm)) {
+        return true;
+    }
+
+    if ((fields & ServiceIndex::ExecField) && entry.exec.contains(foldedTerm)) {
+        return true;
+    }
+
+    if (fields & ServiceIndex::KeywordsField) {
+        foreach (const QString &keyword, entry.keywords) {
+            if (keyword.contains(foldedTerm)) {
+                return true;
+            }
+        }
+    }
+
+    if (fields & ServiceIndex::CategoriesField) {
+        foreach (const QString &category, entry.categories) {
+            if (category.contains(foldedTerm)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static QStringList caseFolded(const QStringList &list)
+{
+    QStringList result;
+    result.reserve(list.count());
+    foreach (const QString &item, list) {
+        result << item.toCaseFolded();
+    }
+    return result;
+}
+
+ServiceIndex::ServiceIndex()
+{
+    const KService::List applications = KServiceTypeTrader::self()->query("Application");
+    const KService::List modules = KServiceTypeTrader::self()->query("KCModule");
+    m_entries.reserve(applications.count() + modules.count());
+
+    KService::List services = applications + modules;
+    for (int i = 0; i < services.count(); ++i) {
+        const KService::Ptr &service = services.at(i);
+        // nothing which is hidden or can not be run is ever matched
+        if (service->noDisplay() || service->exec().isEmpty()) {
+            continue;
+        }
+
+        Entry entry;
+        entry.service = service;
+        entry.application = i < applications.count();
+        entry.name = service->name().toCaseFolded();
+        entry.genericName = service->genericName().toCaseFolded();
+        entry.keywords = caseFolded(service->keywords());
+        entry.exec = service->exec().toCaseFolded();
+        entry.categories = caseFolded(service->categories());
+
+        const int index = m_entries.count();
+        addTrigrams(m_textPostings, entry.name, index);
+        addTrigrams(m_textPostings, entry.genericName, index);
+        foreach (const QString &keyword, entry.keywords) {
+            addTrigrams(m_textPostings, keyword, index);
+        }
+        addTrigrams(m_textPostings, entry.exec, index);
+        foreach (const QString &category, entry.categories) {
+            addTrigrams(m_categoryPostings, category, index);
+        }
+
+        if (entry.application) {
+            m_names[entry.name].append(index);
+        }
+
+        m_entries.append(entry);
+    }
+}
+
+int ServiceIndex::count() const
+{
+    return m_entries.count();
+}
+
+const ServiceIndex::Entry &ServiceIndex::entry(int index) const
+{
+    return m_entries.at(index);
+}
+
+QVector<int> ServiceIndex::exactNameMatches(const QString &term) const
+{
+    return m_names.value(term.toCaseFolded());
+}
+
+QVector<int> ServiceIndex::matches(const QString &term, Fields fields, const Plasma::RunnerContext &context) const
+{
+    const QString foldedTerm = term.toCaseFolded();
+    QVector<int> result;
+
+    if (foldedTerm.length() < 3) {
+        // too short for the trigrams, but also cheap to compare
+        for (int i = 0; i < m_entries.count(); ++i) {
+            if (!context.isValid()) {
+                return QVector<int>();
+            }
+
+            if (containsFolded(m_entries.at(i), foldedTerm, fields)) {
+                result.append(i);
+            }
+        }
+        return result;
+    }
+
+    QVector<int> candidates;
+    if (fields & ~CategoriesField) {
+        candidates = intersectPostings(m_textPostings, foldedTerm, context);
+    }
+
+    if (fields & CategoriesField) {
+        const QVector<int> categoryCandidates = intersectPostings(m_categoryPostings, foldedTerm, context);
+        QVector<int> merged;
+        std::set_union(candidates.constBegin(), candidates.constEnd(),
+                       categoryCandidates.constBegin(), categoryCandidates.constEnd(),
+                       std::back_inserter(merged));
+        candidates = merged;
+    }
+
+    // the trigrams only narrow the candidates down, they do not have to be adjacent
+    foreach (int i, candidates) {
+        if (!context.isValid()) {
+            return QVector<int>();
+        }
+
+        if (containsFolded(m_entries.at(i), foldedTerm, fields)) {
+            result.append(i);
+        }
+    }
+
+    return result;
+}
+
+bool ServiceIndex::contains(int index, const QString &term, Fields fields) const
+{
+    return containsFolded(m_entries.at(index), term.toCaseFolded(), fields);
+}
@@ -0,0 +1,102 @@
+/*
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Library General Public License version 2 as
+ *   published by the Free Software Foundation
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details
+ *
+ *   You should have received a copy of the GNU Library General Public
+ *   License along with this program; if not, write to the
+ *   Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+
+#ifndef SERVICEINDEX_H
+#define SERVICEINDEX_H
+
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+#include <KService>
+
+namespace Plasma
+{
+    class RunnerContext;
+}
+
+/**
+ * An immutable index over the displayable applications and control modules
+ * known to KSycoca, so that matching a query does not have to evaluate trader
+ * constraints over the whole database on every keypress.
+ *
+ * All fields are stored case folded. Substring lookups of three or more
+ * characters are answered from trigram postings, shorter terms by comparing
+ * every entry.
+ * Entries keep the order of the trader queries: the applications first,
+ * followed by the control modules.
+ */
+class ServiceIndex
+{
+    public:
+        enum Field {
+            NameField = 1,
+            GenericNameField = 2,
+            KeywordsField = 4,
+            ExecField = 8,
+            CategoriesField = 16
+        };
+        Q_DECLARE_FLAGS(Fields, Field)
+
+        struct Entry {
+            KService::Ptr service;
+            bool application;
+            QString name;
+            QString genericName;
+            QStringList keywords;
+            QString exec;
+            QStringList categories;
+        };
+
+        /**
+         * Builds the index from the current KSycoca database.
+         */
+        ServiceIndex();
+
+        int count() const;
+        const Entry &entry(int index) const;
+
+        /**
+         * @returns the applications whose Name equals @p term, ignoring case.
+         */
+        QVector<int> exactNameMatches(const QString &term) const;
+
+        /**
+         * @returns the entries of which one of @p fields contains @p term,
+         * ignoring case, in index order. The lookup is abandoned and an empty
+         * list is returned as soon as @p context becomes invalid.
+         */
+        QVector<int> matches(const QString &term, Fields fields, const Plasma::RunnerContext &context) const;
+
+        /**
+         * @returns true if one of @p fields of the entry at @p index contains
+         * @p term, ignoring case.
+         */
+        bool contains(int index, const QString &term, Fields fields) const;
+
+    private:
+        typedef QHash<quint64, QVector<int> > Postings;
+
+        QVector<Entry> m_entries;
+        QHash<QString, QVector<int> > m_names;
+        // trigrams of Name, GenericName, Keywords and Exec
+        Postings m_textPostings;
+        Postings m_categoryPostings;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(ServiceIndex::Fields)
+
+#endif
@@ -25,7 +25,7 @@
 #include <KLocale>
 #include <KRun>
 #include <KService>
-#include <KServiceTypeTrader>
+#include <KSycoca>
 #include <KUrl>
 
 ServiceRunner::ServiceRunner(QObject *parent, const QVariantList &args)
@@ -37,6 +37,8 @@ ServiceRunner::ServiceRunner(QObject *parent, const QVariantList &args)
     setPriority(AbstractRunner::HighestPriority);
 
     addSyntax(Plasma::RunnerSyntax(":q:", i18n("Finds applications whose name or description match :q:")));
+
+    connect(KSycoca::self(), SIGNAL(databaseChanged(QStringList)), this, SLOT(sycocaChanged(QStringList)));
 }
 
 ServiceRunner::~ServiceRunner()
@@ -46,30 +48,27 @@ ServiceRunner::~ServiceRunner()
 void ServiceRunner::match(Plasma::RunnerContext &context)
 {
     const QString term = context.query();
+    // the generations have to be taken before the index they refer to
+    const int textGeneration = m_textCandidates.generation();
+    const int categoryGeneration = m_categoryCandidates.generation();
+    const QSharedPointer<const ServiceIndex> index = serviceIndex();
 
     QList<Plasma::QueryMatch> matches;
     QSet<QString> seen;
-    QString query;
 
     if (term.length() > 1) {
         // Search for applications which are executable and case-insensitively match the search term
-        // See http://techbase.kde.org/Development/Tutorials/Services/Traders#The_KTrader_Query_Language
-        // if the following is unclear to you.
-        query = QString("exist Exec and ('%1' =~ Name)").arg(term);
-        KService::List services = KServiceTypeTrader::self()->query("Application", query);
-
-        if (!services.isEmpty()) {
-            //kDebug() << service->name() << "is an exact match!" << service->storageId() << service->exec();
-            foreach (const KService::Ptr &service, services) {
-                if (!service->noDisplay() && service->property("NotShowIn", QVariant::String) != "KDE") {
-                    Plasma::QueryMatch match(this);
-                    match.setType(Plasma::QueryMatch::ExactMatch);
-                    setupMatch(service, match);
-                    match.setRelevance(1);
-                    matches << match;
-                    seen.insert(service->storageId());
-                    seen.insert(service->exec());
-                }
+        foreach (int i, index->exactNameMatches(term)) {
+            const KService::Ptr &service = index->entry(i).service;
+            if (service->property("NotShowIn", QVariant::String) != "KDE") {
+                //kDebug() << service->name() << "is an exact match!" << service->storageId() << service->exec();
+                Plasma::QueryMatch match(this);
+                match.setType(Plasma::QueryMatch::ExactMatch);
+                setupMatch(service, match);
+                match.setRelevance(1);
+                matches << match;
+                seen.insert(service->storageId());
+                seen.insert(service->exec());
             }
         }
     }
@@ -78,32 +77,30 @@ void ServiceRunner::match(Plasma::RunnerContext &context)
         return;
     }
 
-    // If the term length is < 3, no real point searching the Keywords and GenericName
+    QVector<int> candidates;
     if (term.length() < 3) {
-        query = QString("exist Exec and ( (exist Name and '%1' ~~ Name) or ('%1' ~~ Exec) )").arg(term);
+        // If the term length is < 3, no real point searching the Keywords and GenericName.
+        // All Name and Exec hits are still seen below, so that they do not come back as
+        // category matches.
+        candidates = index->matches(term, ServiceIndex::NameField | ServiceIndex::ExecField, context);
     } else {
         // Search for applications which are executable and the term case-insensitive matches any of
         // * a substring of one of the keywords
         // * a substring of the GenericName field
         // * a substring of the Name field
-        // Note that before asking for the content of e.g. Keywords and GenericName we need to ask if
-        // they exist to prevent a tree evaluation error if they are not defined.
-        query = QString("exist Exec and ( (exist Keywords and '%1' ~subin Keywords) or (exist GenericName and '%1' ~~ GenericName) or (exist Name and '%1' ~~ Name) or ('%1' ~~ Exec) )").arg(term);
+        // * a substring of the Exec field
+        candidates = refinedMatches(*index, m_textCandidates, textGeneration, term,
+                                    ServiceIndex::KeywordsField | ServiceIndex::GenericNameField |
+                                    ServiceIndex::NameField | ServiceIndex::ExecField, context);
     }
 
-    KService::List services = KServiceTypeTrader::self()->query("Application", query);
-    services += KServiceTypeTrader::self()->query("KCModule", query);
-
-    //kDebug() << "got " << services.count() << " services from " << query;
-    foreach (const KService::Ptr &service, services) {
+    //kDebug() << "got " << candidates.count() << " services from the index";
+    foreach (int i, candidates) {
         if (!context.isValid()) {
             return;
         }
 
-        if (service->noDisplay()) {
-            continue;
-        }
-
+        const KService::Ptr &service = index->entry(i).service;
         const QString id = service->storageId();
         const QString name = service->desktopEntryName();
         const QString exec = service->exec();
@@ -172,44 +169,98 @@ void ServiceRunner::match(Plasma::RunnerContext &context)
     }
 
     //search for applications whose categories contains the query
-    query = QString("exist Exec and (exist Categories and '%1' ~subin Categories)").arg(term);
-    services = KServiceTypeTrader::self()->query("Application", query);
-
-    //kDebug() << service->name() << "is an exact match!" << service->storageId() << service->exec();
-    foreach (const KService::Ptr &service, services) {
+    const QVector<int> categoryCandidates = refinedMatches(*index, m_categoryCandidates, categoryGeneration,
+                                                           term, ServiceIndex::CategoriesField, context);
+    foreach (int i, categoryCandidates) {
         if (!context.isValid()) {
             return;
         }
 
-        if (!service->noDisplay()) {
-            QString id = service->storageId();
-            QString exec = service->exec();
-            if (seen.contains(id) || seen.contains(exec)) {
-                //kDebug() << "already seen" << id << exec;
-                continue;
-            }
-            Plasma::QueryMatch match(this);
-            match.setType(Plasma::QueryMatch::PossibleMatch);
-            setupMatch(service, match);
-
-            qreal relevance = 0.6;
-            if (service->categories().contains("X-KDE-More") ||
-                    !service->showInKDE()) {
-                relevance = 0.5;
-            }
+        const ServiceIndex::Entry &entry = index->entry(i);
+        if (!entry.application) {
+            continue;
+        }
 
-            if (service->isApplication()) {
-                relevance += .4;
-            }
+        const KService::Ptr &service = entry.service;
+        QString id = service->storageId();
+        QString exec = service->exec();
+        if (seen.contains(id) || seen.contains(exec)) {
+            //kDebug() << "already seen" << id << exec;
+            continue;
+        }
+        Plasma::QueryMatch match(this);
+        match.setType(Plasma::QueryMatch::PossibleMatch);
+        setupMatch(service, match);
 
-            match.setRelevance(relevance);
-            matches << match;
+        qreal relevance = 0.6;
+        if (service->categories().contains("X-KDE-More") ||
+                !service->showInKDE()) {
+            relevance = 0.5;
         }
+
+        if (service->isApplication()) {
+            relevance += .4;
+        }
+
+        match.setRelevance(relevance);
+        matches << match;
     }
 
     context.addMatches(term, matches);
 }
 
+QSharedPointer<const ServiceIndex> ServiceRunner::serviceIndex()
+{
+    // matches run in several threads at once, each of them keeps using the
+    // index it started with even if it is replaced meanwhile
+    QMutexLocker lock(&m_indexMutex);
+    if (!m_index) {
+        m_index = QSharedPointer<const ServiceIndex>(new ServiceIndex);
+    }
+
+    return m_index;
+}
+
+QVector<int> ServiceRunner::refinedMatches(const ServiceIndex &index, QueryRefinementCache<int> &cache, int generation,
+                                          const QString &term, ServiceIndex::Fields fields,
+                                          const Plasma::RunnerContext &context)
+{
+    const QString key = term.toCaseFolded();
+    QVector<int> result;
+    QList<int> previous;
+    if (cache.refine(key, previous, generation)) {
+        // the query extends an earlier one, its candidates only need to be filtered
+        foreach (int i, previous) {
+            if (!context.isValid()) {
+                return QVector<int>();
+            }
+
+            if (index.contains(i, term, fields)) {
+                result << i;
+            }
+        }
+    } else {
+        result = index.matches(term, fields, context);
+    }
+
+    // an aborted lookup is not complete
+    if (context.isValid()) {
+        cache.insert(key, result.toList(), generation);
+    }
+
+    return result;
+}
+
+void ServiceRunner::sycocaChanged(const QStringList &changes)
+{
+    if (changes.contains("services") || changes.contains("apps")) {
+        QMutexLocker lock(&m_indexMutex);
+        m_index.clear();
+        m_textCandidates.invalidate();
+        m_categoryCandidates.invalidate();
+    }
+}
+
 void ServiceRunner::run(const Plasma::RunnerContext &context, const Plasma::QueryMatch &match)
 {
     Q_UNUSED(context);
@@ -20,10 +20,16 @@
 #define SERVICERUNNER_H
 
 
+#include <QMutex>
+#include <QSharedPointer>
+
 #include <KService>
 
 #include <Plasma/AbstractRunner>
 
+#include "queryrefinementcache.h"
+#include "serviceindex.h"
+
 
 /**
  * This class looks for matches in the set of .desktop files installed by
@@ -46,8 +52,24 @@ class ServiceRunner : public Plasma::AbstractRunner
     protected slots:
         QMimeData * mimeDataForMatch(const Plasma::QueryMatch *match);
 
+    private slots:
+        void sycocaChanged(const QStringList &changes);
+
     protected:
         void setupMatch(const KService::Ptr &service, Plasma::QueryMatch &action);
+
+    private:
+        QSharedPointer<const ServiceIndex> serviceIndex();
+        QVector<int> refinedMatches(const ServiceIndex &index, QueryRefinementCache<int> &cache, int generation,
+                                    const QString &term, ServiceIndex::Fields fields,
+                                    const Plasma::RunnerContext &context);
+
+        QMutex m_indexMutex;
+        // built on demand, dropped when the installed services change
+        QSharedPointer<const ServiceIndex> m_index;
+        // entries of m_index matching the last queries
+        QueryRefinementCache<int> m_textCandidates;
+        QueryRefinementCache<int> m_categoryCandidates;
 };
 
 K_EXPORT_PLASMA_RUNNER(services, ServiceRunner)
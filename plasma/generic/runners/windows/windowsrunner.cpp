@@ -31,7 +31,6 @@
 
 WindowsRunner::WindowsRunner(QObject* parent, const QVariantList& args)
     : AbstractRunner(parent, args),
-      m_inSession(false),
       m_ready(false)
 {
     Q_UNUSED(args)
@@ -53,8 +52,15 @@ WindowsRunner::WindowsRunner(QObject* parent, const QVariantList& args)
     addSyntax(Plasma::RunnerSyntax(i18nc("Note this is a KRunner keyword", "desktop"),
                                    i18n("Lists all other desktops and allows to switch to them.")));
 
-    connect(this, SIGNAL(prepare()), this, SLOT(prepareForMatchSession()));
-    connect(this, SIGNAL(teardown()), this, SLOT(matchSessionComplete()));
+    // the windows are tracked from now on, so that starting a match session
+    // does not have to ask the X server about every window again
+    connect(KWindowSystem::self(), SIGNAL(windowAdded(WId)), this, SLOT(windowAdded(WId)));
+    connect(KWindowSystem::self(), SIGNAL(windowRemoved(WId)), this, SLOT(windowRemoved(WId)));
+    connect(KWindowSystem::self(), SIGNAL(windowChanged(WId,const ulong*)),
+            this, SLOT(windowChanged(WId,const ulong*)));
+    connect(KWindowSystem::self(), SIGNAL(numberOfDesktopsChanged(int)), this, SLOT(desktopsChanged()));
+    connect(KWindowSystem::self(), SIGNAL(desktopNamesChanged()), this, SLOT(desktopsChanged()));
+    QTimer::singleShot(0, this, SLOT(gatherInfo()));
 }
 
 WindowsRunner::~WindowsRunner()
@@ -63,57 +69,131 @@ WindowsRunner::~WindowsRunner()
 
 void WindowsRunner::gatherInfo()
 {
-    if (!m_inSession) {
-        return;
+    foreach (const WId w, KWindowSystem::windows()) {
+        updateWindow(w, true);
     }
 
-    foreach (const WId w, KWindowSystem::windows()) {
-        KWindowInfo info = KWindowSystem::windowInfo(w, NET::WMWindowType | NET::WMDesktop |
-                                                        NET::WMState | NET::XAWMState |
-                                                        NET::WMName,
-                                                    NET::WM2WindowClass | NET::WM2WindowRole | NET::WM2AllowedActions);
-        if (info.valid()) {
-            // ignore NET::Tool and other special window types
-            NET::WindowType wType = info.windowType(NET::NormalMask | NET::DesktopMask | NET::DockMask |
-                                                    NET::ToolbarMask | NET::MenuMask | NET::DialogMask |
-                                                    NET::OverrideMask | NET::TopMenuMask |
-                                                    NET::UtilityMask | NET::SplashMask);
-
-            if (wType != NET::Normal && wType != NET::Override && wType != NET::Unknown &&
-                wType != NET::Dialog && wType != NET::Utility) {
-                continue;
-            }
-            m_windows.insert(w, info);
-            m_icons.insert(w, QIcon(KWindowSystem::icon(w)));
-        }
+    desktopsChanged();
+
+    QMutexLocker lock(&m_windowsMutex);
+    m_ready = true;
+}
+
+void WindowsRunner::windowAdded(WId w)
+{
+    updateWindow(w, true);
+}
+
+void WindowsRunner::windowRemoved(WId w)
+{
+    QMutexLocker lock(&m_windowsMutex);
+    m_windows.remove(w);
+}
+
+void WindowsRunner::windowChanged(WId w, const unsigned long *properties)
+{
+#ifdef Q_WS_X11
+    // most changes, e.g. of the geometry, do not concern the runner
+    if (!(properties[NETWinInfo::PROTOCOLS] & (NET::WMWindowType | NET::WMDesktop | NET::WMName |
+                                               NET::WMVisibleName | NET::WMIcon)) &&
+        !(properties[NETWinInfo::PROTOCOLS2] & (NET::WM2WindowClass | NET::WM2WindowRole | NET::WM2AllowedActions))) {
+        return;
     }
 
+    updateWindow(w, properties[NETWinInfo::PROTOCOLS] & NET::WMIcon);
+#else
+    Q_UNUSED(properties)
+    updateWindow(w, true);
+#endif
+}
+
+void WindowsRunner::desktopsChanged()
+{
+    QStringList desktopNames;
     for (int i=1; i<=KWindowSystem::numberOfDesktops(); i++) {
-        m_desktopNames << KWindowSystem::desktopName(i);
+        desktopNames << KWindowSystem::desktopName(i);
     }
 
-    m_ready = true;
+    QMutexLocker lock(&m_windowsMutex);
+    m_desktopNames = desktopNames;
 }
 
-void WindowsRunner::prepareForMatchSession()
+void WindowsRunner::updateWindow(WId w, bool updateIcon)
 {
-    m_inSession = true;
-    m_ready = false;
-    QTimer::singleShot(0, this, SLOT(gatherInfo()));
+    KWindowInfo info = KWindowSystem::windowInfo(w, NET::WMWindowType | NET::WMDesktop | NET::WMName,
+                                                 NET::WM2WindowClass | NET::WM2WindowRole | NET::WM2AllowedActions);
+    if (!info.valid()) {
+        windowRemoved(w);
+        return;
+    }
+
+    // ignore NET::Tool and other special window types
+    NET::WindowType wType = info.windowType(NET::NormalMask | NET::DesktopMask | NET::DockMask |
+                                            NET::ToolbarMask | NET::MenuMask | NET::DialogMask |
+                                            NET::OverrideMask | NET::TopMenuMask |
+                                            NET::UtilityMask | NET::SplashMask);
+
+    if (wType != NET::Normal && wType != NET::Override && wType != NET::Unknown &&
+        wType != NET::Dialog && wType != NET::Utility) {
+        windowRemoved(w);
+        return;
+    }
+
+    Window window;
+    window.id = w;
+    window.name = info.name();
+    window.desktop = info.desktop();
+    window.actions = 0;
+    for (int action = ActivateAction; action <= KeepBelowAction; ++action) {
+        if (actionSupported(info, WindowAction(action))) {
+            window.actions |= 1 << action;
+        }
+    }
+
+    const QString className = QString::fromUtf8(info.windowClassName());
+    window.nameKey = window.name.toCaseFolded();
+    window.classNameKey = className.toCaseFolded();
+    window.classKey = (className + " " + QString::fromUtf8(info.windowClassClass())).toCaseFolded();
+    window.roleKey = QString::fromUtf8(info.windowRole()).toCaseFolded();
+
+    if (!updateIcon) {
+        QMutexLocker lock(&m_windowsMutex);
+        QHash<WId, Window>::const_iterator it = m_windows.constFind(w);
+        if (it != m_windows.constEnd()) {
+            window.icon = it->icon;
+        } else {
+            updateIcon = true;
+        }
+    }
+
+    if (updateIcon) {
+        window.icon = QIcon(KWindowSystem::icon(w));
+    }
+
+    QMutexLocker lock(&m_windowsMutex);
+    m_windows.insert(w, window);
 }
 
-void WindowsRunner::matchSessionComplete()
+QString WindowsRunner::desktopName(int desktop) const
 {
-    m_inSession = false;
-    m_ready = false;
-    m_desktopNames.clear();
-    m_icons.clear();
-    m_windows.clear();
+    QMutexLocker lock(&m_windowsMutex);
+    if (desktop >= 1 && desktop <= m_desktopNames.size()) {
+        return m_desktopNames[desktop - 1];
+    }
+
+    return KWindowSystem::desktopName(desktop);
 }
 
 void WindowsRunner::match(Plasma::RunnerContext& context)
 {
-    if (!m_ready) {
+    // the matching threads work on their own copy of the table
+    m_windowsMutex.lock();
+    const bool ready = m_ready;
+    const QHash<WId, Window> windows = m_windows;
+    const QStringList desktopNames = m_desktopNames;
+    m_windowsMutex.unlock();
+
+    if (!ready) {
         return;
     }
 
@@ -179,7 +259,7 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
             } else if (keyword.startsWith(i18nc("Note this is a KRunner keyword", "desktop") + "=" , Qt::CaseInsensitive)) {
                 bool ok;
                 desktop = keyword.split("=")[1].toInt(&ok);
-                if (!ok || desktop > KWindowSystem::numberOfDesktops()) {
+                if (!ok || desktop > desktopNames.count()) {
                     desktop = -1; // sanity check
                 }
             } else {
@@ -190,42 +270,36 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
                 }
             }
         }
-        QHashIterator<WId, KWindowInfo> it(m_windows);
-        while(it.hasNext()) {
-            it.next();
-            WId w = it.key();
-            KWindowInfo info = it.value();
-            QString windowClassCompare = QString::fromUtf8(info.windowClassName()) + " " +
-                                         QString::fromUtf8(info.windowClassClass());
+        windowName = windowName.toCaseFolded();
+        windowClass = windowClass.toCaseFolded();
+        windowRole = windowRole.toCaseFolded();
+        const QString test = term.mid(keywords[0].length() + 1).toCaseFolded();
+        foreach (const Window& window, windows) {
             // exclude not matching windows
-            if (!KWindowSystem::hasWId(w)) {
+            if (!windowName.isEmpty() && !window.nameKey.contains(windowName)) {
                 continue;
             }
-            if (!windowName.isEmpty() && !info.name().contains(windowName, Qt::CaseInsensitive)) {
+            if (!windowClass.isEmpty() && !window.classKey.contains(windowClass)) {
                 continue;
             }
-            if (!windowClass.isEmpty() && !windowClassCompare.contains(windowClass, Qt::CaseInsensitive)) {
+            if (!windowRole.isEmpty() && !window.roleKey.contains(windowRole)) {
                 continue;
             }
-            if (!windowRole.isEmpty() && !QString::fromUtf8(info.windowRole()).contains(windowRole, Qt::CaseInsensitive)) {
-                continue;
-            }
-            if (desktop != -1 && !info.isOnDesktop(desktop)) {
+            if (desktop != -1 && !isOnDesktop(window, desktop)) {
                 continue;
             }
             // check for windows when no keywords were used
             // check the name, class and role for containing the query without the keyword
             if (windowName.isEmpty() && windowClass.isEmpty() && windowRole.isEmpty() && desktop == -1) {
-                const QString& test = term.mid(keywords[0].length() + 1);
-                if (!info.name().contains(test, Qt::CaseInsensitive) &&
-                    !windowClassCompare.contains(test, Qt::CaseInsensitive) &&
-                    !QString::fromUtf8(info.windowRole()).contains(test, Qt::CaseInsensitive)) {
+                if (!window.nameKey.contains(test) &&
+                    !window.classKey.contains(test) &&
+                    !window.roleKey.contains(test)) {
                     continue;
                 }
             }
             // blacklisted everything else: we have a match
-            if (actionSupported(info, action)){
-                matches << windowMatch(info, action);
+            if (actionSupported(window, action)){
+                matches << windowMatch(window, action);
             }
         }
 
@@ -242,7 +316,7 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
         const QStringList parts = term.split(" ");
         if (parts.size() == 1) {
             // only keyword - list all desktops
-            for (int i=1; i<=KWindowSystem::numberOfDesktops(); i++) {
+            for (int i=1; i<=desktopNames.count(); i++) {
                 if (i == KWindowSystem::currentDesktop()) {
                     continue;
                 }
@@ -261,29 +335,22 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
     }
 
     // check for matches without keywords
-    QHashIterator<WId, KWindowInfo> it(m_windows);
-    while (it.hasNext()) {
-        it.next();
-        WId w = it.key();
-        if (!KWindowSystem::hasWId(w)) {
-            continue;
-        }
+    const QString foldedTerm = term.toCaseFolded();
+    foreach (const Window& window, windows) {
         // check if window name, class or role contains the query
-        KWindowInfo info = it.value();
-        QString className = QString::fromUtf8(info.windowClassName());
-        if (info.name().startsWith(term, Qt::CaseInsensitive) ||
-            className.startsWith(term, Qt::CaseInsensitive)) {
-            matches << windowMatch(info, action, 0.8, Plasma::QueryMatch::ExactMatch);
-        } else if ((info.name().contains(term, Qt::CaseInsensitive) ||
-             className.contains(term, Qt::CaseInsensitive)) && 
-            actionSupported(info, action)) {
-            matches << windowMatch(info, action, 0.7, Plasma::QueryMatch::PossibleMatch);
+        if (window.nameKey.startsWith(foldedTerm) ||
+            window.classNameKey.startsWith(foldedTerm)) {
+            matches << windowMatch(window, action, 0.8, Plasma::QueryMatch::ExactMatch);
+        } else if ((window.nameKey.contains(foldedTerm) ||
+             window.classNameKey.contains(foldedTerm)) &&
+            actionSupported(window, action)) {
+            matches << windowMatch(window, action, 0.7, Plasma::QueryMatch::PossibleMatch);
         }
     }
 
     // check for matching desktops by name
-    foreach (const QString& desktopName, m_desktopNames) {
-        int desktop = m_desktopNames.indexOf(desktopName) +1;
+    foreach (const QString& desktopName, desktopNames) {
+        int desktop = desktopNames.indexOf(desktopName) +1;
         if (desktopName.contains(term, Qt::CaseInsensitive)) {
             // desktop name matches - offer switch to
             // only add desktops if it hasn't been added by the keyword which is quite likely
@@ -292,12 +359,9 @@ void WindowsRunner::match(Plasma::RunnerContext& context)
             }
 
             // search for windows on desktop and list them with less relevance
-            QHashIterator<WId, KWindowInfo> it(m_windows);
-            while (it.hasNext()) {
-                it.next();
-                KWindowInfo info = it.value();
-                if (info.isOnDesktop(desktop) && actionSupported(info, action)) {
-                    matches << windowMatch(info, action, 0.5, Plasma::QueryMatch::PossibleMatch);
+            foreach (const Window& window, windows) {
+                if (isOnDesktop(window, desktop) && actionSupported(window, action)) {
+                    matches << windowMatch(window, action, 0.5, Plasma::QueryMatch::PossibleMatch);
                 }
             }
         }
@@ -320,7 +384,8 @@ void WindowsRunner::run(const Plasma::RunnerContext& context, const Plasma::Quer
     const QStringList parts = match.data().toString().split("_");
     WindowAction action = WindowAction(parts[0].toInt());
     WId w = WId(parts[1].toULong());
-    KWindowInfo info = m_windows[w];
+    // the state is only needed now, so it is not tracked
+    KWindowInfo info = KWindowSystem::windowInfo(w, NET::WMState | NET::XAWMState);
     switch (action) {
     case ActivateAction:
         KWindowSystem::forceActiveWindow(w);
@@ -383,35 +448,24 @@ Plasma::QueryMatch WindowsRunner::desktopMatch(int desktop, qreal relevance)
     match.setData(desktop);
     match.setId("desktop-" + QString::number(desktop));
     match.setIcon(KIcon("user-desktop"));
-    QString desktopName;
-    if (desktop <= m_desktopNames.size()) {
-        desktopName = m_desktopNames[desktop - 1];
-    } else {
-        desktopName = KWindowSystem::desktopName(desktop);
-    }
-    match.setText(desktopName);
+    match.setText(desktopName(desktop));
     match.setSubtext(i18n("Switch to desktop %1", desktop));
     match.setRelevance(relevance);
     return match;
 }
 
-Plasma::QueryMatch WindowsRunner::windowMatch(const KWindowInfo& info, WindowAction action, qreal relevance, Plasma::QueryMatch::Type type)
+Plasma::QueryMatch WindowsRunner::windowMatch(const Window& window, WindowAction action, qreal relevance, Plasma::QueryMatch::Type type)
 {
     Plasma::QueryMatch match(this);
     match.setType(type);
-    match.setData(QString(QString::number((int)action) + "_" + QString::number(info.win())));
-    match.setIcon(m_icons[info.win()]);
-    match.setText(info.name());
-    QString desktopName;
-    int desktop = info.desktop();
+    match.setData(QString(QString::number((int)action) + "_" + QString::number(window.id)));
+    match.setIcon(window.icon);
+    match.setText(window.name);
+    int desktop = window.desktop;
     if (desktop == NET::OnAllDesktops) {
         desktop = KWindowSystem::currentDesktop();
     }
-    if (desktop <= m_desktopNames.size()) {
-        desktopName = m_desktopNames[desktop - 1];
-    } else {
-        desktopName = KWindowSystem::desktopName(desktop);
-    }
+    const QString desktopName = this->desktopName(desktop);
     switch (action) {
     case CloseAction:
         match.setSubtext(i18n("Close running window on %1", desktopName));
@@ -464,4 +518,14 @@ bool WindowsRunner::actionSupported(const KWindowInfo& info, WindowAction action
     }
 }
 
+bool WindowsRunner::actionSupported(const Window& window, WindowAction action)
+{
+    return window.actions & (1 << action);
+}
+
+bool WindowsRunner::isOnDesktop(const Window& window, int desktop)
+{
+    return window.desktop == NET::OnAllDesktops || window.desktop == desktop;
+}
+
 #include "windowsrunner.moc"
@@ -19,6 +19,9 @@
 #ifndef WINDOWSRUNNER_H
 #define WINDOWSRUNNER_H
 
+#include <QIcon>
+#include <QMutex>
+
 #include <Plasma/AbstractRunner>
 
 class KWindowInfo;
@@ -35,9 +38,11 @@ class WindowsRunner : public Plasma::AbstractRunner
         virtual void run(const Plasma::RunnerContext& context, const Plasma::QueryMatch& match);
 
     private Q_SLOTS:
-        void prepareForMatchSession();
-        void matchSessionComplete();
         void gatherInfo();
+        void windowAdded(WId w);
+        void windowRemoved(WId w);
+        void windowChanged(WId w, const unsigned long *properties);
+        void desktopsChanged();
 
     private:
         enum WindowAction {
@@ -50,17 +55,40 @@ class WindowsRunner : public Plasma::AbstractRunner
             KeepAboveAction,
             KeepBelowAction
         };
+
+        /**
+         * What is kept of a window between the match sessions, updated
+         * whenever KWindowSystem reports a change of the window.
+         */
+        struct Window {
+            WId id;
+            QString name;
+            QIcon icon;
+            // NET::OnAllDesktops for sticky windows
+            int desktop;
+            // one bit for each supported WindowAction
+            int actions;
+            // case folded keys the queries are compared with
+            QString nameKey;
+            QString classNameKey;
+            QString classKey;
+            QString roleKey;
+        };
+
+        void updateWindow(WId w, bool updateIcon);
+        QString desktopName(int desktop) const;
         Plasma::QueryMatch desktopMatch(int desktop, qreal relevance = 1.0);
-        Plasma::QueryMatch windowMatch(const KWindowInfo& info, WindowAction action, qreal relevance = 1.0,
+        Plasma::QueryMatch windowMatch(const Window& window, WindowAction action, qreal relevance = 1.0,
                                        Plasma::QueryMatch::Type type = Plasma::QueryMatch::ExactMatch);
-        bool actionSupported(const KWindowInfo& info, WindowAction action);
+        static bool actionSupported(const KWindowInfo& info, WindowAction action);
+        static bool actionSupported(const Window& window, WindowAction action);
+        static bool isOnDesktop(const Window& window, int desktop);
 
-        QHash<WId, KWindowInfo> m_windows;
-        QHash<WId, QIcon> m_icons;
+        // written in the main thread only, read by the matching threads
+        mutable QMutex m_windowsMutex;
+        QHash<WId, Window> m_windows;
         QStringList m_desktopNames;
-
-        bool m_inSession : 1;
-        bool m_ready : 1;
+        bool m_ready;
 };
 
 K_EXPORT_PLASMA_RUNNER(windows, WindowsRunner)